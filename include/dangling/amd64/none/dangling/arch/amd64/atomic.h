@@ -12,8 +12,12 @@
 
 #define LDG_FETCH_ADD(x, val) __atomic_fetch_add(&(x), (val), __ATOMIC_SEQ_CST)
 #define LDG_FETCH_SUB(x, val) __atomic_fetch_sub(&(x), (val), __ATOMIC_SEQ_CST)
+#define LDG_FETCH_ADD_RELAXED(x, val) __atomic_fetch_add(&(x), (val), __ATOMIC_RELAXED)
 #define LDG_ADD_FETCH(x, val) __atomic_add_fetch(&(x), (val), __ATOMIC_SEQ_CST)
 #define LDG_SUB_FETCH(x, val) __atomic_sub_fetch(&(x), (val), __ATOMIC_SEQ_CST)
+#define LDG_FETCH_OR(x, val) __atomic_fetch_or(&(x), (val), __ATOMIC_SEQ_CST)
+#define LDG_FETCH_AND(x, val) __atomic_fetch_and(&(x), (val), __ATOMIC_SEQ_CST)
+#define LDG_XCHG(x, val) __atomic_exchange_n(&(x), (val), __ATOMIC_SEQ_CST)
 
 #define LDG_CAS(ptr, expected, desired) __atomic_compare_exchange_n((ptr), (expected), (desired), 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)
 #define LDG_CAS_WEAK(ptr, expected, desired) __atomic_compare_exchange_n((ptr), (expected), (desired), 1, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)
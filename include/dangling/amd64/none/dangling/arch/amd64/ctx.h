@@ -0,0 +1,20 @@
+#ifndef LDG_ARCH_AMD64_CTX_H
+#define LDG_ARCH_AMD64_CTX_H
+
+#include <stdint.h>
+#include <dangling/core/macros.h>
+
+// a suspended context is just its stack pointer; the callee-saved registers, mxcsr and the x87
+// control word (plus xmm6-15 and the TIB stack bounds on windows) sit on the suspended stack
+typedef struct ldg_ctx
+{
+    void *sp;
+} ldg_ctx_t;
+
+typedef void (*ldg_ctx_func_t)(void *arg);
+
+// fn must never return; it leaves by swapping to another context
+LDG_EXPORT void ldg_ctx_make(ldg_ctx_t *ctx, void *stack_lo, uint64_t stack_size, ldg_ctx_func_t fn, void *arg);
+LDG_EXPORT void ldg_ctx_swap(ldg_ctx_t *from, const ldg_ctx_t *to);
+
+#endif
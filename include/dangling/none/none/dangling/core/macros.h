@@ -36,6 +36,8 @@
 #define LDG_ALIGNED_UP(x) (((uint64_t)(x) + (LDG_AMD64_CACHE_LINE_WIDTH - 1)) & ~(uint64_t)(LDG_AMD64_CACHE_LINE_WIDTH - 1))
 #define LDG_ALIGNED_DOWN(x) ((uint64_t)(x) & ~(uint64_t)(LDG_AMD64_CACHE_LINE_WIDTH - 1))
 
+#define LDG_CONTAINER_OF(ptr, type, member) ((type *)((uint8_t *)(ptr) - __builtin_offsetof(type, member)))
+
 #define LDG_BOOL_ASSERT(cond) do { if (LDG_UNLIKELY(!(cond))) { *(volatile uint8_t *)0x0 = 0; } } while (0)
 
 #ifdef _WIN32
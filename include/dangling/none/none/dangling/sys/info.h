@@ -4,10 +4,23 @@
 #include <stdint.h>
 #include <dangling/core/macros.h>
 
+#define LDG_SYS_CPU_MAX 1024
+
+typedef struct ldg_sys_cpu_topo
+{
+    uint32_t cpu_id;
+    uint32_t core_id;
+    uint32_t pkg_id;
+    uint32_t smt_idx;
+    uint8_t isolated;
+    uint8_t pudding[3];
+} ldg_sys_cpu_topo_t;
+
 LDG_EXPORT uint32_t ldg_sys_hostname_get(char *buff, uint64_t buff_size);
 LDG_EXPORT uint32_t ldg_sys_cpu_cunt_get(uint32_t *cunt);
 LDG_EXPORT uint32_t ldg_sys_page_size_get(uint64_t *size);
 LDG_EXPORT uint32_t ldg_sys_env_get(const char *name, char *buff, uint64_t buff_size);
 LDG_EXPORT uint32_t ldg_sys_pid_get(uint64_t *pid);
+LDG_EXPORT uint32_t ldg_sys_cpu_topo_get(ldg_sys_cpu_topo_t *out, uint32_t cap, uint32_t *cunt);
 
 #endif
@@ -0,0 +1,66 @@
+#ifndef LDG_THREAD_BCAST_H
+#define LDG_THREAD_BCAST_H
+
+#include <stdint.h>
+#include <dangling/core/macros.h>
+#include <dangling/thread/sync.h>
+
+#define LDG_BCAST_CONSUMER_MAX 16
+// pause rounds, then yields, before a SPIN_YIELD_PARK waiter sleeps
+#define LDG_BCAST_SPIN_CUNT 256
+#define LDG_BCAST_YIELD_CUNT 16
+
+// how a consumer waits for data and the producer waits for space. spin and yield never touch the
+// evcnt, so with either of them publish() and release() skip their notify fence as well
+typedef enum ldg_bcast_wait
+{
+    LDG_BCAST_WAIT_SPIN_YIELD_PARK = 0,
+    LDG_BCAST_WAIT_SPIN,
+    LDG_BCAST_WAIT_YIELD,
+    LDG_BCAST_WAIT_PARK
+} ldg_bcast_wait_t;
+
+// next sequence the consumer will read; written only by its owner
+typedef struct ldg_bcast_cursor
+{
+    uint64_t seq;
+    uint8_t pudding0[LDG_AMD64_CACHE_LINE_WIDTH - sizeof(uint64_t)];
+} LDG_ALIGNED ldg_bcast_cursor_t;
+
+// single producer, up to LDG_BCAST_CONSUMER_MAX consumers, each of which sees every item. items are written
+// once in place and read in place; a slot is reused only after the slowest consumer has released it
+typedef struct ldg_bcast
+{
+    uint8_t *buff;
+    uint64_t item_size;
+    uint64_t cap;
+    uint64_t mask;
+    uint32_t consumer_cunt;
+    uint32_t wait;
+    uint8_t pudding0[LDG_AMD64_CACHE_LINE_WIDTH - 4 * sizeof(uint64_t) - 2 * sizeof(uint32_t)];
+    // producer only: next sequence to claim, and the slowest cursor as last seen
+    uint64_t claim;
+    uint64_t gate;
+    uint8_t pudding1[LDG_AMD64_CACHE_LINE_WIDTH - 2 * sizeof(uint64_t)];
+    // every sequence below pub is readable
+    uint64_t pub;
+    uint8_t pudding2[LDG_AMD64_CACHE_LINE_WIDTH - sizeof(uint64_t)];
+    ldg_evcnt_t data_ec;
+    ldg_evcnt_t space_ec;
+    uint8_t pudding3[LDG_AMD64_CACHE_LINE_WIDTH - 2 * sizeof(ldg_evcnt_t)];
+    ldg_bcast_cursor_t cursors[LDG_BCAST_CONSUMER_MAX];
+} LDG_ALIGNED ldg_bcast_t;
+
+LDG_EXPORT uint32_t ldg_bcast_init(ldg_bcast_t *b, uint64_t item_size, uint64_t cap, uint32_t consumer_cunt, uint32_t wait);
+LDG_EXPORT uint32_t ldg_bcast_shutdown(ldg_bcast_t *b);
+LDG_EXPORT uint32_t ldg_bcast_claim(ldg_bcast_t *b, void **slot_out, uint64_t *seq_out);
+LDG_EXPORT uint32_t ldg_bcast_claim_wait(ldg_bcast_t *b, void **slot_out, uint64_t *seq_out, uint64_t timeout_ns);
+LDG_EXPORT uint32_t ldg_bcast_publish(ldg_bcast_t *b, uint64_t seq);
+LDG_EXPORT uint32_t ldg_bcast_push(ldg_bcast_t *b, const void *item);
+LDG_EXPORT uint32_t ldg_bcast_read(ldg_bcast_t *b, uint32_t consumer, uint64_t *seq_out, uint64_t *cunt_out);
+LDG_EXPORT uint32_t ldg_bcast_read_wait(ldg_bcast_t *b, uint32_t consumer, uint64_t *seq_out, uint64_t *cunt_out, uint64_t timeout_ns);
+LDG_EXPORT void* ldg_bcast_slot_get(const ldg_bcast_t *b, uint64_t seq);
+LDG_EXPORT uint32_t ldg_bcast_release(ldg_bcast_t *b, uint32_t consumer, uint64_t cunt);
+LDG_EXPORT uint64_t ldg_bcast_cunt_get(const ldg_bcast_t *b, uint32_t consumer);
+
+#endif
@@ -0,0 +1,29 @@
+#ifndef LDG_THREAD_DEQUE_H
+#define LDG_THREAD_DEQUE_H
+
+#include <stdint.h>
+#include <dangling/core/macros.h>
+
+// chase-lev work-stealing deque; push/pop from the owner only, steal from anyone
+typedef struct ldg_deque
+{
+    uint8_t *buff;
+    uint64_t item_size;
+    uint64_t cap;
+    uint64_t mask;
+    uint8_t pudding0[LDG_AMD64_CACHE_LINE_WIDTH - sizeof(void *) - (3 * sizeof(uint64_t))];
+    int64_t top;
+    uint8_t pudding1[LDG_AMD64_CACHE_LINE_WIDTH - sizeof(int64_t)];
+    int64_t bottom;
+    uint8_t pudding2[LDG_AMD64_CACHE_LINE_WIDTH - sizeof(int64_t)];
+} LDG_ALIGNED ldg_deque_t;
+
+LDG_EXPORT uint32_t ldg_deque_init(ldg_deque_t *d, uint64_t item_size, uint64_t cap);
+LDG_EXPORT uint32_t ldg_deque_shutdown(ldg_deque_t *d);
+LDG_EXPORT uint32_t ldg_deque_push(ldg_deque_t *d, const void *item);
+LDG_EXPORT uint32_t ldg_deque_pop(ldg_deque_t *d, void *item_out);
+LDG_EXPORT uint32_t ldg_deque_steal(ldg_deque_t *d, void *item_out);
+LDG_EXPORT uint64_t ldg_deque_cunt_get(const ldg_deque_t *d);
+LDG_EXPORT uint8_t ldg_deque_empty_is(const ldg_deque_t *d);
+
+#endif
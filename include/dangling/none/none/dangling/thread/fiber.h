@@ -0,0 +1,72 @@
+#ifndef LDG_THREAD_FIBER_H
+#define LDG_THREAD_FIBER_H
+
+#include <stdint.h>
+#include <dangling/core/macros.h>
+#include <dangling/thread/sync.h>
+#include <dangling/thread/pool.h>
+#include <dangling/thread/mpmc.h>
+#include <dangling/thread/timer.h>
+#include <dangling/arch/amd64/ctx.h>
+
+#define LDG_FIBER_STACK_SIZE (64 * LDG_KIB)
+// stacks kept mapped for reuse once their fiber is gone
+#define LDG_FIBER_STACK_CACHE 256
+// yields before a fiber waiting on a condition starts sleeping on the timer wheel
+#define LDG_FIBER_SPIN_CUNT 16
+#define LDG_FIBER_SLEEP_MAX_NS (1 * LDG_NS_PER_MS)
+
+typedef enum ldg_fiber_state
+{
+    LDG_FIBER_READY = 0,
+    LDG_FIBER_RUNNING,
+    LDG_FIBER_SUSPENDED,
+    LDG_FIBER_DONE
+} ldg_fiber_state_t;
+
+// fibers run as pool tasks, so they migrate between workers and are stolen like any other task
+typedef struct ldg_fiber_sched
+{
+    ldg_thread_pool_t *pool;
+    ldg_timer_wheel_t *wheel;
+    ldg_mut_t mut;
+    void *stack_free;
+    uint64_t stack_size;
+    uint64_t page_size;
+    uint64_t stack_cunt;
+    uint64_t stack_cap;
+    uint64_t live;
+} LDG_ALIGNED ldg_fiber_sched_t;
+
+typedef struct ldg_fiber
+{
+    ldg_ctx_t ctx;
+    ldg_ctx_t home;
+    ldg_fiber_sched_t *sched;
+    uint8_t *stack;
+    ldg_thread_pool_worker_func_t func;
+    void *arg;
+    ldg_timer_t timer;
+    ldg_wg_t done;
+    uint32_t result;
+    uint32_t state;
+    uint32_t action;
+    uint32_t ref;
+    uint32_t slept;
+    uint8_t pudding[8];
+} LDG_ALIGNED ldg_fiber_t;
+
+LDG_EXPORT uint32_t ldg_fiber_sched_create(ldg_thread_pool_t *pool, uint64_t stack_size, uint64_t stack_cap, ldg_fiber_sched_t **out);
+LDG_EXPORT uint32_t ldg_fiber_sched_destroy(ldg_fiber_sched_t **s);
+LDG_EXPORT uint32_t ldg_fiber_create(ldg_fiber_sched_t *s, ldg_thread_pool_worker_func_t func, void *arg, ldg_fiber_t **out);
+LDG_EXPORT uint32_t ldg_fiber_destroy(ldg_fiber_t **f);
+LDG_EXPORT uint32_t ldg_fiber_join(ldg_fiber_t *f, uint64_t timeout_ms);
+LDG_EXPORT uint32_t ldg_fiber_result_get(const ldg_fiber_t *f, uint32_t *result);
+LDG_EXPORT ldg_fiber_t* ldg_fiber_self(void);
+LDG_EXPORT uint32_t ldg_fiber_yield(void);
+LDG_EXPORT uint32_t ldg_fiber_suspend(void);
+LDG_EXPORT uint32_t ldg_fiber_resume(ldg_fiber_t *f);
+LDG_EXPORT uint32_t ldg_fiber_sleep(uint64_t ns);
+LDG_EXPORT uint32_t ldg_fiber_mpmc_wait(ldg_mpmc_queue_t *q, void *item_out, uint64_t timeout_ms);
+
+#endif
@@ -0,0 +1,58 @@
+#ifndef LDG_THREAD_GRAPH_H
+#define LDG_THREAD_GRAPH_H
+
+#include <stdint.h>
+#include <dangling/core/macros.h>
+#include <dangling/thread/sync.h>
+#include <dangling/thread/pool.h>
+
+#define LDG_TASK_GRAPH_NODE_NONE UINT32_MAX
+
+typedef struct ldg_task_graph_node
+{
+    ldg_thread_pool_worker_func_t func;
+    void *arg;
+    void *graph;
+    uint32_t succ_off;
+    uint32_t succ_cunt;
+    uint32_t dep_cunt;
+    uint32_t pending;
+    uint32_t result;
+    uint32_t cp_prev;
+    uint64_t start_ns;
+    uint64_t end_ns;
+    uint64_t cp_len_ns;
+} LDG_ALIGNED ldg_task_graph_node_t;
+
+// build once, run many; all storage is sized at create() and run() never allocates
+typedef struct ldg_task_graph
+{
+    ldg_thread_pool_t *pool;
+    ldg_task_graph_node_t *nodes;
+    uint32_t *edge_src;
+    uint32_t *edge_dst;
+    uint32_t *succ;
+    uint32_t *order;
+    uint32_t node_cunt;
+    uint32_t node_cap;
+    uint32_t edge_cunt;
+    uint32_t edge_cap;
+    ldg_wg_t done_wg;
+    uint32_t err;
+    uint64_t run_start_ns;
+    uint64_t run_end_ns;
+    volatile uint8_t is_running;
+    uint8_t is_dirty;
+    uint8_t pudding[6];
+} LDG_ALIGNED ldg_task_graph_t;
+
+LDG_EXPORT uint32_t ldg_task_graph_create(ldg_thread_pool_t *pool, uint32_t node_cap, uint32_t edge_cap, ldg_task_graph_t **out);
+LDG_EXPORT uint32_t ldg_task_graph_destroy(ldg_task_graph_t **g);
+LDG_EXPORT uint32_t ldg_task_graph_node_add(ldg_task_graph_t *g, ldg_thread_pool_worker_func_t func, void *arg, uint32_t *id_out);
+LDG_EXPORT uint32_t ldg_task_graph_edge_add(ldg_task_graph_t *g, uint32_t from, uint32_t to);
+LDG_EXPORT uint32_t ldg_task_graph_run(ldg_task_graph_t *g);
+LDG_EXPORT uint32_t ldg_task_graph_node_result_get(const ldg_task_graph_t *g, uint32_t id, uint32_t *result);
+LDG_EXPORT uint32_t ldg_task_graph_node_time_get(const ldg_task_graph_t *g, uint32_t id, uint64_t *start_ns, uint64_t *end_ns);
+LDG_EXPORT uint32_t ldg_task_graph_critical_path_get(ldg_task_graph_t *g, uint32_t *path, uint32_t cap, uint32_t *cunt, uint64_t *len_ns);
+
+#endif
@@ -0,0 +1,48 @@
+#ifndef LDG_THREAD_HMAP_H
+#define LDG_THREAD_HMAP_H
+
+#include <stdint.h>
+#include <dangling/core/macros.h>
+#include <dangling/thread/reclaim.h>
+
+// average items per bucket before the bucket cunt doubles
+#define LDG_HMAP_LOAD_FACTOR 2
+// buckets in the first directory segment; segment s > 0 holds LDG_HMAP_SEG0_SIZE << (s - 1)
+#define LDG_HMAP_SEG0_SIZE 64
+#define LDG_HMAP_SEG_MAX 32
+
+// one sorted lock-free list holds every item, ordered by bit-reversed hash; buckets are shortcut pointers
+// into it, so doubling the bucket cunt moves nothing. a new bucket is split off its parent on first use
+typedef struct ldg_hmap_node
+{
+    // low bit marks the node as logically removed
+    uintptr_t next;
+    uint64_t so_key;
+    uint64_t key;
+    uint64_t val;
+    ldg_reclaim_node_t rn;
+} ldg_hmap_node_t;
+
+typedef struct ldg_hmap
+{
+    ldg_ebr_t *ebr;
+    ldg_hmap_node_t **segs[LDG_HMAP_SEG_MAX];
+    uint8_t pudding0[LDG_AMD64_CACHE_LINE_WIDTH - (LDG_HMAP_SEG_MAX + 1) * sizeof(void *) % LDG_AMD64_CACHE_LINE_WIDTH];
+    uint64_t size;
+    uint8_t pudding1[LDG_AMD64_CACHE_LINE_WIDTH - sizeof(uint64_t)];
+    uint64_t cunt;
+    uint8_t pudding2[LDG_AMD64_CACHE_LINE_WIDTH - sizeof(uint64_t)];
+} LDG_ALIGNED ldg_hmap_t;
+
+// every op takes the calling thread's record on ebr, and frees removed nodes through it. vals are plain
+// words; a val that points at shared memory must be retired by the caller on the same domain
+LDG_EXPORT uint32_t ldg_hmap_create(ldg_ebr_t *ebr, uint64_t cap, ldg_hmap_t **out);
+LDG_EXPORT uint32_t ldg_hmap_destroy(ldg_hmap_t **m);
+LDG_EXPORT uint32_t ldg_hmap_get(ldg_hmap_t *m, ldg_ebr_thread_t *t, uint64_t key, uint64_t *val_out);
+LDG_EXPORT uint32_t ldg_hmap_insert(ldg_hmap_t *m, ldg_ebr_thread_t *t, uint64_t key, uint64_t val);
+LDG_EXPORT uint32_t ldg_hmap_put(ldg_hmap_t *m, ldg_ebr_thread_t *t, uint64_t key, uint64_t val);
+LDG_EXPORT uint32_t ldg_hmap_remove(ldg_hmap_t *m, ldg_ebr_thread_t *t, uint64_t key, uint64_t *val_out);
+LDG_EXPORT uint64_t ldg_hmap_cunt_get(const ldg_hmap_t *m);
+LDG_EXPORT uint64_t ldg_hmap_bucket_cunt_get(const ldg_hmap_t *m);
+
+#endif
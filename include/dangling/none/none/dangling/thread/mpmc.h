@@ -23,14 +23,22 @@ typedef struct ldg_mpmc_queue
     uint8_t pudding0[LDG_AMD64_CACHE_LINE_WIDTH - sizeof(uint64_t)];
     uint64_t tail;
     uint8_t pudding1[LDG_AMD64_CACHE_LINE_WIDTH - sizeof(uint64_t)];
-    ldg_mut_t wait_mut;
-    ldg_cond_t wait_cond;
+    ldg_evcnt_t wait_ec;
+    uint32_t spin_lim;
+    // keeps the 3.0 layout; was wait_mut + wait_cond
+    uint8_t pudding2[sizeof(ldg_mut_t) + sizeof(ldg_cond_t) - sizeof(ldg_evcnt_t) - sizeof(uint32_t)];
 } LDG_ALIGNED ldg_mpmc_queue_t;
 
 LDG_EXPORT uint32_t ldg_mpmc_init(ldg_mpmc_queue_t *q, uint64_t item_size, uint64_t cap);
 LDG_EXPORT uint32_t ldg_mpmc_shutdown(ldg_mpmc_queue_t *q);
 LDG_EXPORT uint32_t ldg_mpmc_push(ldg_mpmc_queue_t *q, const void *item);
 LDG_EXPORT uint32_t ldg_mpmc_pop(ldg_mpmc_queue_t *q, void *item_out);
+LDG_EXPORT uint32_t ldg_mpmc_push_n(ldg_mpmc_queue_t *q, const void *items, uint64_t cunt, uint64_t *pushed);
+LDG_EXPORT uint32_t ldg_mpmc_pop_n(ldg_mpmc_queue_t *q, void *items_out, uint64_t cunt, uint64_t *popped);
+LDG_EXPORT uint32_t ldg_mpmc_claim_push(ldg_mpmc_queue_t *q, void **slot_out, uint64_t *ticket_out);
+LDG_EXPORT uint32_t ldg_mpmc_publish(ldg_mpmc_queue_t *q, uint64_t ticket);
+LDG_EXPORT uint32_t ldg_mpmc_claim_pop(ldg_mpmc_queue_t *q, void **slot_out, uint64_t *ticket_out);
+LDG_EXPORT uint32_t ldg_mpmc_release(ldg_mpmc_queue_t *q, uint64_t ticket);
 LDG_EXPORT uint32_t ldg_mpmc_wait(ldg_mpmc_queue_t *q, void *item_out, uint64_t timeout_ms);
 LDG_EXPORT uint64_t ldg_mpmc_cunt_get(const ldg_mpmc_queue_t *q);
 LDG_EXPORT uint8_t ldg_mpmc_empty_is(const ldg_mpmc_queue_t *q);
@@ -0,0 +1,53 @@
+#ifndef LDG_THREAD_MPMCU_H
+#define LDG_THREAD_MPMCU_H
+
+#include <stdint.h>
+#include <dangling/core/macros.h>
+#include <dangling/thread/sync.h>
+
+#define LDG_MPMCU_SEG_CAP_DEFAULT 1024
+
+typedef struct ldg_mpmcu_seg
+{
+    uint64_t base;
+    struct ldg_mpmcu_seg *next;
+    struct ldg_mpmcu_seg *free_next;
+    struct ldg_mpmcu_seg *all_next;
+    uint8_t pudding[32];
+    uint8_t slots[];
+} LDG_ALIGNED ldg_mpmcu_seg_t;
+
+typedef struct ldg_mpmcu_queue
+{
+    uint64_t hd;
+    ldg_mpmcu_seg_t *hd_seg;
+    uint8_t pudding0[LDG_AMD64_CACHE_LINE_WIDTH - sizeof(uint64_t) - sizeof(void *)];
+    uint64_t tail;
+    ldg_mpmcu_seg_t *tail_seg;
+    uint8_t pudding1[LDG_AMD64_CACHE_LINE_WIDTH - sizeof(uint64_t) - sizeof(void *)];
+    ldg_evcnt_t wait_ec;
+    uint32_t spin_lim;
+    uint8_t pudding2[LDG_AMD64_CACHE_LINE_WIDTH - sizeof(ldg_evcnt_t) - sizeof(uint32_t)];
+    uint64_t item_size;
+    uint64_t slot_size;
+    uint64_t seg_cap;
+    uint64_t seg_size;
+    uint64_t seg_cunt;
+    ldg_mpmcu_seg_t *free_list;
+    ldg_mpmcu_seg_t *retired_list;
+    ldg_mpmcu_seg_t *all_list;
+    ldg_mut_t seg_mut;
+    uint8_t is_init;
+    uint8_t pudding3[7];
+} LDG_ALIGNED ldg_mpmcu_queue_t;
+
+LDG_EXPORT uint32_t ldg_mpmcu_init(ldg_mpmcu_queue_t *q, uint64_t item_size, uint64_t seg_cap);
+LDG_EXPORT uint32_t ldg_mpmcu_shutdown(ldg_mpmcu_queue_t *q);
+LDG_EXPORT uint32_t ldg_mpmcu_push(ldg_mpmcu_queue_t *q, const void *item);
+LDG_EXPORT uint32_t ldg_mpmcu_pop(ldg_mpmcu_queue_t *q, void *item_out);
+LDG_EXPORT uint32_t ldg_mpmcu_wait(ldg_mpmcu_queue_t *q, void *item_out, uint64_t timeout_ms);
+LDG_EXPORT uint64_t ldg_mpmcu_cunt_get(const ldg_mpmcu_queue_t *q);
+LDG_EXPORT uint8_t ldg_mpmcu_empty_is(const ldg_mpmcu_queue_t *q);
+LDG_EXPORT uint64_t ldg_mpmcu_seg_cunt_get(const ldg_mpmcu_queue_t *q);
+
+#endif
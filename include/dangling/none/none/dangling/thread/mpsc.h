@@ -0,0 +1,33 @@
+#ifndef LDG_THREAD_MPSC_H
+#define LDG_THREAD_MPSC_H
+
+#include <stdint.h>
+#include <dangling/core/macros.h>
+#include <dangling/thread/sync.h>
+
+// embed in the message; recover it with LDG_CONTAINER_OF after pop
+typedef struct ldg_mpsc_node
+{
+    struct ldg_mpsc_node *next;
+} ldg_mpsc_node_t;
+
+typedef struct ldg_mpsc_queue
+{
+    ldg_mpsc_node_t *hd;
+    uint8_t pudding0[LDG_AMD64_CACHE_LINE_WIDTH - sizeof(void *)];
+    ldg_mpsc_node_t *tail;
+    ldg_mpsc_node_t stub;
+    uint8_t pudding1[LDG_AMD64_CACHE_LINE_WIDTH - sizeof(void *) - sizeof(ldg_mpsc_node_t)];
+    ldg_evcnt_t wait_ec;
+    uint8_t is_init;
+    uint8_t pudding2[LDG_AMD64_CACHE_LINE_WIDTH - sizeof(ldg_evcnt_t) - sizeof(uint8_t)];
+} LDG_ALIGNED ldg_mpsc_queue_t;
+
+LDG_EXPORT uint32_t ldg_mpsc_init(ldg_mpsc_queue_t *q);
+LDG_EXPORT uint32_t ldg_mpsc_shutdown(ldg_mpsc_queue_t *q);
+LDG_EXPORT uint32_t ldg_mpsc_push(ldg_mpsc_queue_t *q, ldg_mpsc_node_t *node);
+LDG_EXPORT uint32_t ldg_mpsc_pop(ldg_mpsc_queue_t *q, ldg_mpsc_node_t **node_out);
+LDG_EXPORT uint32_t ldg_mpsc_wait(ldg_mpsc_queue_t *q, ldg_mpsc_node_t **node_out, uint64_t timeout_ms);
+LDG_EXPORT uint8_t ldg_mpsc_empty_is(const ldg_mpsc_queue_t *q);
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef LDG_THREAD_PCNT_H
+#define LDG_THREAD_PCNT_H
+
+#include <stdint.h>
+#include <dangling/core/macros.h>
+
+// abort handler signature; must match the one the rseq area was registered with (glibc uses the same)
+#define LDG_PCNT_RSEQ_SIG 0x53053053
+
+// a set of cunt counters split into rows, each row padded to whole cache lines; a read sums one column
+// over every row. on linux the first cpu_row_cunt rows are per cpu and an add there is a plain add inside
+// an rseq critical section, so it needs no lock prefix. a thread without rseq (and every thread on windows)
+// adds with a relaxed atomic to one of the thread rows after them, picked once per thread
+typedef struct ldg_pcnt
+{
+    uint64_t *rows;
+    // words per row
+    uint64_t stride;
+    uint32_t cunt;
+    uint32_t cpu_row_cunt;
+    uint32_t thread_row_cunt;
+    uint32_t row_cunt;
+} ldg_pcnt_t;
+
+LDG_EXPORT uint32_t ldg_pcnt_create(uint32_t cunt, ldg_pcnt_t **out);
+LDG_EXPORT uint32_t ldg_pcnt_destroy(ldg_pcnt_t **p);
+LDG_EXPORT uint32_t ldg_pcnt_add(ldg_pcnt_t *p, uint32_t idx, uint64_t val);
+LDG_EXPORT uint32_t ldg_pcnt_sub(ldg_pcnt_t *p, uint32_t idx, uint64_t val);
+LDG_EXPORT uint64_t ldg_pcnt_sum_get(const ldg_pcnt_t *p, uint32_t idx);
+LDG_EXPORT uint32_t ldg_pcnt_sums_get(const ldg_pcnt_t *p, uint64_t *out, uint32_t cap);
+// no thread may be adding while the set is rst
+LDG_EXPORT uint32_t ldg_pcnt_rst(ldg_pcnt_t *p);
+LDG_EXPORT uint8_t ldg_pcnt_rseq_is(void);
+
+#endif
@@ -3,20 +3,63 @@
 
 #include <stdint.h>
 #include <dangling/core/macros.h>
+#include <dangling/thread/sync.h>
 #include <dangling/thread/mpmc.h>
+#include <dangling/thread/mpmcu.h>
+#include <dangling/thread/deque.h>
 
 #define LDG_THREAD_POOL_MAX_WORKERS 64
+// slots per task queue segment; the queue itself is unbounded
 #define LDG_THREAD_POOL_TASK_QUEUE_CAPACITY 1024
 #define LDG_THREAD_POOL_WAIT_TIMEOUT_MS 10
+#define LDG_THREAD_POOL_DEQUE_CAPACITY 4096
+#define LDG_THREAD_POOL_IDLE_SPIN_CUNT 64
+// default lane weights; while every lane is backlogged a lane is served weight times per sum(weights) picks
+#define LDG_THREAD_POOL_WEIGHT_HIGH 16
+#define LDG_THREAD_POOL_WEIGHT_NORMAL 4
+#define LDG_THREAD_POOL_WEIGHT_BG 1
+// queue wait histogram; bucket i counts waits of [2^i, 2^(i+1)) tsc cycles, the last one everything above
+#define LDG_THREAD_POOL_WAIT_HIST_BUCKETS 32
 
 typedef uint32_t (*ldg_thread_pool_worker_func_t)(void *arg);
 
+// one [begin, end) slice of a parallel loop; a non-AOK return stops the remaining slices and is returned by the call
+typedef uint32_t (*ldg_thread_pool_range_func_t)(uint64_t begin, uint64_t end, void *ctx);
+typedef uint32_t (*ldg_thread_pool_reduce_func_t)(uint64_t begin, uint64_t end, void *ctx, void *acc);
+// folds part into acc; must be associative and commutative
+typedef uint32_t (*ldg_thread_pool_join_func_t)(void *acc, const void *part, void *ctx);
+// called in place of func for a task dequeued after its deadline; late_ns is how far past it was
+typedef uint32_t (*ldg_thread_pool_expired_func_t)(ldg_thread_pool_worker_func_t func, void *arg, uint64_t late_ns);
+
+typedef enum ldg_thread_pool_prio
+{
+    LDG_THREAD_POOL_PRIO_HIGH = 0,
+    LDG_THREAD_POOL_PRIO_NORMAL,
+    LDG_THREAD_POOL_PRIO_BG,
+    LDG_THREAD_POOL_PRIO_CUNT
+} ldg_thread_pool_prio_t;
+
+// deadline_ns is absolute monotonic time, 0 for none; submit_tsc stamps the enqueue for the wait histogram
 typedef struct ldg_thread_pool_task
 {
     ldg_thread_pool_worker_func_t func;
     void *arg;
+    uint64_t deadline_ns;
+    uint64_t submit_tsc;
+    uint32_t prio;
+    uint8_t pudding[4];
 } ldg_thread_pool_task_t;
 
+// caller-owned completion slot for submit_h(); must outlive the task
+typedef struct ldg_thread_pool_handle
+{
+    ldg_wg_t wg;
+    uint32_t result;
+    ldg_thread_pool_worker_func_t func;
+    void *arg;
+    void *pool;
+} ldg_thread_pool_handle_t;
+
 typedef enum ldg_thread_pool_worker_state
 {
     LDG_THREAD_POOL_WORKER_IDLE = 0,
@@ -26,6 +69,49 @@ typedef enum ldg_thread_pool_worker_state
     LDG_THREAD_POOL_WORKER_STOPPED
 } ldg_thread_pool_worker_state_t;
 
+typedef enum ldg_thread_pool_sched
+{
+    LDG_THREAD_POOL_SCHED_SHARED = 0,
+    LDG_THREAD_POOL_SCHED_STEAL
+} ldg_thread_pool_sched_t;
+
+// what an idle worker does once its queues are empty; park sleeps on a per-worker futex until a submit picks it
+typedef enum ldg_thread_pool_idle
+{
+    LDG_THREAD_POOL_IDLE_SPIN_YIELD_PARK = 0,
+    LDG_THREAD_POOL_IDLE_SPIN,
+    LDG_THREAD_POOL_IDLE_PARK
+} ldg_thread_pool_idle_t;
+
+// none (the zero default) leaves workers unpinned; compact packs SMT siblings together, scatter spreads across packages first
+typedef enum ldg_thread_pool_place
+{
+    LDG_THREAD_POOL_PLACE_NONE = 0,
+    LDG_THREAD_POOL_PLACE_COMPACT,
+    LDG_THREAD_POOL_PLACE_SCATTER,
+    LDG_THREAD_POOL_PLACE_NO_SMT,
+    LDG_THREAD_POOL_PLACE_LIST
+} ldg_thread_pool_place_t;
+
+// zeroed fields take defaults; rt_prio > 0 requests SCHED_FIFO at that priority
+typedef struct ldg_thread_pool_desc
+{
+    uint32_t worker_cunt;
+    uint32_t sched;
+    uint64_t deque_cap;
+    uint32_t place;
+    uint32_t cpu_list_cunt;
+    const uint32_t *cpu_list;
+    uint8_t isolated;
+    uint8_t rt_prio;
+    uint8_t pudding0[2];
+    uint32_t idle;
+    uint32_t idle_spin;
+    uint32_t lane_weight[LDG_THREAD_POOL_PRIO_CUNT];
+    uint8_t pudding1[4];
+    ldg_thread_pool_expired_func_t expired;
+} ldg_thread_pool_desc_t;
+
 typedef struct ldg_thread_pool_worker
 {
     uint64_t handle;
@@ -36,25 +122,115 @@ typedef struct ldg_thread_pool_worker
     ldg_thread_pool_worker_func_t func;
     void *func_arg;
     void *pool;
-    uint8_t pudding[16];
+    uint32_t park;
+    int32_t credit[LDG_THREAD_POOL_PRIO_CUNT];
 } LDG_ALIGNED ldg_thread_pool_worker_t;
 
+// one priority lane; NORMAL shares its queue with task_queue
+typedef struct ldg_thread_pool_lane
+{
+    ldg_mpmcu_queue_t *queue;
+    uint64_t depth_peak;
+    uint64_t expired;
+    uint32_t weight;
+    uint8_t pudding[LDG_AMD64_CACHE_LINE_WIDTH - sizeof(void *) - (2 * sizeof(uint64_t)) - sizeof(uint32_t)];
+} LDG_ALIGNED ldg_thread_pool_lane_t;
+
+// depth counts the lane's shared queue only; tasks sitting in worker deques are not included
+typedef struct ldg_thread_pool_lane_stats
+{
+    uint64_t depth;
+    uint64_t depth_peak;
+    uint64_t expired;
+    uint32_t weight;
+    uint8_t pudding[4];
+} ldg_thread_pool_lane_stats_t;
+
+// one per worker on its own cache lines, written only by that worker; one more, shared with atomics, takes
+// tasks run by helping callers that are not workers. busy and idle are only kept for workers; idle is
+// credited when the worker next starts a task or exits, and a task run nested inside another counts once
+typedef struct ldg_thread_pool_worker_tele
+{
+    uint64_t executed;
+    uint64_t busy_cycles;
+    uint64_t idle_cycles;
+    uint64_t wait_cycles;
+    uint64_t wait_max_cycles;
+    uint64_t last_tsc;
+    // helper record only: submits that passed argument checks but could not be queued
+    uint64_t rejected;
+    uint32_t nest;
+    uint8_t pudding[4];
+    uint64_t wait_hist[LDG_THREAD_POOL_WAIT_HIST_BUCKETS];
+} LDG_ALIGNED ldg_thread_pool_worker_tele_t;
+
+// all times are tsc cycles; ldg_tsc_to_sec() converts them
+typedef struct ldg_thread_pool_worker_stats
+{
+    uint64_t executed;
+    uint64_t busy_cycles;
+    uint64_t idle_cycles;
+    uint64_t wait_cycles;
+    uint64_t wait_max_cycles;
+    uint64_t wait_hist[LDG_THREAD_POOL_WAIT_HIST_BUCKETS];
+} ldg_thread_pool_worker_stats_t;
+
+// sums over every worker and the helper record; the task_queue fields are the normal lane's depth and peak
+typedef struct ldg_thread_pool_stats
+{
+    uint64_t executed;
+    uint64_t helped;
+    uint64_t expired;
+    uint64_t rejected;
+    uint64_t busy_cycles;
+    uint64_t idle_cycles;
+    uint64_t wait_cycles;
+    uint64_t wait_max_cycles;
+    uint64_t task_queue_depth;
+    uint64_t task_queue_depth_peak;
+    uint64_t wait_hist[LDG_THREAD_POOL_WAIT_HIST_BUCKETS];
+} ldg_thread_pool_stats_t;
+
 typedef struct ldg_thread_pool
 {
     ldg_thread_pool_worker_t workers[LDG_THREAD_POOL_MAX_WORKERS];
-    ldg_mpmc_queue_t *task_queue;
+    ldg_mpmcu_queue_t *task_queue;
     uint32_t worker_cunt;
     volatile uint8_t is_running;
     volatile uint8_t submit_mode;
     uint8_t is_init;
-    uint8_t pudding[43];
+    uint8_t sched;
+    ldg_deque_t *deques;
+    uint8_t pinned;
+    uint8_t rt_prio;
+    uint8_t idle;
+    uint8_t pudding0;
+    uint32_t idle_spin;
+    uint64_t parked;
+    ldg_thread_pool_lane_t *lanes;
+    ldg_thread_pool_expired_func_t expired;
+    // worker_cunt + 1 records, the last one for helpers
+    ldg_thread_pool_worker_tele_t *tele;
 } LDG_ALIGNED ldg_thread_pool_t;
 
 LDG_EXPORT uint32_t ldg_thread_pool_init(ldg_thread_pool_t *pool, uint32_t worker_cunt);
+LDG_EXPORT uint32_t ldg_thread_pool_init_desc(ldg_thread_pool_t *pool, const ldg_thread_pool_desc_t *desc);
 LDG_EXPORT uint32_t ldg_thread_pool_shutdown(ldg_thread_pool_t *pool);
 LDG_EXPORT uint32_t ldg_thread_pool_start(ldg_thread_pool_t *pool, ldg_thread_pool_worker_func_t func, void *arg);
 LDG_EXPORT uint32_t ldg_thread_pool_stop(ldg_thread_pool_t *pool);
 LDG_EXPORT uint64_t ldg_thread_pool_worker_cunt_get(ldg_thread_pool_t *pool);
 LDG_EXPORT uint32_t ldg_thread_pool_submit(ldg_thread_pool_t *pool, ldg_thread_pool_worker_func_t func, void *arg);
+LDG_EXPORT uint32_t ldg_thread_pool_submit_prio(ldg_thread_pool_t *pool, ldg_thread_pool_worker_func_t func, void *arg, uint32_t prio, uint64_t deadline_ns);
+LDG_EXPORT uint32_t ldg_thread_pool_lane_stats_get(ldg_thread_pool_t *pool, uint32_t prio, ldg_thread_pool_lane_stats_t *stats);
+LDG_EXPORT uint32_t ldg_thread_pool_stats_get(ldg_thread_pool_t *pool, ldg_thread_pool_stats_t *stats);
+LDG_EXPORT uint32_t ldg_thread_pool_worker_stats_get(ldg_thread_pool_t *pool, uint32_t worker, ldg_thread_pool_worker_stats_t *stats);
+LDG_EXPORT uint32_t ldg_thread_pool_submit_h(ldg_thread_pool_t *pool, ldg_thread_pool_worker_func_t func, void *arg, ldg_thread_pool_handle_t *h);
+LDG_EXPORT uint32_t ldg_thread_pool_handle_poll(const ldg_thread_pool_handle_t *h);
+LDG_EXPORT uint32_t ldg_thread_pool_handle_result(const ldg_thread_pool_handle_t *h, uint32_t *result);
+LDG_EXPORT uint32_t ldg_thread_pool_handle_wait(ldg_thread_pool_handle_t *h, uint64_t timeout_ms);
+LDG_EXPORT uint32_t ldg_thread_pool_wg_wait(ldg_thread_pool_t *pool, ldg_wg_t *wg, uint64_t timeout_ms);
+LDG_EXPORT uint32_t ldg_thread_pool_barrier_wait(ldg_thread_pool_t *pool, ldg_barrier_t *b, uint8_t *is_last_out);
+LDG_EXPORT uint32_t ldg_thread_pool_parallel_for(ldg_thread_pool_t *pool, uint64_t begin, uint64_t end, uint64_t grain, ldg_thread_pool_range_func_t fn, void *ctx);
+LDG_EXPORT uint32_t ldg_thread_pool_parallel_reduce(ldg_thread_pool_t *pool, uint64_t begin, uint64_t end, uint64_t grain, ldg_thread_pool_reduce_func_t fn, ldg_thread_pool_join_func_t join, void *ctx, void *acc, uint64_t acc_size);
 
 #endif
@@ -0,0 +1,106 @@
+#ifndef LDG_THREAD_RECLAIM_H
+#define LDG_THREAD_RECLAIM_H
+
+#include <stdint.h>
+#include <dangling/core/macros.h>
+
+// retired nodes a thread holds before it tries to advance the epoch and free a batch
+#define LDG_EBR_BATCH 64
+// a node retired in epoch e is unreachable once the global epoch reaches e + 2
+#define LDG_EBR_BUCKETS 3
+// recycled nodes a record keeps for ldg_ebr_node_get() before it frees the rest
+#define LDG_EBR_CACHE_MAX 256
+#define LDG_HP_SLOTS 4
+// retired nodes a record holds before it scans every record's hazard pointers, plus LDG_HP_SLOTS per record
+#define LDG_HP_SCAN_MIN 64
+
+// func 0x0 frees ptr with ldg_mem_dealloc()
+typedef void (*ldg_reclaim_free_func_t)(void *ptr);
+
+// intrusive; embed one in each node that may be retired, so retiring never allocates
+typedef struct ldg_reclaim_node
+{
+    struct ldg_reclaim_node *next;
+    void *ptr;
+    ldg_reclaim_free_func_t func;
+} ldg_reclaim_node_t;
+
+// epoch-based reclamation. readers bracket every access with enter / exit, which costs a store and a fence
+// and never blocks; one stalled reader holds back all reclamation, so use hazard pointers where memory must stay bounded
+struct ldg_ebr;
+
+// one per thread; records are never freed while the domain lives. a released record keeps whatever it could not
+// reclaim yet, and the next thread to take it frees those; destroy frees the rest
+typedef struct ldg_ebr_thread
+{
+    struct ldg_ebr_thread *next;
+    struct ldg_ebr *ebr;
+    // (epoch << 1) | 1 inside a critical section, 0 outside
+    uint64_t state;
+    uint8_t pudding0[LDG_AMD64_CACHE_LINE_WIDTH - 3 * sizeof(uint64_t)];
+    ldg_reclaim_node_t *bucket[LDG_EBR_BUCKETS];
+    uint64_t bucket_epoch[LDG_EBR_BUCKETS];
+    uint64_t retired_cunt;
+    // reclaimed ldg_ebr_node_recycle nodes, linked through their own reclaim node
+    ldg_reclaim_node_t *cache;
+    uint64_t cache_cunt;
+    uint32_t nest;
+    uint32_t is_used;
+} LDG_ALIGNED ldg_ebr_thread_t;
+
+typedef struct ldg_ebr
+{
+    uint64_t epoch;
+    uint8_t pudding0[LDG_AMD64_CACHE_LINE_WIDTH - sizeof(uint64_t)];
+    ldg_ebr_thread_t *threads;
+    uint64_t thread_cunt;
+    // fixed by the first ldg_ebr_node_get(); every recycled node on the domain has this size
+    uint64_t node_size;
+} LDG_ALIGNED ldg_ebr_t;
+
+LDG_EXPORT uint32_t ldg_ebr_create(ldg_ebr_t **out);
+LDG_EXPORT uint32_t ldg_ebr_destroy(ldg_ebr_t **ebr);
+LDG_EXPORT uint32_t ldg_ebr_thread_register(ldg_ebr_t *ebr, ldg_ebr_thread_t **out);
+LDG_EXPORT uint32_t ldg_ebr_thread_unregister(ldg_ebr_thread_t **t);
+LDG_EXPORT uint32_t ldg_ebr_enter(ldg_ebr_thread_t *t);
+LDG_EXPORT uint32_t ldg_ebr_exit(ldg_ebr_thread_t *t);
+LDG_EXPORT uint32_t ldg_ebr_retire(ldg_ebr_thread_t *t, ldg_reclaim_node_t *node, void *ptr, ldg_reclaim_free_func_t func);
+LDG_EXPORT uint32_t ldg_ebr_flush(ldg_ebr_thread_t *t);
+LDG_EXPORT uint64_t ldg_ebr_epoch_get(const ldg_ebr_t *ebr);
+// retire with ldg_ebr_node_recycle as func and the node, once reclaimed, waits on the retiring record for the next
+// ldg_ebr_node_get() there instead of going back to the allocator; called directly it just frees ptr
+LDG_EXPORT void ldg_ebr_node_recycle(void *ptr);
+LDG_EXPORT uint32_t ldg_ebr_node_get(ldg_ebr_thread_t *t, uint64_t size, void **out);
+
+// hazard pointers: a reader publishes each pointer it is about to dereference, and a node is freed only once
+// no record publishes it. each record holds back at most LDG_HP_SCAN_MIN + LDG_HP_SLOTS * records nodes
+struct ldg_hp;
+
+typedef struct ldg_hp_rec
+{
+    void *hp[LDG_HP_SLOTS];
+    uint8_t pudding0[LDG_AMD64_CACHE_LINE_WIDTH - LDG_HP_SLOTS * sizeof(void *)];
+    struct ldg_hp_rec *next;
+    struct ldg_hp *dom;
+    ldg_reclaim_node_t *retired;
+    uint64_t retired_cunt;
+    uint32_t is_used;
+    uint8_t pudding1[4];
+} LDG_ALIGNED ldg_hp_rec_t;
+
+typedef struct ldg_hp
+{
+    ldg_hp_rec_t *recs;
+    uint64_t rec_cunt;
+} LDG_ALIGNED ldg_hp_t;
+
+LDG_EXPORT uint32_t ldg_hp_create(ldg_hp_t **out);
+LDG_EXPORT uint32_t ldg_hp_destroy(ldg_hp_t **hp);
+LDG_EXPORT uint32_t ldg_hp_rec_acquire(ldg_hp_t *hp, ldg_hp_rec_t **out);
+LDG_EXPORT uint32_t ldg_hp_rec_release(ldg_hp_rec_t **rec);
+LDG_EXPORT uint32_t ldg_hp_protect(ldg_hp_rec_t *rec, uint32_t slot, void *const *src, void **out);
+LDG_EXPORT uint32_t ldg_hp_clear(ldg_hp_rec_t *rec, uint32_t slot);
+LDG_EXPORT uint32_t ldg_hp_retire(ldg_hp_rec_t *rec, ldg_reclaim_node_t *node, void *ptr, ldg_reclaim_free_func_t func);
+LDG_EXPORT uint32_t ldg_hp_scan(ldg_hp_rec_t *rec);
+
+#endif
@@ -0,0 +1,73 @@
+#ifndef LDG_THREAD_SHMQ_H
+#define LDG_THREAD_SHMQ_H
+
+#include <stdint.h>
+#include <dangling/core/macros.h>
+
+#define LDG_SHMQ_NAME_MAX 32
+#define LDG_SHMQ_MAGIC 0x514D48534C444C00ULL
+#define LDG_SHMQ_VERSION 1
+
+typedef enum ldg_shmq_kind
+{
+    LDG_SHMQ_SPSC = 0,
+    LDG_SHMQ_MPMC
+} ldg_shmq_kind_t;
+
+// lives at the start of the segment and holds no pointers, so every process may map it at a different
+// address. slots follow at data_off; hd, tail and each wakeup word sit on their own cache line
+typedef struct ldg_shmq_hdr
+{
+    uint64_t magic;
+    uint32_t version;
+    uint32_t kind;
+    uint64_t item_size;
+    uint64_t slot_size;
+    uint64_t cap;
+    uint64_t mask;
+    uint64_t data_off;
+    uint64_t seg_size;
+    uint64_t hd;
+    uint8_t pudding0[LDG_AMD64_CACHE_LINE_WIDTH - sizeof(uint64_t)];
+    uint64_t tail;
+    uint8_t pudding1[LDG_AMD64_CACHE_LINE_WIDTH - sizeof(uint64_t)];
+    // shared futexes: bumped on push / pop, but only while someone is parked on them
+    uint32_t data_seq;
+    uint32_t data_waiters;
+    uint8_t pudding2[LDG_AMD64_CACHE_LINE_WIDTH - 2 * sizeof(uint32_t)];
+    uint32_t space_seq;
+    uint32_t space_waiters;
+    uint8_t pudding3[LDG_AMD64_CACHE_LINE_WIDTH - 2 * sizeof(uint32_t)];
+} LDG_ALIGNED ldg_shmq_hdr_t;
+
+// per-process handle onto a mapped segment
+typedef struct ldg_shmq
+{
+    ldg_shmq_hdr_t *hdr;
+    uint8_t *data;
+    void *handle;
+    uint64_t map_size;
+    // geometry as validated at create / attach; push and pop never reread it from the shared header
+    uint64_t item_size;
+    uint64_t slot_size;
+    uint64_t cap;
+    uint64_t mask;
+    char name[LDG_SHMQ_NAME_MAX];
+    uint32_t kind;
+    uint8_t is_owner;
+    uint8_t is_init;
+    uint8_t pudding[2];
+} ldg_shmq_t;
+
+// push / pop never block: an mpmc slot that stays claimed but unpublished makes them return AGAIN after a bounded
+// spin. a peer that dies between claim and publish leaves its slot that way for good, and blocks the ring there
+LDG_EXPORT uint32_t ldg_shmq_create(ldg_shmq_t *q, const char *name, uint32_t kind, uint64_t item_size, uint64_t cap);
+LDG_EXPORT uint32_t ldg_shmq_attach(ldg_shmq_t *q, const char *name);
+LDG_EXPORT uint32_t ldg_shmq_detach(ldg_shmq_t *q);
+LDG_EXPORT uint32_t ldg_shmq_push(ldg_shmq_t *q, const void *item);
+LDG_EXPORT uint32_t ldg_shmq_pop(ldg_shmq_t *q, void *item_out);
+LDG_EXPORT uint32_t ldg_shmq_push_wait(ldg_shmq_t *q, const void *item, uint64_t timeout_ns);
+LDG_EXPORT uint32_t ldg_shmq_pop_wait(ldg_shmq_t *q, void *item_out, uint64_t timeout_ns);
+LDG_EXPORT uint64_t ldg_shmq_cunt_get(const ldg_shmq_t *q);
+
+#endif
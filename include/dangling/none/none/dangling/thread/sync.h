@@ -55,4 +55,139 @@ LDG_EXPORT uint32_t ldg_sem_wait(ldg_sem_t *s);
 LDG_EXPORT uint32_t ldg_sem_trywait(ldg_sem_t *s);
 LDG_EXPORT uint32_t ldg_sem_post(ldg_sem_t *s);
 
+// anonymous, process-private counting semaphore on a futex; no kernel object, nothing to leak.
+// post and an uncontended wait stay in userspace; post only syscalls when someone is parked
+#define LDG_SEM_LOCAL_MAX 0x7FFFFFFFu
+
+typedef struct ldg_sem_local
+{
+    uint32_t val;
+    uint32_t waiters;
+} ldg_sem_local_t;
+
+LDG_EXPORT uint32_t ldg_sem_local_init(ldg_sem_local_t *s, uint32_t init_val);
+LDG_EXPORT uint32_t ldg_sem_local_destroy(ldg_sem_local_t *s);
+LDG_EXPORT uint32_t ldg_sem_local_wait(ldg_sem_local_t *s);
+LDG_EXPORT uint32_t ldg_sem_local_timedwait(ldg_sem_local_t *s, uint64_t timeout_ns);
+LDG_EXPORT uint32_t ldg_sem_local_trywait(ldg_sem_local_t *s);
+LDG_EXPORT uint32_t ldg_sem_local_post(ldg_sem_local_t *s);
+LDG_EXPORT uint64_t ldg_sem_local_val_get(const ldg_sem_local_t *s);
+
+#define LDG_FUTEX_WAIT_INFINITE UINT64_MAX
+
+LDG_EXPORT uint32_t ldg_futex_wait(uint32_t *addr, uint32_t expected, uint64_t timeout_ns, uint8_t shared);
+LDG_EXPORT uint32_t ldg_futex_wake(uint32_t *addr, uint32_t cunt, uint8_t shared);
+
+// 3-state futex mutex: 0 unlocked, 1 locked, 2 locked with parked waiters
+#define LDG_LMUT_UNLOCKED 0
+#define LDG_LMUT_LOCKED 1
+#define LDG_LMUT_CONTENDED 2
+// ceiling for the adaptive spin before parking
+#define LDG_LMUT_SPIN_MAX 100
+
+// 8 bytes, no libc; spin is a running estimate of how long the lock takes to come free
+typedef struct ldg_lmut
+{
+    uint32_t state;
+    uint16_t spin;
+    uint8_t is_shared;
+    uint8_t is_init;
+} ldg_lmut_t;
+
+LDG_EXPORT uint32_t ldg_lmut_init(ldg_lmut_t *m, uint8_t shared);
+LDG_EXPORT uint32_t ldg_lmut_destroy(ldg_lmut_t *m);
+LDG_EXPORT uint32_t ldg_lmut_lock(ldg_lmut_t *m);
+LDG_EXPORT uint32_t ldg_lmut_unlock(ldg_lmut_t *m);
+LDG_EXPORT uint32_t ldg_lmut_trylock(ldg_lmut_t *m);
+
+// state word: low 30 bits reader cunt, bit 30 readers parked, bit 31 writer holds or is draining readers
+#define LDG_RWLOCK_RD_MAX 0x3FFFFFFFu
+#define LDG_RWLOCK_RD_WAIT 0x40000000u
+#define LDG_RWLOCK_WR 0x80000000u
+// pauses before a blocked reader or draining writer parks
+#define LDG_RWLOCK_SPIN_CUNT 128
+
+// writer-preferring: once a writer sets WR new readers park, so a stream of readers cannot starve it.
+// writers queue on wmut; drain is the futex the last reader out bumps for the writer
+typedef struct ldg_rwlock
+{
+    uint32_t state;
+    uint32_t drain;
+    ldg_lmut_t wmut;
+} ldg_rwlock_t;
+
+LDG_EXPORT uint32_t ldg_rwlock_init(ldg_rwlock_t *rw, uint8_t shared);
+LDG_EXPORT uint32_t ldg_rwlock_destroy(ldg_rwlock_t *rw);
+LDG_EXPORT uint32_t ldg_rwlock_rd_lock(ldg_rwlock_t *rw);
+LDG_EXPORT uint32_t ldg_rwlock_rd_trylock(ldg_rwlock_t *rw);
+LDG_EXPORT uint32_t ldg_rwlock_rd_unlock(ldg_rwlock_t *rw);
+LDG_EXPORT uint32_t ldg_rwlock_wr_lock(ldg_rwlock_t *rw);
+LDG_EXPORT uint32_t ldg_rwlock_wr_trylock(ldg_rwlock_t *rw);
+LDG_EXPORT uint32_t ldg_rwlock_wr_unlock(ldg_rwlock_t *rw);
+
+// pauses before a reader that keeps finding a write in progress yields its cpu
+#define LDG_SEQLOCK_SPIN_CUNT 64
+
+// for small, hot snapshots: readers never write shared memory, so they do not bounce a line between cores.
+// read: rd_begin, copy the fields into locals, repeat while rd_retry_is. odd seq means a write is in progress
+typedef struct ldg_seqlock
+{
+    uint32_t seq;
+    uint8_t pudding[4];
+    ldg_lmut_t wmut;
+} ldg_seqlock_t;
+
+LDG_EXPORT uint32_t ldg_seqlock_init(ldg_seqlock_t *sl, uint8_t shared);
+LDG_EXPORT uint32_t ldg_seqlock_destroy(ldg_seqlock_t *sl);
+LDG_EXPORT uint32_t ldg_seqlock_rd_begin(const ldg_seqlock_t *sl, uint32_t *seq);
+LDG_EXPORT uint8_t ldg_seqlock_rd_retry_is(const ldg_seqlock_t *sl, uint32_t seq);
+LDG_EXPORT uint32_t ldg_seqlock_wr_lock(ldg_seqlock_t *sl);
+LDG_EXPORT uint32_t ldg_seqlock_wr_unlock(ldg_seqlock_t *sl);
+
+typedef struct ldg_evcnt
+{
+    uint32_t epoch;
+    uint32_t waiters;
+} ldg_evcnt_t;
+
+LDG_EXPORT uint32_t ldg_evcnt_init(ldg_evcnt_t *ec);
+LDG_EXPORT uint32_t ldg_evcnt_prep(ldg_evcnt_t *ec, uint32_t *key_out);
+LDG_EXPORT uint32_t ldg_evcnt_cancel(ldg_evcnt_t *ec);
+LDG_EXPORT uint32_t ldg_evcnt_wait(ldg_evcnt_t *ec, uint32_t key, uint64_t timeout_ns);
+LDG_EXPORT uint32_t ldg_evcnt_notify(ldg_evcnt_t *ec, uint8_t all);
+
+// wait group / latch; low 31 bits are the count, the top bit marks a parked waiter
+#define LDG_WG_CUNT_MAX 0x7FFFFFFFu
+
+typedef struct ldg_wg
+{
+    uint32_t cunt;
+} ldg_wg_t;
+
+LDG_EXPORT uint32_t ldg_wg_init(ldg_wg_t *wg, uint32_t cunt);
+LDG_EXPORT uint32_t ldg_wg_add(ldg_wg_t *wg, uint32_t n);
+LDG_EXPORT uint32_t ldg_wg_done(ldg_wg_t *wg);
+LDG_EXPORT uint32_t ldg_wg_wait(ldg_wg_t *wg, uint64_t timeout_ms);
+LDG_EXPORT uint64_t ldg_wg_cunt_get(const ldg_wg_t *wg);
+
+// reusable barrier; sense reversal by generation, so a thread can start the next phase while others are
+// still leaving this one. the arrival cunt and the generation waiters spin on sit on separate cache lines
+#define LDG_BARRIER_SPIN_CUNT 1024
+
+typedef struct ldg_barrier
+{
+    uint32_t left;
+    uint32_t parties;
+    uint8_t pudding0[LDG_AMD64_CACHE_LINE_WIDTH - 2 * sizeof(uint32_t)];
+    uint32_t gen;
+    uint32_t waiters;
+    uint8_t pudding1[LDG_AMD64_CACHE_LINE_WIDTH - 2 * sizeof(uint32_t)];
+} LDG_ALIGNED ldg_barrier_t;
+
+LDG_EXPORT uint32_t ldg_barrier_init(ldg_barrier_t *b, uint32_t parties);
+LDG_EXPORT uint32_t ldg_barrier_destroy(ldg_barrier_t *b);
+LDG_EXPORT uint32_t ldg_barrier_wait(ldg_barrier_t *b, uint8_t *is_last_out);
+LDG_EXPORT uint32_t ldg_barrier_arrive(ldg_barrier_t *b, uint32_t *token_out, uint8_t *is_last_out);
+LDG_EXPORT uint32_t ldg_barrier_token_wait(ldg_barrier_t *b, uint32_t token, uint64_t timeout_ns);
+
 #endif
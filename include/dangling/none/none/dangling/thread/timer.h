@@ -0,0 +1,69 @@
+#ifndef LDG_THREAD_TIMER_H
+#define LDG_THREAD_TIMER_H
+
+#include <stdint.h>
+#include <dangling/core/macros.h>
+#include <dangling/thread/sync.h>
+#include <dangling/thread/pool.h>
+
+// 6 levels of 64 slots cover 2^36 ticks; later deadlines park in the top level and are re-placed as it turns
+#define LDG_TIMER_WHEEL_LVL_BITS 6
+#define LDG_TIMER_WHEEL_SLOTS 64
+#define LDG_TIMER_WHEEL_LVLS 6
+#define LDG_TIMER_WHEEL_TICK_NS 1000000
+// expired timers handed off per lock hold
+#define LDG_TIMER_WHEEL_BATCH 64
+
+typedef enum ldg_timer_state
+{
+    LDG_TIMER_IDLE = 0,
+    LDG_TIMER_PENDING
+} ldg_timer_state_t;
+
+// caller-owned and intrusive so arming never allocates; must not move or be freed while pending
+typedef struct ldg_timer
+{
+    struct ldg_timer *prev;
+    struct ldg_timer *next;
+    ldg_thread_pool_worker_func_t func;
+    void *arg;
+    void *wheel;
+    uint64_t expire;
+    uint64_t period;
+    uint8_t state;
+    uint8_t lvl;
+    uint8_t slot;
+    uint8_t pudding[5];
+} ldg_timer_t;
+
+// one driver at a time: either start() the tick thread or call advance() from your own loop
+typedef struct ldg_timer_wheel
+{
+    ldg_timer_t *slots[LDG_TIMER_WHEEL_LVLS][LDG_TIMER_WHEEL_SLOTS];
+    uint64_t occupied[LDG_TIMER_WHEEL_LVLS];
+    ldg_thread_pool_t *pool;
+    ldg_mut_t mut;
+    uint64_t tick_ns;
+    uint64_t origin_ns;
+    uint64_t now;
+    uint64_t pending;
+    uint64_t wake_tick;
+    uint64_t thread;
+    uint32_t seq;
+    volatile uint8_t is_running;
+    volatile uint8_t should_stop;
+    uint8_t pudding[2];
+} LDG_ALIGNED ldg_timer_wheel_t;
+
+LDG_EXPORT uint32_t ldg_timer_wheel_create(ldg_thread_pool_t *pool, uint64_t tick_ns, ldg_timer_wheel_t **out);
+LDG_EXPORT uint32_t ldg_timer_wheel_destroy(ldg_timer_wheel_t **w);
+LDG_EXPORT uint32_t ldg_timer_wheel_start(ldg_timer_wheel_t *w);
+LDG_EXPORT uint32_t ldg_timer_wheel_stop(ldg_timer_wheel_t *w);
+LDG_EXPORT uint32_t ldg_timer_wheel_advance(ldg_timer_wheel_t *w, uint64_t *fired);
+LDG_EXPORT uint32_t ldg_timer_wheel_next_get(ldg_timer_wheel_t *w, uint64_t *delay_ns);
+LDG_EXPORT uint64_t ldg_timer_wheel_cunt_get(ldg_timer_wheel_t *w);
+LDG_EXPORT uint32_t ldg_timer_arm(ldg_timer_wheel_t *w, ldg_timer_t *t, uint64_t delay_ns, uint64_t period_ns, ldg_thread_pool_worker_func_t func, void *arg);
+LDG_EXPORT uint32_t ldg_timer_cancel(ldg_timer_wheel_t *w, ldg_timer_t *t);
+LDG_EXPORT uint8_t ldg_timer_pending_is(const ldg_timer_t *t);
+
+#endif
@@ -3,7 +3,13 @@
 
 #include <stdint.h>
 #include <dangling/core/macros.h>
+#include <dangling/arch/amd64/tsc.h>
+
+// starting guess for how late the os wakes a sleeper; precise sleeps then track what they observe
+#define LDG_THREAD_YIELD_SLACK_NS (100 * LDG_NS_PER_MS / 1000)
 
 LDG_EXPORT uint32_t ldg_thread_yield(uint64_t ns);
+LDG_EXPORT uint32_t ldg_thread_yield_precise(const ldg_tsc_ctx_t *tsc, uint64_t ns);
+LDG_EXPORT uint32_t ldg_thread_yield_until(const ldg_tsc_ctx_t *tsc, uint64_t deadline_tsc);
 
 #endif
@@ -0,0 +1,56 @@
+section .text
+
+; rdi = ctx, rsi = stack lo, rdx = stack size, rcx = fn, r8 = arg
+; lays out the frame ldg_ctx_swap pops so the first switch returns into ctx_entry
+global ldg_ctx_make
+ldg_ctx_make:
+    lea     rax, [rsi + rdx]
+    and     rax, -16
+    sub     rax, 64
+
+    mov     dword [rax], 0x1F80
+    mov     dword [rax + 4], 0x037F
+    mov     qword [rax + 8], 0
+    mov     qword [rax + 16], 0
+    mov     [rax + 24], rcx
+    mov     [rax + 32], r8
+    mov     qword [rax + 40], 0
+    mov     qword [rax + 48], 0
+    lea     r9, [rel ctx_entry]
+    mov     [rax + 56], r9
+
+    mov     [rdi], rax
+    ret
+
+; rdi = from, rsi = to; sysv callee-saved set plus mxcsr and the x87 control word
+global ldg_ctx_swap
+ldg_ctx_swap:
+    push    rbp
+    push    rbx
+    push    r12
+    push    r13
+    push    r14
+    push    r15
+    sub     rsp, 8
+    stmxcsr [rsp]
+    fnstcw  [rsp + 4]
+
+    mov     [rdi], rsp
+    mov     rsp, [rsi]
+
+    ldmxcsr [rsp]
+    fldcw   [rsp + 4]
+    add     rsp, 8
+    pop     r15
+    pop     r14
+    pop     r13
+    pop     r12
+    pop     rbx
+    pop     rbp
+    ret
+
+; first ret of a fresh context lands here with rsp 16-aligned; r13 = fn, r12 = arg
+ctx_entry:
+    mov     rdi, r12
+    call    r13
+    ud2
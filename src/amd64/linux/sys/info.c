@@ -1,6 +1,11 @@
+#define _GNU_SOURCE
+
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
+#include <fcntl.h>
+#include <sched.h>
 
 #include <dangling/sys/info.h>
 #include <dangling/core/err.h>
@@ -78,3 +83,156 @@ uint32_t ldg_sys_pid_get(uint64_t *pid)
 
     return LDG_ERR_AOK;
 }
+
+// topo
+
+#define INFO_SYSFS_CPU_DIR "/sys/devices/system/cpu"
+#define INFO_SYSFS_BUFF_SIZE 4096
+#define INFO_SYSFS_PATH_SIZE 128
+#define INFO_SYSFS_ATTR_SIZE 32
+
+static uint32_t info_sysfs_rd(const char *path, char *buff, uint64_t buff_size)
+{
+    int32_t fd = -1;
+    int64_t n = 0;
+
+    fd = (int32_t)open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) { return LDG_ERR_IO_NOT_FOUND; }
+
+    n = (int64_t)read(fd, buff, buff_size - LDG_STR_TERM_SIZE);
+    close(fd);
+
+    if (LDG_UNLIKELY(n < 0)) { return LDG_ERR_IO_RD; }
+
+    buff[n] = LDG_STR_TERM;
+
+    return LDG_ERR_AOK;
+}
+
+static uint32_t info_u32_parse(const char **s, uint32_t *out)
+{
+    const char *p = *s;
+    uint64_t val = 0;
+
+    if (*p < '0' || *p > '9') { return LDG_ERR_STR_INVALID; }
+
+    while (*p >= '0' && *p <= '9')
+    {
+        val = (val * LDG_BASE_DEC) + (uint64_t)(*p - '0');
+        if (LDG_UNLIKELY(val > UINT32_MAX)) { return LDG_ERR_OVERFLOW; }
+
+        p++;
+    }
+
+    *out = (uint32_t)val;
+    *s = p;
+
+    return LDG_ERR_AOK;
+}
+
+// sysfs cpulist, e.g. "0-3,8,10-11"; ids past mask_len are dropped
+static uint32_t info_cpulist_parse(const char *s, uint8_t *mask, uint32_t mask_len)
+{
+    uint32_t lo = 0;
+    uint32_t hi = 0;
+    uint32_t i = 0;
+    uint32_t ret = 0;
+
+    while (*s && *s != '\n')
+    {
+        ret = info_u32_parse(&s, &lo);
+        if (LDG_UNLIKELY(ret != LDG_ERR_AOK)) { return ret; }
+
+        hi = lo;
+
+        if (*s == '-')
+        {
+            s++;
+            ret = info_u32_parse(&s, &hi);
+            if (LDG_UNLIKELY(ret != LDG_ERR_AOK)) { return ret; }
+        }
+
+        for (i = lo; i <= hi && i < mask_len; i++) { mask[i] = 1; }
+
+        if (*s == ',') { s++; }
+        else if (*s && *s != '\n') { return LDG_ERR_STR_INVALID; }
+    }
+
+    return LDG_ERR_AOK;
+}
+
+static uint32_t info_cpu_attr_rd(uint32_t cpu, const char *attr, uint32_t *out)
+{
+    char path[INFO_SYSFS_PATH_SIZE] = { 0 };
+    char buff[INFO_SYSFS_ATTR_SIZE] = { 0 };
+    const char *p = buff;
+    uint32_t ret = 0;
+
+    if (LDG_UNLIKELY(snprintf(path, sizeof(path), INFO_SYSFS_CPU_DIR "/cpu%u/topology/%s", cpu, attr) < 0)) { return LDG_ERR_STR_FMT; }
+
+    ret = info_sysfs_rd(path, buff, sizeof(buff));
+    if (ret != LDG_ERR_AOK) { return ret; }
+
+    return info_u32_parse(&p, out);
+}
+
+// cpus this process may run on, ascending cpu_id; FULL when cap truncated the list
+uint32_t ldg_sys_cpu_topo_get(ldg_sys_cpu_topo_t *out, uint32_t cap, uint32_t *cunt)
+{
+    uint8_t online[LDG_SYS_CPU_MAX] = { 0 };
+    uint8_t isolated[LDG_SYS_CPU_MAX] = { 0 };
+    char buff[INFO_SYSFS_BUFF_SIZE] = { 0 };
+    cpu_set_t allowed;
+    uint8_t allowed_ok = 0;
+    uint32_t cpu = 0;
+    uint32_t i = 0;
+    uint32_t n = 0;
+    uint32_t ret = 0;
+    ldg_sys_cpu_topo_t *t = 0x0;
+
+    if (LDG_UNLIKELY(!out || !cunt)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    *cunt = 0;
+
+    if (LDG_UNLIKELY(cap == 0)) { return LDG_ERR_FUNC_ARG_INVALID; }
+
+    ret = info_sysfs_rd(INFO_SYSFS_CPU_DIR "/online", buff, sizeof(buff));
+    if (LDG_UNLIKELY(ret != LDG_ERR_AOK)) { return LDG_ERR_UNSUPPORTED; }
+
+    ret = info_cpulist_parse(buff, online, LDG_SYS_CPU_MAX);
+    if (LDG_UNLIKELY(ret != LDG_ERR_AOK)) { return ret; }
+
+    // absent on kernels without isolcpus; not an error
+    if (info_sysfs_rd(INFO_SYSFS_CPU_DIR "/isolated", buff, sizeof(buff)) == LDG_ERR_AOK) { info_cpulist_parse(buff, isolated, LDG_SYS_CPU_MAX); }
+
+    CPU_ZERO(&allowed);
+    allowed_ok = (sched_getaffinity(0, sizeof(allowed), &allowed) == 0);
+
+    for (cpu = 0; cpu < LDG_SYS_CPU_MAX; cpu++)
+    {
+        if (!online[cpu]) { continue; }
+
+        if (allowed_ok && cpu < CPU_SETSIZE && !CPU_ISSET(cpu, &allowed)) { continue; }
+
+        if (n >= cap) { *cunt = n; return LDG_ERR_FULL; }
+
+        t = &out[n];
+
+        if (LDG_UNLIKELY(memset(t, 0, sizeof(ldg_sys_cpu_topo_t)) != t)) { return LDG_ERR_MEM_BAD; }
+
+        t->cpu_id = cpu;
+        t->isolated = isolated[cpu];
+
+        // physical_package_id reads -1 on some virtual machines; fall back to one package
+        if (info_cpu_attr_rd(cpu, "core_id", &t->core_id) != LDG_ERR_AOK) { t->core_id = cpu; }
+        if (info_cpu_attr_rd(cpu, "physical_package_id", &t->pkg_id) != LDG_ERR_AOK) { t->pkg_id = 0; }
+
+        for (i = 0; i < n; i++) { if (out[i].pkg_id == t->pkg_id && out[i].core_id == t->core_id) { t->smt_idx++; } }
+
+        n++;
+    }
+
+    *cunt = n;
+
+    return LDG_ERR_AOK;
+}
@@ -0,0 +1,161 @@
+#include <string.h>
+
+#include <dangling/thread/deque.h>
+#include <dangling/core/err.h>
+#include <dangling/mem/secure.h>
+#include <dangling/mem/alloc.h>
+#include <dangling/core/macros.h>
+#include <dangling/core/arith.h>
+#include <dangling/arch/amd64/atomic.h>
+#include <dangling/arch/amd64/fence.h>
+
+static uint8_t* deque_slot_get(const ldg_deque_t *d, int64_t idx)
+{
+    return d->buff + (((uint64_t)idx & d->mask) * d->item_size);
+}
+
+uint32_t ldg_deque_init(ldg_deque_t *d, uint64_t item_size, uint64_t cap)
+{
+    void *buff_tmp = 0x0;
+    uint64_t buff_size = 0;
+    uint32_t ret = 0;
+
+    if (LDG_UNLIKELY(!d)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    if (LDG_UNLIKELY(item_size == 0 || cap == 0 || (cap & (cap - 1)) != 0)) { return LDG_ERR_FUNC_ARG_INVALID; }
+
+    if (LDG_UNLIKELY(cap > (uint64_t)INT64_MAX)) { return LDG_ERR_OVERFLOW; }
+
+    if (LDG_UNLIKELY(memset(d, 0, sizeof(ldg_deque_t)) != d)) { return LDG_ERR_MEM_BAD; }
+
+    if (LDG_UNLIKELY(ldg_arith_64_mul(item_size, cap, &buff_size) != LDG_ERR_AOK)) { return LDG_ERR_OVERFLOW; }
+
+    ret = ldg_mem_alloc(buff_size, &buff_tmp);
+    if (LDG_UNLIKELY(ret != LDG_ERR_AOK)) { return ret; }
+
+    d->buff = (uint8_t *)buff_tmp;
+    d->item_size = item_size;
+    d->cap = cap;
+    d->mask = cap - 1;
+    d->top = 0;
+    d->bottom = 0;
+
+    return LDG_ERR_AOK;
+}
+
+uint32_t ldg_deque_shutdown(ldg_deque_t *d)
+{
+    if (LDG_UNLIKELY(!d)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    if (d->buff)
+    {
+        ldg_mem_dealloc(d->buff);
+        d->buff = 0x0;
+    }
+
+    d->item_size = 0;
+    d->cap = 0;
+    d->mask = 0;
+    d->top = 0;
+    d->bottom = 0;
+
+    return LDG_ERR_AOK;
+}
+
+// owner only; fixed capacity, caller decides where overflow goes
+uint32_t ldg_deque_push(ldg_deque_t *d, const void *item)
+{
+    int64_t b = 0;
+    int64_t t = 0;
+
+    if (LDG_UNLIKELY(!d || !d->buff || !item)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    b = LDG_RD_ONCE(d->bottom);
+    t = LDG_LOAD_ACQUIRE(d->top);
+
+    if (LDG_UNLIKELY((uint64_t)(b - t) >= d->cap)) { return LDG_ERR_FULL; }
+
+    if (LDG_UNLIKELY(ldg_mem_secure_copy(deque_slot_get(d, b), item, d->item_size) != LDG_ERR_AOK)) { return LDG_ERR_MEM_BAD; }
+
+    LDG_STORE_RELEASE(d->bottom, b + 1);
+
+    return LDG_ERR_AOK;
+}
+
+// owner only; lifo end, races thieves only for the last item
+uint32_t ldg_deque_pop(ldg_deque_t *d, void *item_out)
+{
+    int64_t b = 0;
+    int64_t t = 0;
+    uint32_t ret = LDG_ERR_AOK;
+
+    if (LDG_UNLIKELY(!d || !d->buff || !item_out)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    b = LDG_RD_ONCE(d->bottom) - 1;
+
+    // locked xchg is the store-load fence chase-lev needs between bottom and top
+    LDG_XCHG(d->bottom, b);
+    t = LDG_RD_ONCE(d->top);
+
+    if (t > b)
+    {
+        LDG_WR_ONCE(d->bottom, b + 1);
+        return LDG_ERR_EMPTY;
+    }
+
+    if (LDG_UNLIKELY(ldg_mem_secure_copy(item_out, deque_slot_get(d, b), d->item_size) != LDG_ERR_AOK)) { ret = LDG_ERR_MEM_BAD; }
+
+    if (t == b)
+    {
+        if (!LDG_CAS(&d->top, &t, t + 1)) { ret = LDG_ERR_EMPTY; }
+
+        LDG_WR_ONCE(d->bottom, b + 1);
+    }
+
+    return ret;
+}
+
+// any thread; AGAIN when another thief or the owner won the race for top
+uint32_t ldg_deque_steal(ldg_deque_t *d, void *item_out)
+{
+    int64_t t = 0;
+    int64_t b = 0;
+
+    if (LDG_UNLIKELY(!d || !d->buff || !item_out)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    // amd64 keeps load-load order; the owner's xchg in pop() supplies the store-load side
+    t = LDG_LOAD_ACQUIRE(d->top);
+    LDG_BARRIER;
+    b = LDG_LOAD_ACQUIRE(d->bottom);
+
+    if (t >= b) { return LDG_ERR_EMPTY; }
+
+    // may read a slot the owner is overwriting; the CAS below discards it
+    if (LDG_UNLIKELY(ldg_mem_secure_copy(item_out, deque_slot_get(d, t), d->item_size) != LDG_ERR_AOK)) { return LDG_ERR_MEM_BAD; }
+
+    if (!LDG_CAS(&d->top, &t, t + 1)) { return LDG_ERR_AGAIN; }
+
+    return LDG_ERR_AOK;
+}
+
+uint64_t ldg_deque_cunt_get(const ldg_deque_t *d)
+{
+    int64_t t = 0;
+    int64_t b = 0;
+
+    if (LDG_UNLIKELY(!d)) { return UINT64_MAX; }
+
+    t = LDG_LOAD_ACQUIRE(d->top);
+    b = LDG_LOAD_ACQUIRE(d->bottom);
+
+    if (b > t) { return (uint64_t)(b - t); }
+
+    return 0;
+}
+
+uint8_t ldg_deque_empty_is(const ldg_deque_t *d)
+{
+    if (LDG_UNLIKELY(!d)) { return LDG_TRUTH_TRUE; }
+
+    return LDG_LOAD_ACQUIRE(d->bottom) <= LDG_LOAD_ACQUIRE(d->top);
+}
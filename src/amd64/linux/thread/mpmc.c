@@ -10,7 +10,8 @@
 #include <dangling/arch/amd64/fence.h>
 
 #define MPMC_MAX_SPIN 1024
-#define MPMC_WAIT_MAX_ITER 4096
+#define MPMC_WAIT_SPIN_MIN 16
+#define MPMC_WAIT_SPIN_MAX 4096
 
 static uint64_t mpmc_monotonic_ms_get(void)
 {
@@ -81,21 +82,9 @@ uint32_t ldg_mpmc_init(ldg_mpmc_queue_t *q, uint64_t item_size, uint64_t cap)
 
     q->hd = 0;
     q->tail = 0;
+    q->spin_lim = MPMC_WAIT_SPIN_MIN;
 
-    if (LDG_UNLIKELY(ldg_mut_init(&q->wait_mut, 0) != LDG_ERR_AOK))
-    {
-        ldg_mem_dealloc(q->buff);
-        q->buff = 0x0;
-        return LDG_ERR_ALLOC_NULL;
-    }
-
-    if (LDG_UNLIKELY(ldg_cond_init(&q->wait_cond, 0) != LDG_ERR_AOK))
-    {
-        ldg_mut_destroy(&q->wait_mut);
-        ldg_mem_dealloc(q->buff);
-        q->buff = 0x0;
-        return LDG_ERR_ALLOC_NULL;
-    }
+    ldg_evcnt_init(&q->wait_ec);
 
     return LDG_ERR_AOK;
 }
@@ -107,13 +96,7 @@ uint32_t ldg_mpmc_shutdown(ldg_mpmc_queue_t *q)
 
     if (LDG_UNLIKELY(!q)) { return LDG_ERR_FUNC_ARG_NULL; }
 
-    ret = ldg_cond_bcast(&q->wait_cond);
-    if (LDG_UNLIKELY(ret != LDG_ERR_AOK && first_err == LDG_ERR_AOK)) { first_err = ret; }
-
-    ret = ldg_cond_destroy(&q->wait_cond);
-    if (LDG_UNLIKELY(ret != LDG_ERR_AOK && first_err == LDG_ERR_AOK)) { first_err = ret; }
-
-    ret = ldg_mut_destroy(&q->wait_mut);
+    ret = ldg_evcnt_notify(&q->wait_ec, 1);
     if (LDG_UNLIKELY(ret != LDG_ERR_AOK && first_err == LDG_ERR_AOK)) { first_err = ret; }
 
     if (q->buff)
@@ -132,37 +115,61 @@ uint32_t ldg_mpmc_shutdown(ldg_mpmc_queue_t *q)
     return first_err;
 }
 
-uint32_t ldg_mpmc_push(ldg_mpmc_queue_t *q, const void *item)
+// claims up to want contiguous tickets from the hd (lap_off 0) or tail (lap_off 1) cursor with one CAS
+static uint32_t mpmc_claim(ldg_mpmc_queue_t *q, uint64_t *cursor, uint64_t lap_off, uint64_t want, uint64_t *pos_out, uint64_t *n_out)
 {
     uint64_t pos = 0;
     uint64_t seq = 0;
+    uint64_t n = 0;
     uint32_t spin = 0;
     ldg_mpmc_slot_t *slot = 0x0;
 
-    if (LDG_UNLIKELY(!q || !item)) { return LDG_ERR_FUNC_ARG_NULL; }
-
     for (spin = 0; spin < MPMC_MAX_SPIN; spin++)
     {
-        pos = LDG_LOAD_ACQUIRE(q->hd);
+        pos = LDG_LOAD_ACQUIRE(*cursor);
         if (LDG_UNLIKELY(pos > UINT64_MAX - q->cap)) { return LDG_ERR_OVERFLOW; }
 
-        if (LDG_UNLIKELY(mpmc_slot_get(q, pos & q->mask, &slot) != LDG_ERR_AOK)) { return LDG_ERR_MEM_BAD; }
+        for (n = 0; n < want; n++)
+        {
+            if (LDG_UNLIKELY(mpmc_slot_get(q, (pos + n) & q->mask, &slot) != LDG_ERR_AOK)) { return LDG_ERR_MEM_BAD; }
 
-        seq = LDG_LOAD_ACQUIRE(slot->seq);
+            seq = LDG_LOAD_ACQUIRE(slot->seq);
+            if (seq != pos + n + lap_off) { break; }
+        }
 
-        if (seq == pos) { if (LDG_CAS(&q->hd, &pos, pos + 1)) { break; } }
-        else if (seq < pos) { return LDG_ERR_FULL; }
+        if (n > 0) { if (LDG_CAS(cursor, &pos, pos + n)) { break; } }
+        else if (seq < pos + lap_off) { return lap_off ? LDG_ERR_EMPTY : LDG_ERR_FULL; }
         else { LDG_PAUSE; }
     }
 
     if (LDG_UNLIKELY(spin >= MPMC_MAX_SPIN)) { return LDG_ERR_AGAIN; }
 
+    *pos_out = pos;
+    *n_out = n;
+
+    return LDG_ERR_AOK;
+}
+
+uint32_t ldg_mpmc_push(ldg_mpmc_queue_t *q, const void *item)
+{
+    uint64_t pos = 0;
+    uint64_t n = 0;
+    uint32_t ret = 0;
+    ldg_mpmc_slot_t *slot = 0x0;
+
+    if (LDG_UNLIKELY(!q || !item)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    ret = mpmc_claim(q, &q->hd, 0, 1, &pos, &n);
+    if (ret != LDG_ERR_AOK) { return ret; }
+
+    if (LDG_UNLIKELY(mpmc_slot_get(q, pos & q->mask, &slot) != LDG_ERR_AOK)) { return LDG_ERR_MEM_BAD; }
+
     if (LDG_UNLIKELY(ldg_mem_secure_copy(slot->data, item, q->item_size) != LDG_ERR_AOK)) { return LDG_ERR_MEM_BAD; }
 
     LDG_STORE_RELEASE(slot->seq, pos + 1);
 
-    // signal outside lock; re-check-before-wait in mpmc_wait mitigates lost wakeup
-    ldg_cond_sig(&q->wait_cond);
+    // futex wake only when a consumer is parked
+    ldg_evcnt_notify(&q->wait_ec, 0);
 
     return LDG_ERR_AOK;
 }
@@ -170,39 +177,212 @@ uint32_t ldg_mpmc_push(ldg_mpmc_queue_t *q, const void *item)
 uint32_t ldg_mpmc_pop(ldg_mpmc_queue_t *q, void *item_out)
 {
     uint64_t pos = 0;
-    uint64_t seq = 0;
-    uint32_t spin = 0;
+    uint64_t n = 0;
+    uint32_t ret = 0;
     ldg_mpmc_slot_t *slot = 0x0;
 
     if (LDG_UNLIKELY(!q || !item_out)) { return LDG_ERR_FUNC_ARG_NULL; }
 
-    for (spin = 0; spin < MPMC_MAX_SPIN; spin++)
+    ret = mpmc_claim(q, &q->tail, 1, 1, &pos, &n);
+    if (ret != LDG_ERR_AOK) { return ret; }
+
+    if (LDG_UNLIKELY(mpmc_slot_get(q, pos & q->mask, &slot) != LDG_ERR_AOK)) { return LDG_ERR_MEM_BAD; }
+
+    if (LDG_UNLIKELY(ldg_mem_secure_copy(item_out, slot->data, q->item_size) != LDG_ERR_AOK)) { return LDG_ERR_MEM_BAD; }
+
+    LDG_STORE_RELEASE(slot->seq, pos + q->cap);
+
+    return LDG_ERR_AOK;
+}
+
+// claimed tickets are published in order; a partial batch rets AOK with *pushed < cunt
+uint32_t ldg_mpmc_push_n(ldg_mpmc_queue_t *q, const void *items, uint64_t cunt, uint64_t *pushed)
+{
+    uint64_t pos = 0;
+    uint64_t n = 0;
+    uint64_t i = 0;
+    uint32_t ret = 0;
+    const uint8_t *src = (const uint8_t *)items;
+    ldg_mpmc_slot_t *slot = 0x0;
+
+    if (LDG_UNLIKELY(!q || !items || !pushed)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    *pushed = 0;
+
+    if (LDG_UNLIKELY(cunt == 0)) { return LDG_ERR_FUNC_ARG_INVALID; }
+
+    if (LDG_UNLIKELY(q->item_size != 0 && cunt > UINT64_MAX / q->item_size)) { return LDG_ERR_OVERFLOW; }
+
+    if (cunt > q->cap) { cunt = q->cap; }
+
+    ret = mpmc_claim(q, &q->hd, 0, cunt, &pos, &n);
+    if (ret != LDG_ERR_AOK) { return ret; }
+
+    for (i = 0; i < n; i++)
     {
-        pos = LDG_LOAD_ACQUIRE(q->tail);
-        if (LDG_UNLIKELY(pos > UINT64_MAX - q->cap)) { return LDG_ERR_OVERFLOW; }
+        if (LDG_UNLIKELY(mpmc_slot_get(q, (pos + i) & q->mask, &slot) != LDG_ERR_AOK)) { return LDG_ERR_MEM_BAD; }
 
-        if (LDG_UNLIKELY(mpmc_slot_get(q, pos & q->mask, &slot) != LDG_ERR_AOK)) { return LDG_ERR_MEM_BAD; }
+        // tickets are already claimed; a failed copy still publishes so consumers never stall on a hole
+        if (LDG_UNLIKELY(ldg_mem_secure_copy(slot->data, src + (i * q->item_size), q->item_size) != LDG_ERR_AOK)) { ret = LDG_ERR_MEM_BAD; }
 
-        seq = LDG_LOAD_ACQUIRE(slot->seq);
+        LDG_STORE_RELEASE(slot->seq, pos + i + 1);
+    }
 
-        if (seq == pos + 1) { if (LDG_CAS(&q->tail, &pos, pos + 1)) { break; } }
-        else if (seq < pos + 1) { return LDG_ERR_EMPTY; }
-        else { LDG_PAUSE; }
+    *pushed = n;
+
+    // one wakeup per batch
+    ldg_evcnt_notify(&q->wait_ec, n > 1);
+
+    return ret;
+}
+
+uint32_t ldg_mpmc_pop_n(ldg_mpmc_queue_t *q, void *items_out, uint64_t cunt, uint64_t *popped)
+{
+    uint64_t pos = 0;
+    uint64_t n = 0;
+    uint64_t i = 0;
+    uint32_t ret = 0;
+    uint8_t *dst = (uint8_t *)items_out;
+    ldg_mpmc_slot_t *slot = 0x0;
+
+    if (LDG_UNLIKELY(!q || !items_out || !popped)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    *popped = 0;
+
+    if (LDG_UNLIKELY(cunt == 0)) { return LDG_ERR_FUNC_ARG_INVALID; }
+
+    if (LDG_UNLIKELY(q->item_size != 0 && cunt > UINT64_MAX / q->item_size)) { return LDG_ERR_OVERFLOW; }
+
+    if (cunt > q->cap) { cunt = q->cap; }
+
+    ret = mpmc_claim(q, &q->tail, 1, cunt, &pos, &n);
+    if (ret != LDG_ERR_AOK) { return ret; }
+
+    for (i = 0; i < n; i++)
+    {
+        if (LDG_UNLIKELY(mpmc_slot_get(q, (pos + i) & q->mask, &slot) != LDG_ERR_AOK)) { return LDG_ERR_MEM_BAD; }
+
+        if (LDG_UNLIKELY(ldg_mem_secure_copy(dst + (i * q->item_size), slot->data, q->item_size) != LDG_ERR_AOK)) { ret = LDG_ERR_MEM_BAD; }
+
+        LDG_STORE_RELEASE(slot->seq, pos + i + q->cap);
     }
 
-    if (LDG_UNLIKELY(spin >= MPMC_MAX_SPIN)) { return LDG_ERR_AGAIN; }
+    *popped = n;
 
-    if (LDG_UNLIKELY(ldg_mem_secure_copy(item_out, slot->data, q->item_size) != LDG_ERR_AOK)) { return LDG_ERR_MEM_BAD; }
+    return ret;
+}
 
-    LDG_STORE_RELEASE(slot->seq, pos + q->cap);
+// zero-copy; the slot stays owned by the caller until publish()
+uint32_t ldg_mpmc_claim_push(ldg_mpmc_queue_t *q, void **slot_out, uint64_t *ticket_out)
+{
+    uint64_t pos = 0;
+    uint64_t n = 0;
+    uint32_t ret = 0;
+    ldg_mpmc_slot_t *slot = 0x0;
+
+    if (LDG_UNLIKELY(!q || !slot_out || !ticket_out)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    *slot_out = 0x0;
+
+    ret = mpmc_claim(q, &q->hd, 0, 1, &pos, &n);
+    if (ret != LDG_ERR_AOK) { return ret; }
+
+    if (LDG_UNLIKELY(mpmc_slot_get(q, pos & q->mask, &slot) != LDG_ERR_AOK)) { return LDG_ERR_MEM_BAD; }
+
+    *slot_out = slot->data;
+    *ticket_out = pos;
+
+    return LDG_ERR_AOK;
+}
+
+uint32_t ldg_mpmc_publish(ldg_mpmc_queue_t *q, uint64_t ticket)
+{
+    ldg_mpmc_slot_t *slot = 0x0;
+
+    if (LDG_UNLIKELY(!q)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    if (LDG_UNLIKELY(mpmc_slot_get(q, ticket & q->mask, &slot) != LDG_ERR_AOK)) { return LDG_ERR_MEM_BAD; }
+
+    // claimed-but-unpublished slots hold seq == ticket; anything else is a stale or foreign ticket
+    if (LDG_UNLIKELY(LDG_LOAD_ACQUIRE(slot->seq) != ticket || ticket >= LDG_LOAD_ACQUIRE(q->hd))) { return LDG_ERR_INVALID; }
+
+    LDG_STORE_RELEASE(slot->seq, ticket + 1);
+
+    ldg_evcnt_notify(&q->wait_ec, 0);
+
+    return LDG_ERR_AOK;
+}
+
+// zero-copy; the slot stays readable by the caller until release()
+uint32_t ldg_mpmc_claim_pop(ldg_mpmc_queue_t *q, void **slot_out, uint64_t *ticket_out)
+{
+    uint64_t pos = 0;
+    uint64_t n = 0;
+    uint32_t ret = 0;
+    ldg_mpmc_slot_t *slot = 0x0;
+
+    if (LDG_UNLIKELY(!q || !slot_out || !ticket_out)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    *slot_out = 0x0;
+
+    ret = mpmc_claim(q, &q->tail, 1, 1, &pos, &n);
+    if (ret != LDG_ERR_AOK) { return ret; }
+
+    if (LDG_UNLIKELY(mpmc_slot_get(q, pos & q->mask, &slot) != LDG_ERR_AOK)) { return LDG_ERR_MEM_BAD; }
+
+    *slot_out = slot->data;
+    *ticket_out = pos;
 
     return LDG_ERR_AOK;
 }
 
+uint32_t ldg_mpmc_release(ldg_mpmc_queue_t *q, uint64_t ticket)
+{
+    ldg_mpmc_slot_t *slot = 0x0;
+
+    if (LDG_UNLIKELY(!q)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    if (LDG_UNLIKELY(mpmc_slot_get(q, ticket & q->mask, &slot) != LDG_ERR_AOK)) { return LDG_ERR_MEM_BAD; }
+
+    if (LDG_UNLIKELY(LDG_LOAD_ACQUIRE(slot->seq) != ticket + 1 || ticket >= LDG_LOAD_ACQUIRE(q->tail))) { return LDG_ERR_INVALID; }
+
+    LDG_STORE_RELEASE(slot->seq, ticket + q->cap);
+
+    return LDG_ERR_AOK;
+}
+
+// adaptive spin, then park on the evcnt; spin_lim grows when spinning finds an item and shrinks when it does not
+static uint32_t mpmc_wait_spin(ldg_mpmc_queue_t *q, void *item_out)
+{
+    uint32_t spin = 0;
+    uint32_t lim = 0;
+    uint32_t ret = LDG_ERR_EMPTY;
+
+    lim = LDG_RD_ONCE(q->spin_lim);
+
+    for (spin = 0; spin < lim; spin++)
+    {
+        LDG_PAUSE;
+
+        if (LDG_RD_ONCE(q->hd) == LDG_RD_ONCE(q->tail)) { continue; }
+
+        ret = ldg_mpmc_pop(q, item_out);
+        if (ret == LDG_ERR_AOK) { break; }
+
+        if (LDG_UNLIKELY(ret != LDG_ERR_EMPTY && ret != LDG_ERR_AGAIN)) { return ret; }
+    }
+
+    // racy by design; a lost update only skews the heuristic
+    if (ret == LDG_ERR_AOK) { LDG_WR_ONCE(q->spin_lim, (lim >= MPMC_WAIT_SPIN_MAX / 2) ? MPMC_WAIT_SPIN_MAX : lim * 2); }
+    else { LDG_WR_ONCE(q->spin_lim, (lim <= MPMC_WAIT_SPIN_MIN * 2) ? MPMC_WAIT_SPIN_MIN : lim / 2); }
+
+    return (ret == LDG_ERR_AGAIN) ? LDG_ERR_EMPTY : ret;
+}
+
 uint32_t ldg_mpmc_wait(ldg_mpmc_queue_t *q, void *item_out, uint64_t timeout_ms)
 {
     uint32_t ret = 0;
-    uint32_t iter = 0;
+    uint32_t key = 0;
     uint64_t deadline_ms = 0;
     uint64_t now_ms = 0;
     uint64_t remaining = 0;
@@ -214,40 +394,36 @@ uint32_t ldg_mpmc_wait(ldg_mpmc_queue_t *q, void *item_out, uint64_t timeout_ms)
 
     if (LDG_UNLIKELY(ret != LDG_ERR_EMPTY)) { return ret; }
 
+    // a poll; the adaptive spin below could outlast a zero timeout many times over
+    if (timeout_ms == 0) { return LDG_ERR_TIMEOUT; }
+
     now_ms = mpmc_monotonic_ms_get();
     if (LDG_UNLIKELY(now_ms == UINT64_MAX)) { return LDG_ERR_FUNC_ARG_INVALID; }
 
     if (LDG_UNLIKELY(timeout_ms > UINT64_MAX - now_ms)) { deadline_ms = UINT64_MAX; }
     else { deadline_ms = now_ms + timeout_ms; }
 
-    ret = ldg_mut_lock(&q->wait_mut);
-    if (LDG_UNLIKELY(ret != LDG_ERR_AOK)) { return LDG_ERR_BUSY; }
+    ret = mpmc_wait_spin(q, item_out);
+    if (ret != LDG_ERR_EMPTY) { return ret; }
 
-    for (iter = 0; iter < MPMC_WAIT_MAX_ITER; iter++)
+    for (;;)
     {
+        ldg_evcnt_prep(&q->wait_ec, &key);
+
         ret = ldg_mpmc_pop(q, item_out);
-        if (ret == LDG_ERR_AOK) { break; }
+        if (ret == LDG_ERR_AOK) { ldg_evcnt_cancel(&q->wait_ec); return LDG_ERR_AOK; }
 
-        if (LDG_UNLIKELY(ret != LDG_ERR_EMPTY)) { ldg_mut_unlock(&q->wait_mut); return ret; }
+        if (LDG_UNLIKELY(ret != LDG_ERR_EMPTY && ret != LDG_ERR_AGAIN)) { ldg_evcnt_cancel(&q->wait_ec); return ret; }
 
         now_ms = mpmc_monotonic_ms_get();
-        if (now_ms >= deadline_ms) { ldg_mut_unlock(&q->wait_mut); return LDG_ERR_TIMEOUT; }
+        if (now_ms >= deadline_ms) { ldg_evcnt_cancel(&q->wait_ec); return LDG_ERR_TIMEOUT; }
 
         remaining = deadline_ms - now_ms;
+        remaining = (remaining > LDG_FUTEX_WAIT_INFINITE / LDG_NS_PER_MS) ? LDG_FUTEX_WAIT_INFINITE : remaining * LDG_NS_PER_MS;
 
-        if (ldg_cond_timedwait(&q->wait_cond, &q->wait_mut, remaining) != LDG_ERR_AOK)
-        {
-            ldg_mut_unlock(&q->wait_mut);
-            return LDG_ERR_TIMEOUT;
-        }
+        // timeout, wake and spurious return all loop back to the re-check
+        ldg_evcnt_wait(&q->wait_ec, key, remaining);
     }
-
-    if (LDG_UNLIKELY(iter >= MPMC_WAIT_MAX_ITER)) { ldg_mut_unlock(&q->wait_mut); return LDG_ERR_TIMEOUT; }
-
-    // pop succeeded; unlock failure does not revoke the committed item
-    if (LDG_UNLIKELY(ldg_mut_unlock(&q->wait_mut) != LDG_ERR_AOK)) { return LDG_ERR_AOK; }
-
-    return LDG_ERR_AOK;
 }
 
 uint64_t ldg_mpmc_cunt_get(const ldg_mpmc_queue_t *q)
@@ -0,0 +1,450 @@
+#include <string.h>
+#include <time.h>
+
+#include <dangling/thread/mpmcu.h>
+#include <dangling/thread/mpmc.h>
+#include <dangling/core/err.h>
+#include <dangling/mem/secure.h>
+#include <dangling/mem/alloc.h>
+#include <dangling/core/macros.h>
+#include <dangling/arch/amd64/atomic.h>
+#include <dangling/arch/amd64/fence.h>
+
+#define MPMCU_MAX_SPIN 1024
+#define MPMCU_WAIT_SPIN_MIN 16
+#define MPMCU_WAIT_SPIN_MAX 4096
+
+// consumers stamp a slot with this once the copy-out is done; a segment recycles only when every slot carries it
+#define MPMCU_SEQ_DONE UINT64_MAX
+
+static uint64_t mpmcu_monotonic_ms_get(void)
+{
+    struct timespec ts = { 0 };
+
+    if (LDG_UNLIKELY(clock_gettime(CLOCK_MONOTONIC, &ts) != 0)) { return UINT64_MAX; }
+
+    return (uint64_t)ts.tv_sec * LDG_MS_PER_SEC + (uint64_t)ts.tv_nsec / LDG_NS_PER_MS;
+}
+
+// seg
+
+static ldg_mpmc_slot_t* mpmcu_slot_get(const ldg_mpmcu_queue_t *q, ldg_mpmcu_seg_t *seg, uint64_t idx)
+{
+    return (ldg_mpmc_slot_t *)(seg->slots + (idx * q->slot_size));
+}
+
+// seqs before base; a reader that acquires the new base also sees the new seqs
+static void mpmcu_seg_reset(ldg_mpmcu_queue_t *q, ldg_mpmcu_seg_t *seg, uint64_t base)
+{
+    uint64_t i = 0;
+
+    for (i = 0; i < q->seg_cap; i++) { LDG_STORE_RELEASE(mpmcu_slot_get(q, seg, i)->seq, base + i); }
+
+    LDG_WR_ONCE(seg->next, 0x0);
+    LDG_STORE_RELEASE(seg->base, base);
+}
+
+static uint8_t mpmcu_seg_drained_is(ldg_mpmcu_queue_t *q, ldg_mpmcu_seg_t *seg)
+{
+    uint64_t i = 0;
+
+    for (i = 0; i < q->seg_cap; i++) { if (LDG_LOAD_ACQUIRE(mpmcu_slot_get(q, seg, i)->seq) != MPMCU_SEQ_DONE) { return LDG_TRUTH_FALSE; } }
+
+    return LDG_TRUTH_TRUE;
+}
+
+// seg_mut held; free list first, then drained retirees, then the allocator
+static uint32_t mpmcu_seg_get(ldg_mpmcu_queue_t *q, ldg_mpmcu_seg_t **out)
+{
+    ldg_mpmcu_seg_t *seg = 0x0;
+    ldg_mpmcu_seg_t **link = 0x0;
+    uint32_t ret = 0;
+    void *seg_tmp = 0x0;
+
+    if (!q->free_list)
+    {
+        link = &q->retired_list;
+
+        while (*link)
+        {
+            seg = *link;
+
+            if (mpmcu_seg_drained_is(q, seg))
+            {
+                *link = seg->free_next;
+                seg->free_next = q->free_list;
+                q->free_list = seg;
+            }
+            else { link = &seg->free_next; }
+        }
+    }
+
+    if (q->free_list)
+    {
+        seg = q->free_list;
+        q->free_list = seg->free_next;
+        seg->free_next = 0x0;
+        *out = seg;
+
+        return LDG_ERR_AOK;
+    }
+
+    ret = ldg_mem_alloc(q->seg_size, &seg_tmp);
+    if (LDG_UNLIKELY(ret != LDG_ERR_AOK)) { return ret; }
+
+    seg = (ldg_mpmcu_seg_t *)seg_tmp;
+
+    if (LDG_UNLIKELY(memset(seg, 0, sizeof(ldg_mpmcu_seg_t)) != seg)) { ldg_mem_dealloc(seg); return LDG_ERR_MEM_BAD; }
+
+    // type-stable until shutdown; stale readers may still load base and seq from it
+    seg->all_next = q->all_list;
+    q->all_list = seg;
+    LDG_WR_ONCE(q->seg_cunt, q->seg_cunt + 1);
+
+    *out = seg;
+
+    return LDG_ERR_AOK;
+}
+
+// linking and publishing hd_seg happen under one lock, so a segment with a live base is always reachable
+static uint32_t mpmcu_hd_advance(ldg_mpmcu_queue_t *q, ldg_mpmcu_seg_t *seg)
+{
+    ldg_mpmcu_seg_t *next = 0x0;
+    uint32_t ret = 0;
+    uint8_t linked = 0;
+
+    ret = ldg_mut_lock(&q->seg_mut);
+    if (LDG_UNLIKELY(ret != LDG_ERR_AOK)) { return ret; }
+
+    if (LDG_RD_ONCE(q->hd_seg) == seg)
+    {
+        next = LDG_RD_ONCE(seg->next);
+
+        if (!next)
+        {
+            if (LDG_UNLIKELY(seg->base > UINT64_MAX - (2 * q->seg_cap))) { ret = LDG_ERR_OVERFLOW; }
+            else { ret = mpmcu_seg_get(q, &next); }
+
+            if (ret == LDG_ERR_AOK)
+            {
+                mpmcu_seg_reset(q, next, seg->base + q->seg_cap);
+                LDG_STORE_RELEASE(seg->next, next);
+                linked = 1;
+            }
+        }
+
+        if (ret == LDG_ERR_AOK) { LDG_STORE_RELEASE(q->hd_seg, next); }
+    }
+
+    ldg_mut_unlock(&q->seg_mut);
+
+    // a producer holding a stale pointer may have filled the new segment before it was reachable
+    if (linked) { ldg_evcnt_notify(&q->wait_ec, 1); }
+
+    return ret;
+}
+
+static uint32_t mpmcu_tail_advance(ldg_mpmcu_queue_t *q, ldg_mpmcu_seg_t *seg)
+{
+    ldg_mpmcu_seg_t *next = 0x0;
+    uint32_t ret = 0;
+
+    ret = ldg_mut_lock(&q->seg_mut);
+    if (LDG_UNLIKELY(ret != LDG_ERR_AOK)) { return ret; }
+
+    next = LDG_RD_ONCE(seg->next);
+
+    // every ticket in seg is claimed; late consumers may still be copying out, so it parks on the retired list
+    if (LDG_RD_ONCE(q->tail_seg) == seg && next)
+    {
+        LDG_STORE_RELEASE(q->tail_seg, next);
+        seg->free_next = q->retired_list;
+        q->retired_list = seg;
+    }
+
+    return ldg_mut_unlock(&q->seg_mut);
+}
+
+uint32_t ldg_mpmcu_init(ldg_mpmcu_queue_t *q, uint64_t item_size, uint64_t seg_cap)
+{
+    uint64_t slot_data_offset = 0;
+    ldg_mpmcu_seg_t *seg = 0x0;
+    uint32_t ret = 0;
+
+    if (LDG_UNLIKELY(!q)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    if (LDG_UNLIKELY(item_size == 0 || seg_cap == 0)) { return LDG_ERR_FUNC_ARG_INVALID; }
+
+    if (LDG_UNLIKELY(memset(q, 0, sizeof(ldg_mpmcu_queue_t)) != q)) { return LDG_ERR_MEM_BAD; }
+
+    slot_data_offset = LDG_AMD64_CACHE_LINE_WIDTH;
+    if (LDG_UNLIKELY(item_size > UINT64_MAX - slot_data_offset - LDG_AMD64_CACHE_LINE_WIDTH)) { return LDG_ERR_OVERFLOW; }
+
+    q->slot_size = LDG_ALIGNED_UP(slot_data_offset + item_size);
+    q->item_size = item_size;
+    q->seg_cap = seg_cap;
+
+    if (LDG_UNLIKELY(q->slot_size > (UINT64_MAX - sizeof(ldg_mpmcu_seg_t)) / seg_cap)) { return LDG_ERR_OVERFLOW; }
+
+    q->seg_size = sizeof(ldg_mpmcu_seg_t) + (q->slot_size * seg_cap);
+
+    ret = ldg_mut_init(&q->seg_mut, 0);
+    if (LDG_UNLIKELY(ret != LDG_ERR_AOK)) { return ret; }
+
+    ret = mpmcu_seg_get(q, &seg);
+    if (LDG_UNLIKELY(ret != LDG_ERR_AOK)) { ldg_mut_destroy(&q->seg_mut); return ret; }
+
+    mpmcu_seg_reset(q, seg, 0);
+
+    q->hd = 0;
+    q->tail = 0;
+    q->hd_seg = seg;
+    q->tail_seg = seg;
+    q->spin_lim = MPMCU_WAIT_SPIN_MIN;
+
+    ldg_evcnt_init(&q->wait_ec);
+
+    q->is_init = 1;
+
+    return LDG_ERR_AOK;
+}
+
+// items still queued are dropped; no producer or consumer may be active
+uint32_t ldg_mpmcu_shutdown(ldg_mpmcu_queue_t *q)
+{
+    uint32_t first_err = LDG_ERR_AOK;
+    uint32_t ret = 0;
+    ldg_mpmcu_seg_t *seg = 0x0;
+    ldg_mpmcu_seg_t *next = 0x0;
+
+    if (LDG_UNLIKELY(!q || !q->is_init)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    ret = ldg_evcnt_notify(&q->wait_ec, 1);
+    if (LDG_UNLIKELY(ret != LDG_ERR_AOK && first_err == LDG_ERR_AOK)) { first_err = ret; }
+
+    for (seg = q->all_list; seg; seg = next)
+    {
+        next = seg->all_next;
+        ldg_mem_dealloc(seg);
+    }
+
+    ret = ldg_mut_destroy(&q->seg_mut);
+    if (LDG_UNLIKELY(ret != LDG_ERR_AOK && first_err == LDG_ERR_AOK)) { first_err = ret; }
+
+    q->all_list = 0x0;
+    q->free_list = 0x0;
+    q->retired_list = 0x0;
+    q->hd_seg = 0x0;
+    q->tail_seg = 0x0;
+    q->seg_cunt = 0;
+    q->hd = 0;
+    q->tail = 0;
+    q->is_init = 0;
+
+    return first_err;
+}
+
+// a successful CAS on hd proves seg still holds pos; no per-op pin on the segment
+uint32_t ldg_mpmcu_push(ldg_mpmcu_queue_t *q, const void *item)
+{
+    ldg_mpmcu_seg_t *seg = 0x0;
+    ldg_mpmc_slot_t *slot = 0x0;
+    uint64_t pos = 0;
+    uint64_t base = 0;
+    uint64_t seq = 0;
+    uint32_t spin = 0;
+    uint32_t ret = 0;
+
+    if (LDG_UNLIKELY(!q || !item)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    for (spin = 0; spin < MPMCU_MAX_SPIN; spin++)
+    {
+        seg = LDG_LOAD_ACQUIRE(q->hd_seg);
+        pos = LDG_LOAD_ACQUIRE(q->hd);
+        base = LDG_LOAD_ACQUIRE(seg->base);
+
+        if (LDG_UNLIKELY(pos < base)) { LDG_PAUSE; continue; }
+
+        if (LDG_UNLIKELY(pos - base >= q->seg_cap))
+        {
+            ret = mpmcu_hd_advance(q, seg);
+            if (LDG_UNLIKELY(ret != LDG_ERR_AOK)) { return ret; }
+
+            continue;
+        }
+
+        slot = mpmcu_slot_get(q, seg, pos - base);
+        seq = LDG_LOAD_ACQUIRE(slot->seq);
+
+        if (seq == pos) { if (LDG_CAS(&q->hd, &pos, pos + 1)) { break; } }
+        else { LDG_PAUSE; }
+    }
+
+    if (LDG_UNLIKELY(spin >= MPMCU_MAX_SPIN)) { return LDG_ERR_AGAIN; }
+
+    // the ticket is claimed; a failed copy still publishes so consumers never stall on a hole
+    ret = LDG_ERR_AOK;
+    if (LDG_UNLIKELY(ldg_mem_secure_copy(slot->data, item, q->item_size) != LDG_ERR_AOK)) { ret = LDG_ERR_MEM_BAD; }
+
+    LDG_STORE_RELEASE(slot->seq, pos + 1);
+
+    ldg_evcnt_notify(&q->wait_ec, 0);
+
+    return ret;
+}
+
+uint32_t ldg_mpmcu_pop(ldg_mpmcu_queue_t *q, void *item_out)
+{
+    ldg_mpmcu_seg_t *seg = 0x0;
+    ldg_mpmc_slot_t *slot = 0x0;
+    uint64_t pos = 0;
+    uint64_t base = 0;
+    uint64_t seq = 0;
+    uint32_t spin = 0;
+    uint32_t ret = 0;
+
+    if (LDG_UNLIKELY(!q || !item_out)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    for (spin = 0; spin < MPMCU_MAX_SPIN; spin++)
+    {
+        seg = LDG_LOAD_ACQUIRE(q->tail_seg);
+        pos = LDG_LOAD_ACQUIRE(q->tail);
+        base = LDG_LOAD_ACQUIRE(seg->base);
+
+        if (LDG_UNLIKELY(pos < base)) { LDG_PAUSE; continue; }
+
+        if (LDG_UNLIKELY(pos - base >= q->seg_cap))
+        {
+            if (LDG_LOAD_ACQUIRE(seg->next))
+            {
+                ret = mpmcu_tail_advance(q, seg);
+                if (LDG_UNLIKELY(ret != LDG_ERR_AOK)) { return ret; }
+
+                continue;
+            }
+
+            // a recycled seg reads as unlinked; only trust the empty verdict for the live tail_seg
+            if (LDG_LOAD_ACQUIRE(q->tail_seg) == seg) { return LDG_ERR_EMPTY; }
+
+            continue;
+        }
+
+        slot = mpmcu_slot_get(q, seg, pos - base);
+        seq = LDG_LOAD_ACQUIRE(slot->seq);
+
+        if (seq == pos + 1) { if (LDG_CAS(&q->tail, &pos, pos + 1)) { break; } }
+        else if (seq < pos + 1) { return LDG_ERR_EMPTY; }
+        else { LDG_PAUSE; }
+    }
+
+    if (LDG_UNLIKELY(spin >= MPMCU_MAX_SPIN)) { return LDG_ERR_AGAIN; }
+
+    ret = LDG_ERR_AOK;
+    if (LDG_UNLIKELY(ldg_mem_secure_copy(item_out, slot->data, q->item_size) != LDG_ERR_AOK)) { ret = LDG_ERR_MEM_BAD; }
+
+    LDG_STORE_RELEASE(slot->seq, MPMCU_SEQ_DONE);
+
+    return ret;
+}
+
+static uint32_t mpmcu_wait_spin(ldg_mpmcu_queue_t *q, void *item_out)
+{
+    uint32_t spin = 0;
+    uint32_t lim = 0;
+    uint32_t ret = LDG_ERR_EMPTY;
+
+    lim = LDG_RD_ONCE(q->spin_lim);
+
+    for (spin = 0; spin < lim; spin++)
+    {
+        LDG_PAUSE;
+
+        if (LDG_RD_ONCE(q->hd) == LDG_RD_ONCE(q->tail)) { continue; }
+
+        ret = ldg_mpmcu_pop(q, item_out);
+        if (ret == LDG_ERR_AOK) { break; }
+
+        if (LDG_UNLIKELY(ret != LDG_ERR_EMPTY && ret != LDG_ERR_AGAIN)) { return ret; }
+    }
+
+    if (ret == LDG_ERR_AOK) { LDG_WR_ONCE(q->spin_lim, (lim >= MPMCU_WAIT_SPIN_MAX / 2) ? MPMCU_WAIT_SPIN_MAX : lim * 2); }
+    else { LDG_WR_ONCE(q->spin_lim, (lim <= MPMCU_WAIT_SPIN_MIN * 2) ? MPMCU_WAIT_SPIN_MIN : lim / 2); }
+
+    return (ret == LDG_ERR_AGAIN) ? LDG_ERR_EMPTY : ret;
+}
+
+uint32_t ldg_mpmcu_wait(ldg_mpmcu_queue_t *q, void *item_out, uint64_t timeout_ms)
+{
+    uint32_t ret = 0;
+    uint32_t key = 0;
+    uint64_t deadline_ms = 0;
+    uint64_t now_ms = 0;
+    uint64_t remaining = 0;
+
+    if (LDG_UNLIKELY(!q || !item_out)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    ret = ldg_mpmcu_pop(q, item_out);
+    if (ret == LDG_ERR_AOK) { return LDG_ERR_AOK; }
+
+    if (LDG_UNLIKELY(ret != LDG_ERR_EMPTY)) { return ret; }
+
+    // a poll; the adaptive spin below could outlast a zero timeout many times over
+    if (timeout_ms == 0) { return LDG_ERR_TIMEOUT; }
+
+    now_ms = mpmcu_monotonic_ms_get();
+    if (LDG_UNLIKELY(now_ms == UINT64_MAX)) { return LDG_ERR_FUNC_ARG_INVALID; }
+
+    if (LDG_UNLIKELY(timeout_ms > UINT64_MAX - now_ms)) { deadline_ms = UINT64_MAX; }
+    else { deadline_ms = now_ms + timeout_ms; }
+
+    ret = mpmcu_wait_spin(q, item_out);
+    if (ret != LDG_ERR_EMPTY) { return ret; }
+
+    for (;;)
+    {
+        ldg_evcnt_prep(&q->wait_ec, &key);
+
+        ret = ldg_mpmcu_pop(q, item_out);
+        if (ret == LDG_ERR_AOK) { ldg_evcnt_cancel(&q->wait_ec); return LDG_ERR_AOK; }
+
+        if (LDG_UNLIKELY(ret != LDG_ERR_EMPTY && ret != LDG_ERR_AGAIN)) { ldg_evcnt_cancel(&q->wait_ec); return ret; }
+
+        now_ms = mpmcu_monotonic_ms_get();
+        if (now_ms >= deadline_ms) { ldg_evcnt_cancel(&q->wait_ec); return LDG_ERR_TIMEOUT; }
+
+        remaining = deadline_ms - now_ms;
+        remaining = (remaining > LDG_FUTEX_WAIT_INFINITE / LDG_NS_PER_MS) ? LDG_FUTEX_WAIT_INFINITE : remaining * LDG_NS_PER_MS;
+
+        ldg_evcnt_wait(&q->wait_ec, key, remaining);
+    }
+}
+
+uint64_t ldg_mpmcu_cunt_get(const ldg_mpmcu_queue_t *q)
+{
+    uint64_t hd = 0;
+    uint64_t tail = 0;
+
+    if (LDG_UNLIKELY(!q)) { return UINT64_MAX; }
+
+    hd = LDG_LOAD_ACQUIRE(q->hd);
+    tail = LDG_LOAD_ACQUIRE(q->tail);
+
+    if (hd >= tail) { return hd - tail; }
+
+    return 0;
+}
+
+uint8_t ldg_mpmcu_empty_is(const ldg_mpmcu_queue_t *q)
+{
+    if (LDG_UNLIKELY(!q)) { return LDG_TRUTH_TRUE; }
+
+    return LDG_LOAD_ACQUIRE(q->hd) == LDG_LOAD_ACQUIRE(q->tail);
+}
+
+// segments ever allocated; flat once the queue has seen its peak depth
+uint64_t ldg_mpmcu_seg_cunt_get(const ldg_mpmcu_queue_t *q)
+{
+    if (LDG_UNLIKELY(!q)) { return UINT64_MAX; }
+
+    return LDG_RD_ONCE(q->seg_cunt);
+}
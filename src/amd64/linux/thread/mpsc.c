@@ -0,0 +1,196 @@
+#include <string.h>
+#include <sched.h>
+#include <time.h>
+
+#include <dangling/thread/mpsc.h>
+#include <dangling/core/err.h>
+#include <dangling/core/macros.h>
+#include <dangling/arch/amd64/atomic.h>
+#include <dangling/arch/amd64/fence.h>
+
+#define MPSC_WAIT_SPIN 64
+
+static uint64_t mpsc_monotonic_ms_get(void)
+{
+    struct timespec ts = { 0 };
+
+    if (LDG_UNLIKELY(clock_gettime(CLOCK_MONOTONIC, &ts) != 0)) { return UINT64_MAX; }
+
+    return (uint64_t)ts.tv_sec * LDG_MS_PER_SEC + (uint64_t)ts.tv_nsec / LDG_NS_PER_MS;
+}
+
+uint32_t ldg_mpsc_init(ldg_mpsc_queue_t *q)
+{
+    if (LDG_UNLIKELY(!q)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    if (LDG_UNLIKELY(memset(q, 0, sizeof(ldg_mpsc_queue_t)) != q)) { return LDG_ERR_MEM_BAD; }
+
+    q->stub.next = 0x0;
+    q->hd = &q->stub;
+    q->tail = &q->stub;
+
+    ldg_evcnt_init(&q->wait_ec);
+
+    q->is_init = 1;
+
+    return LDG_ERR_AOK;
+}
+
+// nodes are caller-owned; anything still linked is simply forgotten
+uint32_t ldg_mpsc_shutdown(ldg_mpsc_queue_t *q)
+{
+    uint32_t ret = 0;
+
+    if (LDG_UNLIKELY(!q || !q->is_init)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    ret = ldg_evcnt_notify(&q->wait_ec, 1);
+
+    q->stub.next = 0x0;
+    q->hd = &q->stub;
+    q->tail = &q->stub;
+    q->is_init = 0;
+
+    return ret;
+}
+
+static void mpsc_link(ldg_mpsc_queue_t *q, ldg_mpsc_node_t *node)
+{
+    ldg_mpsc_node_t *prev = 0x0;
+
+    LDG_WR_ONCE(node->next, 0x0);
+
+    // serialisation point for producers; the consumer cannot see node until prev->next is stored
+    prev = LDG_XCHG(q->hd, node);
+    LDG_STORE_RELEASE(prev->next, node);
+}
+
+// wait-free; one XCHG, plus a wake only when the consumer is parked
+uint32_t ldg_mpsc_push(ldg_mpsc_queue_t *q, ldg_mpsc_node_t *node)
+{
+    if (LDG_UNLIKELY(!q || !node)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    mpsc_link(q, node);
+
+    // the locked xchg already fenced; skip the extra mfence in evcnt_notify() on the common path
+    if (LDG_LIKELY(LDG_RD_ONCE(q->wait_ec.waiters) == 0)) { return LDG_ERR_AOK; }
+
+    return ldg_evcnt_notify(&q->wait_ec, 0);
+}
+
+// single consumer only; AGAIN means a producer is between its xchg and its link store
+uint32_t ldg_mpsc_pop(ldg_mpsc_queue_t *q, ldg_mpsc_node_t **node_out)
+{
+    ldg_mpsc_node_t *tail = 0x0;
+    ldg_mpsc_node_t *next = 0x0;
+
+    if (LDG_UNLIKELY(!q || !node_out)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    *node_out = 0x0;
+
+    tail = LDG_RD_ONCE(q->tail);
+    next = LDG_LOAD_ACQUIRE(tail->next);
+
+    if (tail == &q->stub)
+    {
+        if (!next) { return (LDG_LOAD_ACQUIRE(q->hd) == tail) ? LDG_ERR_EMPTY : LDG_ERR_AGAIN; }
+
+        LDG_WR_ONCE(q->tail, next);
+        tail = next;
+        next = LDG_LOAD_ACQUIRE(next->next);
+    }
+
+    if (next)
+    {
+        LDG_WR_ONCE(q->tail, next);
+        *node_out = tail;
+
+        return LDG_ERR_AOK;
+    }
+
+    if (LDG_LOAD_ACQUIRE(q->hd) != tail) { return LDG_ERR_AGAIN; }
+
+    // tail is the last node; re-queue the stub behind it so tail can be handed out
+    mpsc_link(q, &q->stub);
+
+    next = LDG_LOAD_ACQUIRE(tail->next);
+    if (!next) { return LDG_ERR_AGAIN; }
+
+    LDG_WR_ONCE(q->tail, next);
+    *node_out = tail;
+
+    return LDG_ERR_AOK;
+}
+
+static uint32_t mpsc_pop_spin(ldg_mpsc_queue_t *q, ldg_mpsc_node_t **node_out)
+{
+    uint32_t spin = 0;
+    uint32_t ret = 0;
+
+    for (spin = 0; spin < MPSC_WAIT_SPIN; spin++)
+    {
+        ret = ldg_mpsc_pop(q, node_out);
+        if (ret != LDG_ERR_AGAIN) { return ret; }
+
+        LDG_PAUSE;
+    }
+
+    return ret;
+}
+
+uint32_t ldg_mpsc_wait(ldg_mpsc_queue_t *q, ldg_mpsc_node_t **node_out, uint64_t timeout_ms)
+{
+    uint32_t ret = 0;
+    uint32_t key = 0;
+    uint64_t deadline_ms = 0;
+    uint64_t now_ms = 0;
+    uint64_t remaining = 0;
+
+    if (LDG_UNLIKELY(!q || !node_out)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    ret = mpsc_pop_spin(q, node_out);
+    if (ret == LDG_ERR_AOK) { return LDG_ERR_AOK; }
+
+    if (LDG_UNLIKELY(ret != LDG_ERR_EMPTY && ret != LDG_ERR_AGAIN)) { return ret; }
+
+    now_ms = mpsc_monotonic_ms_get();
+    if (LDG_UNLIKELY(now_ms == UINT64_MAX)) { return LDG_ERR_FUNC_ARG_INVALID; }
+
+    if (LDG_UNLIKELY(timeout_ms > UINT64_MAX - now_ms)) { deadline_ms = UINT64_MAX; }
+    else { deadline_ms = now_ms + timeout_ms; }
+
+    for (;;)
+    {
+        ldg_evcnt_prep(&q->wait_ec, &key);
+
+        ret = mpsc_pop_spin(q, node_out);
+        if (ret == LDG_ERR_AOK) { ldg_evcnt_cancel(&q->wait_ec); return LDG_ERR_AOK; }
+
+        if (LDG_UNLIKELY(ret != LDG_ERR_EMPTY && ret != LDG_ERR_AGAIN)) { ldg_evcnt_cancel(&q->wait_ec); return ret; }
+
+        now_ms = mpsc_monotonic_ms_get();
+        if (now_ms >= deadline_ms) { ldg_evcnt_cancel(&q->wait_ec); return LDG_ERR_TIMEOUT; }
+
+        // a half-linked push may have read waiters before our prep landed; never park on AGAIN, but give a
+        // producer preempted between its xchg and its link store the cpu instead of spinning against it
+        if (ret == LDG_ERR_AGAIN)
+        {
+            ldg_evcnt_cancel(&q->wait_ec);
+            sched_yield();
+            continue;
+        }
+
+        remaining = deadline_ms - now_ms;
+        remaining = (remaining > LDG_FUTEX_WAIT_INFINITE / LDG_NS_PER_MS) ? LDG_FUTEX_WAIT_INFINITE : remaining * LDG_NS_PER_MS;
+
+        ldg_evcnt_wait(&q->wait_ec, key, remaining);
+    }
+}
+
+// approximate from any thread; exact only from the consumer
+uint8_t ldg_mpsc_empty_is(const ldg_mpsc_queue_t *q)
+{
+    if (LDG_UNLIKELY(!q)) { return LDG_TRUTH_TRUE; }
+
+    // a tail other than the stub is itself an undelivered node
+    return LDG_LOAD_ACQUIRE(q->tail) == &q->stub && LDG_LOAD_ACQUIRE(q->hd) == &q->stub;
+}
@@ -0,0 +1,336 @@
+#define _GNU_SOURCE
+
+#include <stddef.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+
+#include <dangling/thread/pcnt.h>
+#include <dangling/core/err.h>
+#include <dangling/mem/alloc.h>
+#include <dangling/core/macros.h>
+#include <dangling/core/arith.h>
+#include <dangling/arch/amd64/atomic.h>
+#include <dangling/arch/amd64/fence.h>
+
+#ifndef SYS_rseq
+#define SYS_rseq 334
+#endif
+
+#define PCNT_RSEQ_LEN 32
+#define PCNT_RSEQ_FLAG_UNREGISTER 1
+
+// glibc >= 2.35 registers an rseq area for every thread (unless tuned off) and publishes where it lives
+extern const ptrdiff_t __rseq_offset __attribute__((weak));
+extern const unsigned int __rseq_size __attribute__((weak));
+
+enum
+{
+    PCNT_MODE_UNPROBED = 0,
+    PCNT_MODE_LIBC,
+    PCNT_MODE_OWN
+};
+
+enum
+{
+    PCNT_OWN_UNPROBED = 0,
+    PCNT_OWN_REGISTERED,
+    PCNT_OWN_NONE
+};
+
+enum
+{
+    PCNT_ADD_DONE = 0,
+    PCNT_ADD_ABORTED,
+    PCNT_ADD_NO_ROW
+};
+
+// the kernel's struct rseq, up to the fields this file touches
+typedef struct pcnt_rseq
+{
+    uint32_t cpu_id_start;
+    uint32_t cpu_id;
+    uint64_t rseq_cs;
+    uint32_t flags;
+    uint8_t pudding0[12];
+} LDG_ALIGNED pcnt_rseq_t;
+
+// whether libc owns rseq is the same for every thread, so it is probed once per process
+static uint32_t pcnt_mode = PCNT_MODE_UNPROBED;
+
+// without libc each thread registers its own area, and drops it from a key destructor before its tls goes away
+static pthread_key_t pcnt_key;
+static uint32_t pcnt_key_state = 0;
+static __thread pcnt_rseq_t pcnt_rseq_own;
+static __thread uint8_t pcnt_own_state = PCNT_OWN_UNPROBED;
+
+// 1-based id handing out thread rows round robin; 0 until the thread first needs one
+static uint32_t pcnt_thread_next = 0;
+static __thread uint32_t pcnt_thread_id = 0;
+
+static uint8_t *pcnt_tp_get(void)
+{
+    uint8_t *tp = 0x0;
+
+    __asm__ ("movq %%fs:0, %0" : "=r" (tp));
+
+    return tp;
+}
+
+static void pcnt_key_dtor(void *arg)
+{
+    syscall(SYS_rseq, arg, PCNT_RSEQ_LEN, PCNT_RSEQ_FLAG_UNREGISTER, LDG_PCNT_RSEQ_SIG);
+}
+
+// 0 none yet, 1 being created, 2 ready, 3 failed
+static uint8_t pcnt_key_ready_is(void)
+{
+    uint32_t state = LDG_LOAD_ACQUIRE(pcnt_key_state);
+    uint32_t expected = 0;
+
+    while (state < 2)
+    {
+        expected = 0;
+
+        if (state == 0 && LDG_CAS(&pcnt_key_state, &expected, 1))
+        {
+            LDG_STORE_RELEASE(pcnt_key_state, (pthread_key_create(&pcnt_key, pcnt_key_dtor) == 0) ? 2u : 3u);
+        }
+        else
+        {
+            sched_yield();
+        }
+
+        state = LDG_LOAD_ACQUIRE(pcnt_key_state);
+    }
+
+    return state == 2;
+}
+
+static pcnt_rseq_t *pcnt_rseq_get(void)
+{
+    uint32_t mode = LDG_RD_ONCE(pcnt_mode);
+
+    if (LDG_UNLIKELY(mode == PCNT_MODE_UNPROBED))
+    {
+        mode = (&__rseq_size && __rseq_size != 0) ? PCNT_MODE_LIBC : PCNT_MODE_OWN;
+        LDG_WR_ONCE(pcnt_mode, mode);
+    }
+
+    if (LDG_LIKELY(mode == PCNT_MODE_LIBC)) { return (pcnt_rseq_t *)(pcnt_tp_get() + __rseq_offset); }
+
+    if (LDG_UNLIKELY(pcnt_own_state == PCNT_OWN_UNPROBED))
+    {
+        pcnt_own_state = PCNT_OWN_NONE;
+
+        if (pcnt_key_ready_is() && syscall(SYS_rseq, &pcnt_rseq_own, PCNT_RSEQ_LEN, 0, LDG_PCNT_RSEQ_SIG) == 0)
+        {
+            pcnt_own_state = PCNT_OWN_REGISTERED;
+
+            if (LDG_UNLIKELY(pthread_setspecific(pcnt_key, &pcnt_rseq_own) != 0))
+            {
+                pcnt_key_dtor(&pcnt_rseq_own);
+                pcnt_own_state = PCNT_OWN_NONE;
+            }
+        }
+    }
+
+    return (pcnt_own_state == PCNT_OWN_REGISTERED) ? &pcnt_rseq_own : 0x0;
+}
+
+// [1, 2) is the critical section and the add at its end is the commit. the kernel restarts at 4 if the thread
+// is preempted, migrated or signalled inside it, so the row read from cpu_id is still this cpu's row at the add.
+// an unregistered area reads cpu_id as ~0, which fails the bound check
+static uint32_t pcnt_rseq_add(pcnt_rseq_t *rs, uint64_t *col, uint64_t stride_bytes, uint32_t cpu_row_cunt, uint64_t val)
+{
+    __asm__ __volatile__ goto (
+        ".pushsection __rseq_cs, \"aw\"\n\t"
+        ".balign 32\n\t"
+        "3:\n\t"
+        ".long 0x0, 0x0\n\t"
+        ".quad 1f, (2f - 1f), 4f\n\t"
+        ".popsection\n\t"
+        "leaq 3b(%%rip), %%rax\n\t"
+        "movq %%rax, %[cs]\n\t"
+        "1:\n\t"
+        "movl %[cpu], %%eax\n\t"
+        "cmpl %[cpu_row_cunt], %%eax\n\t"
+        "jae %l[no_row]\n\t"
+        "imulq %[stride], %%rax\n\t"
+        "addq %[val], (%[col], %%rax, 1)\n\t"
+        "2:\n\t"
+        ".pushsection __rseq_failure, \"ax\"\n\t"
+        // ud1 with the signature as its displacement, so the bytes before the handler still decode
+        ".byte 0x0f, 0xb9, 0x3d\n\t"
+        ".long 0x53053053\n\t"
+        "4:\n\t"
+        "jmp %l[aborted]\n\t"
+        ".popsection\n\t"
+        :
+        : [cs] "m" (rs->rseq_cs), [cpu] "m" (rs->cpu_id), [cpu_row_cunt] "r" (cpu_row_cunt),
+          [stride] "r" (stride_bytes), [val] "r" (val), [col] "r" (col)
+        : "memory", "cc", "rax"
+        : aborted, no_row);
+
+    return PCNT_ADD_DONE;
+
+aborted:
+    return PCNT_ADD_ABORTED;
+
+no_row:
+    return PCNT_ADD_NO_ROW;
+}
+
+static uint32_t pcnt_thread_row_get(const ldg_pcnt_t *p)
+{
+    while (LDG_UNLIKELY(pcnt_thread_id == 0)) { pcnt_thread_id = LDG_ADD_FETCH(pcnt_thread_next, 1); }
+
+    return p->cpu_row_cunt + (pcnt_thread_id - 1) % p->thread_row_cunt;
+}
+
+uint32_t ldg_pcnt_create(uint32_t cunt, ldg_pcnt_t **out)
+{
+    ldg_pcnt_t *p = 0x0;
+    void *tmp = 0x0;
+    int64_t cpu_cunt = 0;
+    uint64_t stride = 0;
+    uint64_t rows_size = 0;
+    uint32_t ret = 0;
+
+    if (LDG_UNLIKELY(!out)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    *out = 0x0;
+
+    if (LDG_UNLIKELY(cunt == 0)) { return LDG_ERR_FUNC_ARG_INVALID; }
+
+    // cpu ids run up to the configured cpu cunt, not the online one
+    cpu_cunt = (int64_t)sysconf(_SC_NPROCESSORS_CONF);
+    if (LDG_UNLIKELY(cpu_cunt <= 0 || cpu_cunt > (int64_t)(UINT32_MAX / 2))) { return LDG_ERR_UNSUPPORTED; }
+
+    stride = ((uint64_t)cunt * sizeof(uint64_t) + LDG_AMD64_CACHE_LINE_WIDTH - 1) & ~((uint64_t)LDG_AMD64_CACHE_LINE_WIDTH - 1);
+
+    if (LDG_UNLIKELY(ldg_arith_64_mul(stride, (uint64_t)cpu_cunt * 2, &rows_size) != LDG_ERR_AOK)) { return LDG_ERR_OVERFLOW; }
+
+    ret = ldg_mem_alloc((uint64_t)sizeof(ldg_pcnt_t), &tmp);
+    if (LDG_UNLIKELY(ret != LDG_ERR_AOK)) { return ret; }
+
+    p = (ldg_pcnt_t *)tmp;
+
+    if (LDG_UNLIKELY(memset(p, 0, sizeof(ldg_pcnt_t)) != p)) { ldg_mem_dealloc(p); return LDG_ERR_MEM_BAD; }
+
+    ret = ldg_mem_alloc(rows_size, &tmp);
+    if (LDG_UNLIKELY(ret != LDG_ERR_AOK)) { ldg_mem_dealloc(p); return ret; }
+
+    if (LDG_UNLIKELY(memset(tmp, 0, rows_size) != tmp)) { ldg_mem_dealloc(tmp); ldg_mem_dealloc(p); return LDG_ERR_MEM_BAD; }
+
+    p->rows = (uint64_t *)tmp;
+    p->stride = stride / sizeof(uint64_t);
+    p->cunt = cunt;
+    p->cpu_row_cunt = (uint32_t)cpu_cunt;
+    p->thread_row_cunt = (uint32_t)cpu_cunt;
+    p->row_cunt = (uint32_t)cpu_cunt * 2;
+
+    *out = p;
+
+    return LDG_ERR_AOK;
+}
+
+uint32_t ldg_pcnt_destroy(ldg_pcnt_t **p)
+{
+    if (LDG_UNLIKELY(!p || !*p)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    ldg_mem_dealloc((*p)->rows);
+    ldg_mem_dealloc(*p);
+    *p = 0x0;
+
+    return LDG_ERR_AOK;
+}
+
+uint32_t ldg_pcnt_add(ldg_pcnt_t *p, uint32_t idx, uint64_t val)
+{
+    pcnt_rseq_t *rs = 0x0;
+    uint64_t *col = 0x0;
+    uint32_t r = PCNT_ADD_NO_ROW;
+
+    if (LDG_UNLIKELY(!p)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    if (LDG_UNLIKELY(idx >= p->cunt)) { return LDG_ERR_FUNC_ARG_INVALID; }
+
+    col = p->rows + idx;
+
+    rs = pcnt_rseq_get();
+    if (LDG_LIKELY(rs))
+    {
+        // an abort only means the thread moved or was interrupted; go again on whichever cpu it is on now
+        do { r = pcnt_rseq_add(rs, col, p->stride * sizeof(uint64_t), p->cpu_row_cunt, val); } while (r == PCNT_ADD_ABORTED);
+
+        if (LDG_LIKELY(r == PCNT_ADD_DONE)) { return LDG_ERR_AOK; }
+    }
+
+    LDG_FETCH_ADD_RELAXED(col[(uint64_t)pcnt_thread_row_get(p) * p->stride], val);
+
+    return LDG_ERR_AOK;
+}
+
+uint32_t ldg_pcnt_sub(ldg_pcnt_t *p, uint32_t idx, uint64_t val)
+{
+    return ldg_pcnt_add(p, idx, (uint64_t)0 - val);
+}
+
+// rows are summed one at a time, so the result is not a snapshot of any single instant
+uint64_t ldg_pcnt_sum_get(const ldg_pcnt_t *p, uint32_t idx)
+{
+    uint64_t sum = 0;
+    uint32_t r = 0;
+
+    if (LDG_UNLIKELY(!p || idx >= p->cunt)) { return UINT64_MAX; }
+
+    for (r = 0; r < p->row_cunt; r++) { sum += LDG_RD_ONCE(p->rows[(uint64_t)r * p->stride + idx]); }
+
+    return sum;
+}
+
+// sums the first cap counters in one pass over the rows
+uint32_t ldg_pcnt_sums_get(const ldg_pcnt_t *p, uint64_t *out, uint32_t cap)
+{
+    const uint64_t *row = 0x0;
+    uint32_t cunt = 0;
+    uint32_t r = 0;
+    uint32_t i = 0;
+
+    if (LDG_UNLIKELY(!p || !out)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    cunt = (cap < p->cunt) ? cap : p->cunt;
+
+    if (LDG_UNLIKELY(memset(out, 0, (uint64_t)cunt * sizeof(uint64_t)) != out)) { return LDG_ERR_MEM_BAD; }
+
+    for (r = 0; r < p->row_cunt; r++)
+    {
+        row = p->rows + (uint64_t)r * p->stride;
+
+        for (i = 0; i < cunt; i++) { out[i] += LDG_RD_ONCE(row[i]); }
+    }
+
+    return LDG_ERR_AOK;
+}
+
+uint32_t ldg_pcnt_rst(ldg_pcnt_t *p)
+{
+    uint64_t i = 0;
+
+    if (LDG_UNLIKELY(!p)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    for (i = 0; i < (uint64_t)p->row_cunt * p->stride; i++) { LDG_WR_ONCE(p->rows[i], 0); }
+
+    return LDG_ERR_AOK;
+}
+
+// libc leaves cpu_id negative on a thread whose registration failed
+uint8_t ldg_pcnt_rseq_is(void)
+{
+    pcnt_rseq_t *rs = pcnt_rseq_get();
+
+    return rs && (int32_t)LDG_RD_ONCE(rs->cpu_id) >= 0;
+}
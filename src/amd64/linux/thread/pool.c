@@ -1,38 +1,383 @@
+#define _GNU_SOURCE
+
 #include <string.h>
 #include <pthread.h>
+#include <sched.h>
+#include <time.h>
 
 #include <dangling/thread/pool.h>
-#include <dangling/thread/mpmc.h>
+#include <dangling/thread/mpmcu.h>
+#include <dangling/thread/deque.h>
+#include <dangling/sys/info.h>
 #include <dangling/core/err.h>
 #include <dangling/mem/alloc.h>
+#include <dangling/mem/secure.h>
+#include <dangling/core/arith.h>
 #include <dangling/core/macros.h>
 #include <dangling/arch/amd64/atomic.h>
 #include <dangling/arch/amd64/fence.h>
+#include <dangling/arch/amd64/tsc.h>
+
+#define THREAD_POOL_IDLE_YIELD 4
+
+#define THREAD_POOL_PAR_NODE_MAX 64
+
+// a worker's own tele record has one writer, so a plain add published untorn is enough
+#define THREAD_POOL_TELE_ADD(x, val) LDG_WR_ONCE((x), (x) + (val))
+
+// split-off range; the node is held until its task finishes so its acc slot has one writer
+typedef struct ldg_thread_pool_par_node
+{
+    void *job;
+    uint64_t begin;
+    uint64_t end;
+} ldg_thread_pool_par_node_t;
+
+// lives on the caller's stack; join returns only once pending drains
+typedef struct ldg_thread_pool_par_job
+{
+    ldg_thread_pool_t *pool;
+    ldg_thread_pool_range_func_t range_fn;
+    ldg_thread_pool_reduce_func_t reduce_fn;
+    void *ctx;
+    uint8_t *accs;
+    uint64_t acc_size;
+    uint64_t grain;
+    uint64_t node_free;
+    uint64_t node_used;
+    uint32_t pending;
+    uint32_t err;
+    ldg_thread_pool_par_node_t nodes[THREAD_POOL_PAR_NODE_MAX];
+} ldg_thread_pool_par_job_t;
+
+// set on worker entry; lets submit() from inside a task reach the worker's own deque
+static __thread ldg_thread_pool_worker_t *thread_pool_worker_self = 0x0;
+
+static uint64_t thread_pool_monotonic_ms_get(void)
+{
+    struct timespec ts = { 0 };
+
+    if (LDG_UNLIKELY(clock_gettime(CLOCK_MONOTONIC, &ts) != 0)) { return UINT64_MAX; }
+
+    return (uint64_t)ts.tv_sec * LDG_MS_PER_SEC + (uint64_t)ts.tv_nsec / LDG_NS_PER_MS;
+}
+
+static uint64_t thread_pool_monotonic_ns_get(void)
+{
+    struct timespec ts = { 0 };
+
+    if (LDG_UNLIKELY(clock_gettime(CLOCK_MONOTONIC, &ts) != 0)) { return UINT64_MAX; }
+
+    return (uint64_t)ts.tv_sec * LDG_NS_PER_SEC + (uint64_t)ts.tv_nsec;
+}
+
+static uint32_t thread_pool_rng_next(uint32_t *state)
+{
+    uint32_t x = *state;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+
+    return x;
+}
+
+// smooth weighted round robin over the non-empty lanes, so a backlogged lane waits at most sum(weights) picks;
+// without credit (a helper that is not a worker) lanes are taken in strict priority order
+static uint32_t thread_pool_lane_pop(ldg_thread_pool_t *pool, int32_t *credit, ldg_thread_pool_task_t *task)
+{
+    ldg_thread_pool_lane_t *lane = 0x0;
+    uint32_t best = LDG_THREAD_POOL_PRIO_CUNT;
+    uint32_t i = 0;
+    int32_t total = 0;
+
+    for (i = 0; i < LDG_THREAD_POOL_PRIO_CUNT; i++)
+    {
+        lane = &pool->lanes[i];
+
+        if (ldg_mpmcu_empty_is(lane->queue)) { continue; }
+
+        if (!credit) { best = i; break; }
+
+        credit[i] += (int32_t)lane->weight;
+        total += (int32_t)lane->weight;
+
+        if (best == LDG_THREAD_POOL_PRIO_CUNT || credit[i] > credit[best]) { best = i; }
+    }
+
+    if (best == LDG_THREAD_POOL_PRIO_CUNT) { return LDG_ERR_EMPTY; }
+
+    if (credit) { credit[best] -= total; }
+
+    if (ldg_mpmcu_pop(pool->lanes[best].queue, task) == LDG_ERR_AOK) { return LDG_ERR_AOK; }
+
+    // lost the chosen lane to another consumer; any task beats going idle
+    for (i = 0; i < LDG_THREAD_POOL_PRIO_CUNT; i++) { if (ldg_mpmcu_pop(pool->lanes[i].queue, task) == LDG_ERR_AOK) { return LDG_ERR_AOK; } }
+
+    return LDG_ERR_EMPTY;
+}
+
+// telemetry
+
+static uint8_t thread_pool_tele_shared_is(const ldg_thread_pool_t *pool, const ldg_thread_pool_worker_tele_t *tele)
+{
+    return tele == &pool->tele[pool->worker_cunt];
+}
+
+static uint32_t thread_pool_wait_bucket(uint64_t cycles)
+{
+    uint32_t b = 0;
+
+    if (cycles == 0) { return 0; }
+
+    b = 63 - (uint32_t)__builtin_clzll(cycles);
+
+    return (b < LDG_THREAD_POOL_WAIT_HIST_BUCKETS) ? b : LDG_THREAD_POOL_WAIT_HIST_BUCKETS - 1;
+}
+
+static void thread_pool_tele_wait(ldg_thread_pool_worker_tele_t *tele, uint8_t shared, uint64_t wait)
+{
+    uint64_t *bucket = &tele->wait_hist[thread_pool_wait_bucket(wait)];
+    uint64_t max = 0;
+
+    if (shared)
+    {
+        LDG_FETCH_ADD_RELAXED(tele->wait_cycles, wait);
+        LDG_FETCH_ADD_RELAXED(*bucket, 1);
+
+        max = LDG_RD_ONCE(tele->wait_max_cycles);
+
+        while (wait > max && !LDG_CAS(&tele->wait_max_cycles, &max, wait)) { }
+
+        return;
+    }
+
+    THREAD_POOL_TELE_ADD(tele->wait_cycles, wait);
+    THREAD_POOL_TELE_ADD(*bucket, 1);
+
+    if (wait > tele->wait_max_cycles) { LDG_WR_ONCE(tele->wait_max_cycles, wait); }
+}
+
+static void thread_pool_tele_read(const ldg_thread_pool_worker_tele_t *tele, ldg_thread_pool_worker_stats_t *out)
+{
+    uint32_t i = 0;
+
+    out->executed = LDG_RD_ONCE(tele->executed);
+    out->busy_cycles = LDG_RD_ONCE(tele->busy_cycles);
+    out->idle_cycles = LDG_RD_ONCE(tele->idle_cycles);
+    out->wait_cycles = LDG_RD_ONCE(tele->wait_cycles);
+    out->wait_max_cycles = LDG_RD_ONCE(tele->wait_max_cycles);
+
+    for (i = 0; i < LDG_THREAD_POOL_WAIT_HIST_BUCKETS; i++) { out->wait_hist[i] = LDG_RD_ONCE(tele->wait_hist[i]); }
+}
+
+// a task past its deadline is not run; the expired hook sees it instead so the submitter can report or retry.
+// the queue wait is logged into tele for every task, busy and idle only around a worker's outermost run
+static void thread_pool_task_run(ldg_thread_pool_t *pool, ldg_thread_pool_worker_tele_t *tele, const ldg_thread_pool_task_t *task)
+{
+    uint64_t now_ns = 0;
+    uint64_t start_tsc = ldg_tsc_sample(0x0);
+    uint64_t end_tsc = 0;
+    uint8_t shared = thread_pool_tele_shared_is(pool, tele);
+    uint8_t is_expired = 0;
+
+    // tscs are synchronized across cores on the parts this targets, but never trust that to the cycle
+    thread_pool_tele_wait(tele, shared, (start_tsc > task->submit_tsc) ? start_tsc - task->submit_tsc : 0);
+
+    if (!shared)
+    {
+        if (tele->nest == 0 && start_tsc > tele->last_tsc) { THREAD_POOL_TELE_ADD(tele->idle_cycles, start_tsc - tele->last_tsc); }
+
+        tele->nest++;
+    }
+
+    if (LDG_UNLIKELY(task->deadline_ns != 0))
+    {
+        now_ns = thread_pool_monotonic_ns_get();
+
+        if (now_ns != UINT64_MAX && now_ns > task->deadline_ns)
+        {
+            LDG_FETCH_ADD(pool->lanes[task->prio].expired, 1);
+
+            if (pool->expired) { pool->expired(task->func, task->arg, now_ns - task->deadline_ns); }
+
+            is_expired = 1;
+        }
+    }
+
+    if (!is_expired && task->func) { task->func(task->arg); }
+
+    if (shared)
+    {
+        if (!is_expired) { LDG_FETCH_ADD_RELAXED(tele->executed, 1); }
+
+        return;
+    }
+
+    if (!is_expired) { THREAD_POOL_TELE_ADD(tele->executed, 1); }
+
+    if (--tele->nest == 0)
+    {
+        end_tsc = ldg_tsc_sample(0x0);
+        THREAD_POOL_TELE_ADD(tele->busy_cycles, end_tsc - start_tsc);
+        LDG_WR_ONCE(tele->last_tsc, end_tsc);
+    }
+}
+
+// own deque (lifo), then the lanes, then one sweep over the other workers from a random start
+static uint32_t thread_pool_task_find(ldg_thread_pool_t *pool, uint32_t self, uint32_t *rng, ldg_thread_pool_task_t *task)
+{
+    uint32_t i = 0;
+    uint32_t start = 0;
+    uint32_t victim = 0;
+
+    if (ldg_deque_pop(&pool->deques[self], task) == LDG_ERR_AOK) { return LDG_ERR_AOK; }
+
+    if (thread_pool_lane_pop(pool, pool->workers[self].credit, task) == LDG_ERR_AOK) { return LDG_ERR_AOK; }
+
+    start = thread_pool_rng_next(rng) % pool->worker_cunt;
+
+    for (i = 0; i < pool->worker_cunt; i++)
+    {
+        victim = start + i;
+        if (victim >= pool->worker_cunt) { victim -= pool->worker_cunt; }
+
+        if (victim == self) { continue; }
+
+        // a lost race means the victim still had work for someone; move on rather than retry
+        if (ldg_deque_steal(&pool->deques[victim], task) == LDG_ERR_AOK) { return LDG_ERR_AOK; }
+    }
+
+    return LDG_ERR_EMPTY;
+}
+
+static uint32_t thread_pool_task_get(ldg_thread_pool_t *pool, uint32_t self, uint32_t *rng, ldg_thread_pool_task_t *task)
+{
+    if (pool->deques) { return thread_pool_task_find(pool, self, rng, task); }
+
+    return thread_pool_lane_pop(pool, pool->workers[self].credit, task);
+}
+
+// claims one parked worker and wakes only that one
+static void thread_pool_wake_one(ldg_thread_pool_t *pool)
+{
+    ldg_thread_pool_worker_t *worker = 0x0;
+    uint64_t mask = LDG_RD_ONCE(pool->parked);
+    uint64_t bit = 0;
+
+    while (mask)
+    {
+        bit = mask & (~mask + 1);
+
+        if (LDG_CAS(&pool->parked, &mask, mask & ~bit))
+        {
+            worker = &pool->workers[__builtin_ctzll(bit)];
+            LDG_STORE_RELEASE(worker->park, 1);
+            ldg_futex_wake(&worker->park, 1, 0);
+            return;
+        }
+    }
+}
+
+// submit side; the fence orders the task publish before the parked read and pairs with the OR in idle_step()
+static void thread_pool_notify(ldg_thread_pool_t *pool)
+{
+    LDG_SMP_MB();
+
+    if (LDG_LIKELY(LDG_RD_ONCE(pool->parked) == 0)) { return; }
+
+    thread_pool_wake_one(pool);
+}
+
+// one idle round: spin, yield, then advertise in parked and sleep until a submit or stop() claims us
+static void thread_pool_idle_step(ldg_thread_pool_t *pool, ldg_thread_pool_worker_t *worker, uint32_t *rng)
+{
+    ldg_thread_pool_task_t task = { 0 };
+    uint64_t bit = (uint64_t)1 << worker->id;
+    uint32_t spin = 0;
+    uint32_t i = 0;
+    uint32_t ret = LDG_ERR_EMPTY;
+
+    spin = (pool->idle == LDG_THREAD_POOL_IDLE_PARK) ? 0 : pool->idle_spin;
+
+    for (i = 0; i < spin && ret != LDG_ERR_AOK; i++)
+    {
+        LDG_PAUSE;
+        ret = thread_pool_task_get(pool, worker->id, rng, &task);
+    }
+
+    if (pool->idle == LDG_THREAD_POOL_IDLE_SPIN_YIELD_PARK)
+    {
+        for (i = 0; i < THREAD_POOL_IDLE_YIELD && ret != LDG_ERR_AOK; i++)
+        {
+            sched_yield();
+            ret = thread_pool_task_get(pool, worker->id, rng, &task);
+        }
+    }
+
+    if (ret != LDG_ERR_AOK && pool->idle != LDG_THREAD_POOL_IDLE_SPIN)
+    {
+        LDG_WR_ONCE(worker->park, 0);
+        LDG_FETCH_OR(pool->parked, bit);
+
+        // re-check after advertising; a submit that read parked before our OR has its task visible by now
+        ret = thread_pool_task_get(pool, worker->id, rng, &task);
+
+        if (ret != LDG_ERR_AOK && !LDG_RD_ONCE(worker->should_stop)) { ldg_futex_wait(&worker->park, 0, LDG_FUTEX_WAIT_INFINITE, 0); }
+
+        // bit already gone means a waker claimed us; if we did not sleep through it, hand the wake on
+        if (!(LDG_FETCH_AND(pool->parked, ~bit) & bit) && ret == LDG_ERR_AOK) { thread_pool_wake_one(pool); }
+    }
+
+    if (ret == LDG_ERR_AOK) { thread_pool_task_run(pool, &pool->tele[worker->id], &task); }
+}
 
 static void* ldg_thread_pool_worker_enter(void *arg)
 {
     ldg_thread_pool_worker_t *worker = (ldg_thread_pool_worker_t *)arg;
     ldg_thread_pool_t *pool = 0x0;
+    ldg_thread_pool_worker_tele_t *tele = 0x0;
     ldg_thread_pool_task_t task = { 0 };
-    uint32_t ret = 0;
+    uint64_t now_tsc = 0;
+    uint32_t rng = 0;
 
     if (LDG_UNLIKELY(!worker)) { return 0x0; }
 
     pool = (ldg_thread_pool_t *)worker->pool;
+    tele = &pool->tele[worker->id];
+    thread_pool_worker_self = worker;
+    rng = (worker->id * 0x9E3779B9u) | 1;
+
+    LDG_WR_ONCE(tele->last_tsc, ldg_tsc_sample(0x0));
 
     LDG_WR_ONCE(worker->state, LDG_THREAD_POOL_WORKER_RUNNING);
 
     while (!LDG_RD_ONCE(worker->should_stop))
     {
-        if (LDG_RD_ONCE(pool->task_queue))
+        // start() mode; amd64 TSO, pthread_create implies full barrier before worker entry
+        if (worker->func)
         {
-            ret = ldg_mpmc_wait(pool->task_queue, &task, LDG_THREAD_POOL_WAIT_TIMEOUT_MS);
-            if (ret == LDG_ERR_AOK && task.func) { task.func(task.arg); }
+            worker->func(worker->func_arg);
+            LDG_PAUSE;
+            continue;
         }
-        // amd64 TSO; pthread_create implies full barrier before worker entry
-        else if (worker->func) { worker->func(worker->func_arg); }
 
-        LDG_PAUSE;
+        if (thread_pool_task_get(pool, worker->id, &rng, &task) == LDG_ERR_AOK)
+        {
+            thread_pool_task_run(pool, tele, &task);
+            continue;
+        }
+
+        thread_pool_idle_step(pool, worker, &rng);
+    }
+
+    // start() mode runs no tasks, so there is no idle time to close out
+    if (!worker->func)
+    {
+        now_tsc = ldg_tsc_sample(0x0);
+        if (now_tsc > tele->last_tsc) { THREAD_POOL_TELE_ADD(tele->idle_cycles, now_tsc - tele->last_tsc); }
+        LDG_WR_ONCE(tele->last_tsc, now_tsc);
     }
 
     LDG_WR_ONCE(worker->state, LDG_THREAD_POOL_WORKER_STOPPED);
@@ -40,12 +385,148 @@ static void* ldg_thread_pool_worker_enter(void *arg)
     return 0x0;
 }
 
-// caller shall pair with shutdown(); handles are not reclaimed otherwise
-uint32_t ldg_thread_pool_init(ldg_thread_pool_t *pool, uint32_t worker_cunt)
+// placement
+
+// ascending key is placement order; cpu_id < LDG_SYS_CPU_MAX fits the low 16 bits
+static uint64_t thread_pool_place_key(const ldg_sys_cpu_topo_t *t, uint32_t place)
+{
+    if (place == LDG_THREAD_POOL_PLACE_SCATTER) { return ((uint64_t)t->smt_idx << 48) | ((uint64_t)(t->core_id & 0xFFFF) << 32) | ((uint64_t)(t->pkg_id & 0xFFFF) << 16) | (uint64_t)t->cpu_id; }
+
+    return ((uint64_t)(t->pkg_id & 0xFFFF) << 48) | ((uint64_t)(t->core_id & 0xFFFF) << 32) | ((uint64_t)t->smt_idx << 16) | (uint64_t)t->cpu_id;
+}
+
+static uint32_t thread_pool_place_filter(ldg_sys_cpu_topo_t *topo, uint32_t n, uint32_t place, uint8_t isolated, uint8_t iso_strict)
+{
+    uint32_t i = 0;
+    uint32_t m = 0;
+
+    for (i = 0; i < n; i++)
+    {
+        if (iso_strict && topo[i].isolated != isolated) { continue; }
+
+        if (place == LDG_THREAD_POOL_PLACE_NO_SMT && topo[i].smt_idx != 0) { continue; }
+
+        topo[m++] = topo[i];
+    }
+
+    return m;
+}
+
+// fills workers[].core_id; a host without topology info keeps core_id = id and runs unpinned
+static uint32_t thread_pool_place(ldg_thread_pool_t *pool, const ldg_thread_pool_desc_t *desc)
 {
+    ldg_sys_cpu_topo_t *topo = 0x0;
+    ldg_sys_cpu_topo_t tmp = { 0 };
+    void *topo_tmp = 0x0;
+    uint32_t n = 0;
+    uint32_t m = 0;
     uint32_t i = 0;
+    uint32_t j = 0;
     uint32_t ret = 0;
+
+    if (desc->place == LDG_THREAD_POOL_PLACE_NONE) { return LDG_ERR_AOK; }
+
+    if (desc->place == LDG_THREAD_POOL_PLACE_LIST)
+    {
+        if (LDG_UNLIKELY(!desc->cpu_list || desc->cpu_list_cunt == 0)) { return LDG_ERR_FUNC_ARG_INVALID; }
+
+        for (i = 0; i < pool->worker_cunt; i++) { pool->workers[i].core_id = desc->cpu_list[i % desc->cpu_list_cunt]; }
+
+        pool->pinned = 1;
+
+        return LDG_ERR_AOK;
+    }
+
+    ret = ldg_mem_alloc((uint64_t)sizeof(ldg_sys_cpu_topo_t) * LDG_SYS_CPU_MAX, &topo_tmp);
+    if (LDG_UNLIKELY(ret != LDG_ERR_AOK)) { return ret; }
+
+    topo = (ldg_sys_cpu_topo_t *)topo_tmp;
+
+    ret = ldg_sys_cpu_topo_get(topo, LDG_SYS_CPU_MAX, &n);
+    if (ret != LDG_ERR_AOK && ret != LDG_ERR_FULL) { ldg_mem_dealloc(topo); return desc->isolated ? ret : LDG_ERR_AOK; }
+
+    // isolated cores are opt-in; everyone else stays off them unless nothing else is left
+    m = thread_pool_place_filter(topo, n, desc->place, desc->isolated, 1);
+    if (m == 0 && !desc->isolated) { m = thread_pool_place_filter(topo, n, desc->place, 0, 0); }
+
+    if (m == 0) { ldg_mem_dealloc(topo); return desc->isolated ? LDG_ERR_NOT_FOUND : LDG_ERR_AOK; }
+
+    for (i = 1; i < m; i++)
+    {
+        tmp = topo[i];
+
+        for (j = i; j > 0 && thread_pool_place_key(&topo[j - 1], desc->place) > thread_pool_place_key(&tmp, desc->place); j--) { topo[j] = topo[j - 1]; }
+
+        topo[j] = tmp;
+    }
+
+    for (i = 0; i < pool->worker_cunt; i++) { pool->workers[i].core_id = topo[i % m].cpu_id; }
+
+    pool->pinned = 1;
+
+    ldg_mem_dealloc(topo);
+
+    return LDG_ERR_AOK;
+}
+
+static uint32_t thread_pool_queue_create(ldg_mpmcu_queue_t **out)
+{
     void *queue_tmp = 0x0;
+    uint32_t ret = 0;
+
+    ret = ldg_mem_alloc((uint64_t)sizeof(ldg_mpmcu_queue_t), &queue_tmp);
+    if (LDG_UNLIKELY(ret != LDG_ERR_AOK)) { return ret; }
+
+    ret = ldg_mpmcu_init((ldg_mpmcu_queue_t *)queue_tmp, sizeof(ldg_thread_pool_task_t), LDG_THREAD_POOL_TASK_QUEUE_CAPACITY);
+    if (LDG_UNLIKELY(ret != LDG_ERR_AOK)) { ldg_mem_dealloc(queue_tmp); return ret; }
+
+    *out = (ldg_mpmcu_queue_t *)queue_tmp;
+
+    return LDG_ERR_AOK;
+}
+
+// frees the lanes and task_queue; safe on a partially built pool
+static uint32_t thread_pool_queues_release(ldg_thread_pool_t *pool)
+{
+    uint32_t i = 0;
+    uint32_t first_err = LDG_ERR_AOK;
+    uint32_t ret = 0;
+
+    if (pool->lanes)
+    {
+        for (i = 0; i < LDG_THREAD_POOL_PRIO_CUNT; i++)
+        {
+            if (i == LDG_THREAD_POOL_PRIO_NORMAL || !pool->lanes[i].queue) { continue; }
+
+            ret = ldg_mpmcu_shutdown(pool->lanes[i].queue);
+            if (LDG_UNLIKELY(ret != LDG_ERR_AOK && first_err == LDG_ERR_AOK)) { first_err = ret; }
+
+            ldg_mem_dealloc(pool->lanes[i].queue);
+        }
+
+        ldg_mem_dealloc(pool->lanes);
+        pool->lanes = 0x0;
+    }
+
+    if (pool->task_queue)
+    {
+        ret = ldg_mpmcu_shutdown(pool->task_queue);
+        if (LDG_UNLIKELY(ret != LDG_ERR_AOK && first_err == LDG_ERR_AOK)) { first_err = ret; }
+
+        ldg_mem_dealloc(pool->task_queue);
+        pool->task_queue = 0x0;
+    }
+
+    return first_err;
+}
+
+static uint32_t thread_pool_base_init(ldg_thread_pool_t *pool, uint32_t worker_cunt)
+{
+    uint32_t i = 0;
+    uint32_t ret = 0;
+    void *lanes_tmp = 0x0;
+    void *tele_tmp = 0x0;
+    uint64_t tele_size = 0;
 
     LDG_BOOL_ASSERT(sizeof(pthread_t) <= sizeof(uint64_t));
 
@@ -55,19 +536,40 @@ uint32_t ldg_thread_pool_init(ldg_thread_pool_t *pool, uint32_t worker_cunt)
 
     if (LDG_UNLIKELY(memset(pool, 0, sizeof(ldg_thread_pool_t)) != pool)) { return LDG_ERR_MEM_BAD; }
 
-    ret = ldg_mem_alloc((uint64_t)sizeof(ldg_mpmc_queue_t), &queue_tmp);
+    ret = thread_pool_queue_create(&pool->task_queue);
     if (LDG_UNLIKELY(ret != LDG_ERR_AOK)) { return ret; }
 
-    pool->task_queue = (ldg_mpmc_queue_t *)queue_tmp;
+    ret = ldg_mem_alloc((uint64_t)sizeof(ldg_thread_pool_lane_t) * LDG_THREAD_POOL_PRIO_CUNT, &lanes_tmp);
+    if (LDG_UNLIKELY(ret != LDG_ERR_AOK)) { thread_pool_queues_release(pool); return ret; }
+
+    pool->lanes = (ldg_thread_pool_lane_t *)lanes_tmp;
 
-    ret = ldg_mpmc_init(pool->task_queue, sizeof(ldg_thread_pool_task_t), LDG_THREAD_POOL_TASK_QUEUE_CAPACITY);
-    if (LDG_UNLIKELY(ret != LDG_ERR_AOK))
+    if (LDG_UNLIKELY(memset(pool->lanes, 0, sizeof(ldg_thread_pool_lane_t) * LDG_THREAD_POOL_PRIO_CUNT) != pool->lanes)) { thread_pool_queues_release(pool); return LDG_ERR_MEM_BAD; }
+
+    pool->lanes[LDG_THREAD_POOL_PRIO_HIGH].weight = LDG_THREAD_POOL_WEIGHT_HIGH;
+    pool->lanes[LDG_THREAD_POOL_PRIO_NORMAL].weight = LDG_THREAD_POOL_WEIGHT_NORMAL;
+    pool->lanes[LDG_THREAD_POOL_PRIO_BG].weight = LDG_THREAD_POOL_WEIGHT_BG;
+
+    // the normal lane is task_queue itself so plain submit() traffic takes the same path as before
+    pool->lanes[LDG_THREAD_POOL_PRIO_NORMAL].queue = pool->task_queue;
+
+    for (i = 0; i < LDG_THREAD_POOL_PRIO_CUNT; i++)
     {
-        ldg_mem_dealloc(pool->task_queue);
-        pool->task_queue = 0x0;
-        return ret;
+        if (i == LDG_THREAD_POOL_PRIO_NORMAL) { continue; }
+
+        ret = thread_pool_queue_create(&pool->lanes[i].queue);
+        if (LDG_UNLIKELY(ret != LDG_ERR_AOK)) { thread_pool_queues_release(pool); return ret; }
     }
 
+    tele_size = (uint64_t)sizeof(ldg_thread_pool_worker_tele_t) * (worker_cunt + 1);
+
+    ret = ldg_mem_alloc(tele_size, &tele_tmp);
+    if (LDG_UNLIKELY(ret != LDG_ERR_AOK)) { thread_pool_queues_release(pool); return ret; }
+
+    if (LDG_UNLIKELY(memset(tele_tmp, 0, tele_size) != tele_tmp)) { ldg_mem_dealloc(tele_tmp); thread_pool_queues_release(pool); return LDG_ERR_MEM_BAD; }
+
+    pool->tele = (ldg_thread_pool_worker_tele_t *)tele_tmp;
+
     pool->worker_cunt = worker_cunt;
 
     for (i = 0; i < worker_cunt; i++)
@@ -84,8 +586,70 @@ uint32_t ldg_thread_pool_init(ldg_thread_pool_t *pool, uint32_t worker_cunt)
     return LDG_ERR_AOK;
 }
 
+// caller shall pair with shutdown(); handles are not reclaimed otherwise
+uint32_t ldg_thread_pool_init(ldg_thread_pool_t *pool, uint32_t worker_cunt)
+{
+    ldg_thread_pool_desc_t desc = { 0 };
+
+    desc.worker_cunt = worker_cunt;
+
+    return ldg_thread_pool_init_desc(pool, &desc);
+}
+
+uint32_t ldg_thread_pool_init_desc(ldg_thread_pool_t *pool, const ldg_thread_pool_desc_t *desc)
+{
+    uint32_t i = 0;
+    uint32_t ret = 0;
+    uint64_t deque_cap = 0;
+    void *deques_tmp = 0x0;
+
+    if (LDG_UNLIKELY(!pool || !desc)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    if (LDG_UNLIKELY(desc->sched > LDG_THREAD_POOL_SCHED_STEAL)) { return LDG_ERR_FUNC_ARG_INVALID; }
+
+    deque_cap = desc->deque_cap ? desc->deque_cap : LDG_THREAD_POOL_DEQUE_CAPACITY;
+    if (LDG_UNLIKELY((deque_cap & (deque_cap - 1)) != 0)) { return LDG_ERR_FUNC_ARG_INVALID; }
+
+    if (LDG_UNLIKELY(desc->place > LDG_THREAD_POOL_PLACE_LIST || desc->idle > LDG_THREAD_POOL_IDLE_PARK)) { return LDG_ERR_FUNC_ARG_INVALID; }
+
+    // credits are int32; keep the per-pick sum far from overflow
+    for (i = 0; i < LDG_THREAD_POOL_PRIO_CUNT; i++) { if (LDG_UNLIKELY(desc->lane_weight[i] > UINT16_MAX)) { return LDG_ERR_FUNC_ARG_INVALID; } }
+
+    ret = thread_pool_base_init(pool, desc->worker_cunt);
+    if (LDG_UNLIKELY(ret != LDG_ERR_AOK)) { return ret; }
+
+    pool->sched = (uint8_t)desc->sched;
+    pool->rt_prio = desc->rt_prio;
+    pool->idle = (uint8_t)desc->idle;
+    pool->idle_spin = desc->idle_spin ? desc->idle_spin : LDG_THREAD_POOL_IDLE_SPIN_CUNT;
+    pool->expired = desc->expired;
+
+    for (i = 0; i < LDG_THREAD_POOL_PRIO_CUNT; i++) { if (desc->lane_weight[i]) { pool->lanes[i].weight = desc->lane_weight[i]; } }
+
+    ret = thread_pool_place(pool, desc);
+    if (LDG_UNLIKELY(ret != LDG_ERR_AOK)) { ldg_thread_pool_shutdown(pool); return ret; }
+
+    if (desc->sched != LDG_THREAD_POOL_SCHED_STEAL) { return LDG_ERR_AOK; }
+
+    ret = ldg_mem_alloc((uint64_t)sizeof(ldg_deque_t) * pool->worker_cunt, &deques_tmp);
+    if (LDG_UNLIKELY(ret != LDG_ERR_AOK)) { ldg_thread_pool_shutdown(pool); return ret; }
+
+    pool->deques = (ldg_deque_t *)deques_tmp;
+
+    if (LDG_UNLIKELY(memset(pool->deques, 0, sizeof(ldg_deque_t) * pool->worker_cunt) != pool->deques)) { ldg_thread_pool_shutdown(pool); return LDG_ERR_MEM_BAD; }
+
+    for (i = 0; i < pool->worker_cunt; i++)
+    {
+        ret = ldg_deque_init(&pool->deques[i], sizeof(ldg_thread_pool_task_t), deque_cap);
+        if (LDG_UNLIKELY(ret != LDG_ERR_AOK)) { ldg_thread_pool_shutdown(pool); return ret; }
+    }
+
+    return LDG_ERR_AOK;
+}
+
 uint32_t ldg_thread_pool_shutdown(ldg_thread_pool_t *pool)
 {
+    uint32_t i = 0;
     uint32_t first_err = LDG_ERR_AOK;
     uint32_t ret = 0;
 
@@ -94,19 +658,72 @@ uint32_t ldg_thread_pool_shutdown(ldg_thread_pool_t *pool)
     ret = ldg_thread_pool_stop(pool);
     if (LDG_UNLIKELY(ret != LDG_ERR_AOK && first_err == LDG_ERR_AOK)) { first_err = ret; }
 
-    if (pool->task_queue)
+    ret = thread_pool_queues_release(pool);
+    if (LDG_UNLIKELY(ret != LDG_ERR_AOK && first_err == LDG_ERR_AOK)) { first_err = ret; }
+
+    if (pool->deques)
+    {
+        for (i = 0; i < pool->worker_cunt; i++)
+        {
+            ret = ldg_deque_shutdown(&pool->deques[i]);
+            if (LDG_UNLIKELY(ret != LDG_ERR_AOK && first_err == LDG_ERR_AOK)) { first_err = ret; }
+        }
+
+        ldg_mem_dealloc(pool->deques);
+        pool->deques = 0x0;
+    }
+
+    if (pool->tele)
+    {
+        ldg_mem_dealloc(pool->tele);
+        pool->tele = 0x0;
+    }
+
+    pool->submit_mode = 0;
+    pool->sched = LDG_THREAD_POOL_SCHED_SHARED;
+    pool->pinned = 0;
+    pool->rt_prio = 0;
+    pool->expired = 0x0;
+    pool->is_init = 0;
+
+    return first_err;
+}
+
+// pinning and SCHED_FIFO are best effort; without CAP_SYS_NICE or inside a foreign cpuset the worker starts unplaced
+static uint32_t thread_pool_worker_spawn(ldg_thread_pool_t *pool, ldg_thread_pool_worker_t *worker)
+{
+    pthread_t tid = 0;
+    pthread_attr_t attr = { 0 };
+    cpu_set_t set = { 0 };
+    struct sched_param sp = { 0 };
+    int32_t ret = 0;
+
+    if (LDG_UNLIKELY(pthread_attr_init(&attr) != 0)) { return LDG_ERR_FUNC_ARG_INVALID; }
+
+    if (pool->pinned && worker->core_id < CPU_SETSIZE)
     {
-        ret = ldg_mpmc_shutdown(pool->task_queue);
-        if (LDG_UNLIKELY(ret != LDG_ERR_AOK && first_err == LDG_ERR_AOK)) { first_err = ret; }
+        CPU_ZERO(&set);
+        CPU_SET(worker->core_id, &set);
+        pthread_attr_setaffinity_np(&attr, sizeof(set), &set);
+    }
 
-        ldg_mem_dealloc(pool->task_queue);
-        pool->task_queue = 0x0;
+    if (pool->rt_prio)
+    {
+        sp.sched_priority = (int32_t)pool->rt_prio;
+        pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+        pthread_attr_setschedpolicy(&attr, SCHED_FIFO);
+        pthread_attr_setschedparam(&attr, &sp);
     }
 
-    pool->submit_mode = 0;
-    pool->is_init = 0;
+    // amd64: pthread_t fits in uint64_t; validated by BOOL_ASSERT in init
+    ret = (int32_t)pthread_create(&tid, &attr, ldg_thread_pool_worker_enter, worker);
+    pthread_attr_destroy(&attr);
 
-    return first_err;
+    if (ret != 0 && (pool->pinned || pool->rt_prio)) { ret = (int32_t)pthread_create(&tid, 0x0, ldg_thread_pool_worker_enter, worker); }
+
+    worker->handle = (ret == 0) ? (uint64_t)tid : 0;
+
+    return (ret == 0) ? LDG_ERR_AOK : LDG_ERR_FUNC_ARG_INVALID;
 }
 
 // start() and submit() are mutually exclusive; concurrent use is undefined
@@ -114,9 +731,6 @@ uint32_t ldg_thread_pool_start(ldg_thread_pool_t *pool, ldg_thread_pool_worker_f
 {
     uint32_t i = 0;
     uint32_t started = 0;
-    int32_t ret = 0;
-    pthread_t tid = 0;
-    pthread_attr_t attr = { 0 };
 
     if (LDG_UNLIKELY(!pool || !pool->is_init || !func)) { return LDG_ERR_FUNC_ARG_NULL; }
 
@@ -133,14 +747,7 @@ uint32_t ldg_thread_pool_start(ldg_thread_pool_t *pool, ldg_thread_pool_worker_f
         LDG_WR_ONCE(pool->workers[i].state, LDG_THREAD_POOL_WORKER_STARTING);
         LDG_WR_ONCE(pool->workers[i].should_stop, 0);
 
-        if (LDG_UNLIKELY(pthread_attr_init(&attr) != 0)) { LDG_WR_ONCE(pool->workers[i].state, LDG_THREAD_POOL_WORKER_STOPPED); continue; }
-
-        // amd64: pthread_t fits in uint64_t; validated by BOOL_ASSERT in init
-        ret = (int32_t)pthread_create(&tid, &attr, ldg_thread_pool_worker_enter, &pool->workers[i]);
-        pool->workers[i].handle = (ret == 0) ? (uint64_t)tid : 0;
-        pthread_attr_destroy(&attr);
-
-        if (LDG_UNLIKELY(ret != 0))
+        if (LDG_UNLIKELY(thread_pool_worker_spawn(pool, &pool->workers[i]) != LDG_ERR_AOK))
         {
             LDG_WR_ONCE(pool->workers[i].state, LDG_THREAD_POOL_WORKER_STOPPED);
             continue;
@@ -156,6 +763,7 @@ uint32_t ldg_thread_pool_start(ldg_thread_pool_t *pool, ldg_thread_pool_worker_f
 
 uint32_t ldg_thread_pool_stop(ldg_thread_pool_t *pool)
 {
+    uint64_t parked = 0;
     uint32_t i = 0;
     uint32_t first_err = LDG_ERR_AOK;
     uint32_t ret = 0;
@@ -168,11 +776,16 @@ uint32_t ldg_thread_pool_stop(ldg_thread_pool_t *pool)
 
     LDG_SMP_MB();
 
-    // single bcast; workers re-check should_stop every WAIT_TIMEOUT_MS on timedwait expiry
-    if (pool->task_queue)
-    {
-        ret = ldg_cond_bcast(&pool->task_queue->wait_cond);
-        if (LDG_UNLIKELY(ret != LDG_ERR_AOK && first_err == LDG_ERR_AOK)) { first_err = ret; }
+    // claim every parked worker at once; one that parks after this sees should_stop before sleeping
+    parked = LDG_XCHG(pool->parked, 0);
+
+    for (i = 0; i < pool->worker_cunt; i++) { if (parked & ((uint64_t)1 << i))
+        {
+            LDG_STORE_RELEASE(pool->workers[i].park, 1);
+
+            ret = ldg_futex_wake(&pool->workers[i].park, 1, 0);
+            if (LDG_UNLIKELY(ret != LDG_ERR_AOK && first_err == LDG_ERR_AOK)) { first_err = ret; }
+        }
     }
 
     for (i = 0; i < pool->worker_cunt; i++) { if (pool->workers[i].handle != 0)
@@ -199,9 +812,6 @@ static uint32_t thread_pool_submit_workers_start(ldg_thread_pool_t *pool)
 {
     uint32_t i = 0;
     uint32_t started = 0;
-    int32_t ret = 0;
-    pthread_t tid = 0;
-    pthread_attr_t attr = { 0 };
 
     for (i = 0; i < pool->worker_cunt; i++)
     {
@@ -211,13 +821,7 @@ static uint32_t thread_pool_submit_workers_start(ldg_thread_pool_t *pool)
         LDG_WR_ONCE(pool->workers[i].state, LDG_THREAD_POOL_WORKER_STARTING);
         LDG_WR_ONCE(pool->workers[i].should_stop, 0);
 
-        if (LDG_UNLIKELY(pthread_attr_init(&attr) != 0)) { LDG_WR_ONCE(pool->workers[i].state, LDG_THREAD_POOL_WORKER_STOPPED); continue; }
-
-        ret = (int32_t)pthread_create(&tid, &attr, ldg_thread_pool_worker_enter, &pool->workers[i]);
-        pool->workers[i].handle = (ret == 0) ? (uint64_t)tid : 0;
-        pthread_attr_destroy(&attr);
-
-        if (LDG_UNLIKELY(ret != 0))
+        if (LDG_UNLIKELY(thread_pool_worker_spawn(pool, &pool->workers[i]) != LDG_ERR_AOK))
         {
             LDG_WR_ONCE(pool->workers[i].state, LDG_THREAD_POOL_WORKER_STOPPED);
             continue;
@@ -231,13 +835,34 @@ static uint32_t thread_pool_submit_workers_start(ldg_thread_pool_t *pool)
     return LDG_ERR_AOK;
 }
 
-// mutually exclusive with start(); tasks queue before workers reach mpmc_wait
+// mutually exclusive with start(); tasks queue before workers start, a parked worker is woken per submit
 uint32_t ldg_thread_pool_submit(ldg_thread_pool_t *pool, ldg_thread_pool_worker_func_t func, void *arg)
+{
+    return ldg_thread_pool_submit_prio(pool, func, arg, LDG_THREAD_POOL_PRIO_NORMAL, 0);
+}
+
+// deadline_ns is a queueing budget relative to now, 0 for none; an expired task goes to desc.expired instead of running
+uint32_t ldg_thread_pool_submit_prio(ldg_thread_pool_t *pool, ldg_thread_pool_worker_func_t func, void *arg, uint32_t prio, uint64_t deadline_ns)
 {
     ldg_thread_pool_task_t task = { 0 };
+    ldg_thread_pool_lane_t *lane = 0x0;
+    uint64_t now_ns = 0;
+    uint64_t depth = 0;
+    uint64_t peak = 0;
+    uint32_t ret = 0;
 
     if (LDG_UNLIKELY(!pool || !pool->is_init || !func)) { return LDG_ERR_FUNC_ARG_NULL; }
 
+    if (LDG_UNLIKELY(prio >= LDG_THREAD_POOL_PRIO_CUNT)) { return LDG_ERR_FUNC_ARG_INVALID; }
+
+    if (deadline_ns)
+    {
+        now_ns = thread_pool_monotonic_ns_get();
+        if (LDG_UNLIKELY(now_ns == UINT64_MAX)) { return LDG_ERR_FUNC_ARG_INVALID; }
+
+        task.deadline_ns = (deadline_ns > UINT64_MAX - 1 - now_ns) ? UINT64_MAX - 1 : now_ns + deadline_ns;
+    }
+
     {
         uint8_t sm_expected = 0;
         LDG_CAS(&pool->submit_mode, &sm_expected, 1);
@@ -245,11 +870,470 @@ uint32_t ldg_thread_pool_submit(ldg_thread_pool_t *pool, ldg_thread_pool_worker_
 
     {
         uint8_t expected = 0;
-        if (LDG_CAS(&pool->is_running, &expected, 1)) { if (LDG_UNLIKELY(thread_pool_submit_workers_start(pool) != LDG_ERR_AOK)) { LDG_WR_ONCE(pool->is_running, 0); return LDG_ERR_FUNC_ARG_INVALID; } }
+        if (LDG_CAS(&pool->is_running, &expected, 1)) { if (LDG_UNLIKELY(thread_pool_submit_workers_start(pool) != LDG_ERR_AOK)) { LDG_WR_ONCE(pool->is_running, 0); LDG_FETCH_ADD(pool->tele[pool->worker_cunt].rejected, 1); return LDG_ERR_FUNC_ARG_INVALID; } }
     }
 
     task.func = func;
     task.arg = arg;
+    task.prio = prio;
+    task.submit_tsc = ldg_tsc_sample(0x0);
+
+    // normal work spawned from one of our own workers stays local, spilling to the lane when the deque is full;
+    // other lanes always go through their queue so every worker's weighted pick sees them
+    if (prio == LDG_THREAD_POOL_PRIO_NORMAL && pool->deques && thread_pool_worker_self && thread_pool_worker_self->pool == pool)
+    {
+        if (ldg_deque_push(&pool->deques[thread_pool_worker_self->id], &task) == LDG_ERR_AOK)
+        {
+            thread_pool_notify(pool);
+            return LDG_ERR_AOK;
+        }
+    }
+
+    lane = &pool->lanes[prio];
+
+    ret = ldg_mpmcu_push(lane->queue, &task);
+    if (LDG_UNLIKELY(ret != LDG_ERR_AOK)) { LDG_FETCH_ADD(pool->tele[pool->worker_cunt].rejected, 1); return ret; }
+
+    thread_pool_notify(pool);
+
+    depth = ldg_mpmcu_cunt_get(lane->queue);
+    peak = LDG_RD_ONCE(lane->depth_peak);
+
+    while (depth > peak && !LDG_CAS(&lane->depth_peak, &peak, depth)) { }
+
+    return LDG_ERR_AOK;
+}
+
+uint32_t ldg_thread_pool_lane_stats_get(ldg_thread_pool_t *pool, uint32_t prio, ldg_thread_pool_lane_stats_t *stats)
+{
+    ldg_thread_pool_lane_t *lane = 0x0;
+
+    if (LDG_UNLIKELY(!pool || !pool->is_init || !stats)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    if (LDG_UNLIKELY(prio >= LDG_THREAD_POOL_PRIO_CUNT)) { return LDG_ERR_FUNC_ARG_INVALID; }
+
+    lane = &pool->lanes[prio];
+
+    stats->depth = ldg_mpmcu_cunt_get(lane->queue);
+    stats->depth_peak = LDG_RD_ONCE(lane->depth_peak);
+    stats->expired = LDG_RD_ONCE(lane->expired);
+    stats->weight = lane->weight;
+
+    return LDG_ERR_AOK;
+}
+
+// counters are read one by one while workers keep writing them, so the sums are not a single-instant snapshot
+uint32_t ldg_thread_pool_stats_get(ldg_thread_pool_t *pool, ldg_thread_pool_stats_t *stats)
+{
+    ldg_thread_pool_worker_stats_t ws = { 0 };
+    uint32_t i = 0;
+    uint32_t b = 0;
+
+    if (LDG_UNLIKELY(!pool || !pool->is_init || !stats)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    if (LDG_UNLIKELY(memset(stats, 0, sizeof(ldg_thread_pool_stats_t)) != stats)) { return LDG_ERR_MEM_BAD; }
+
+    for (i = 0; i <= pool->worker_cunt; i++)
+    {
+        thread_pool_tele_read(&pool->tele[i], &ws);
+
+        stats->executed += ws.executed;
+        stats->busy_cycles += ws.busy_cycles;
+        stats->idle_cycles += ws.idle_cycles;
+        stats->wait_cycles += ws.wait_cycles;
+
+        if (ws.wait_max_cycles > stats->wait_max_cycles) { stats->wait_max_cycles = ws.wait_max_cycles; }
+
+        for (b = 0; b < LDG_THREAD_POOL_WAIT_HIST_BUCKETS; b++) { stats->wait_hist[b] += ws.wait_hist[b]; }
+    }
+
+    stats->helped = ws.executed;
+
+    for (i = 0; i < LDG_THREAD_POOL_PRIO_CUNT; i++) { stats->expired += LDG_RD_ONCE(pool->lanes[i].expired); }
+
+    stats->rejected = LDG_RD_ONCE(pool->tele[pool->worker_cunt].rejected);
+    stats->task_queue_depth = ldg_mpmcu_cunt_get(pool->task_queue);
+    stats->task_queue_depth_peak = LDG_RD_ONCE(pool->lanes[LDG_THREAD_POOL_PRIO_NORMAL].depth_peak);
+
+    return LDG_ERR_AOK;
+}
+
+uint32_t ldg_thread_pool_worker_stats_get(ldg_thread_pool_t *pool, uint32_t worker, ldg_thread_pool_worker_stats_t *stats)
+{
+    if (LDG_UNLIKELY(!pool || !pool->is_init || !stats)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    if (LDG_UNLIKELY(worker >= pool->worker_cunt)) { return LDG_ERR_FUNC_ARG_INVALID; }
+
+    thread_pool_tele_read(&pool->tele[worker], stats);
+
+    return LDG_ERR_AOK;
+}
+
+// runs one queued task of any kind on behalf of a blocked caller
+static uint32_t thread_pool_help(ldg_thread_pool_t *pool, uint32_t *rng)
+{
+    ldg_thread_pool_worker_t *self = thread_pool_worker_self;
+    ldg_thread_pool_task_t task = { 0 };
+    uint32_t i = 0;
+    uint32_t start = 0;
+    uint32_t victim = 0;
+    uint32_t ret = LDG_ERR_EMPTY;
+
+    if (pool->deques && self && self->pool == pool) { ret = thread_pool_task_find(pool, self->id, rng, &task); }
+    else
+    {
+        ret = thread_pool_lane_pop(pool, 0x0, &task);
+
+        if (ret != LDG_ERR_AOK && pool->deques)
+        {
+            start = thread_pool_rng_next(rng) % pool->worker_cunt;
+
+            for (i = 0; i < pool->worker_cunt && ret != LDG_ERR_AOK; i++)
+            {
+                victim = start + i;
+                if (victim >= pool->worker_cunt) { victim -= pool->worker_cunt; }
+
+                ret = ldg_deque_steal(&pool->deques[victim], &task);
+            }
+        }
+    }
+
+    if (ret != LDG_ERR_AOK) { return LDG_ERR_EMPTY; }
+
+    thread_pool_task_run(pool, (self && self->pool == pool) ? &pool->tele[self->id] : &pool->tele[pool->worker_cunt], &task);
+
+    return LDG_ERR_AOK;
+}
+
+// handles and wait groups
+
+static uint32_t thread_pool_handle_run(void *arg)
+{
+    ldg_thread_pool_handle_t *h = (ldg_thread_pool_handle_t *)arg;
+
+    h->result = h->func(h->arg);
+
+    // done() is a locked RMW; it publishes result before any waiter can see the count drop
+    ldg_wg_done(&h->wg);
+
+    return LDG_ERR_AOK;
+}
+
+uint32_t ldg_thread_pool_submit_h(ldg_thread_pool_t *pool, ldg_thread_pool_worker_func_t func, void *arg, ldg_thread_pool_handle_t *h)
+{
+    uint32_t ret = 0;
+
+    if (LDG_UNLIKELY(!pool || !pool->is_init || !func || !h)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    h->result = LDG_ERR_AOK;
+    h->func = func;
+    h->arg = arg;
+    h->pool = pool;
+
+    ldg_wg_init(&h->wg, 1);
+
+    ret = ldg_thread_pool_submit(pool, thread_pool_handle_run, h);
+    if (LDG_UNLIKELY(ret != LDG_ERR_AOK)) { ldg_wg_init(&h->wg, 0); h->result = ret; }
+
+    return ret;
+}
+
+// AOK once the task has returned, AGAIN while it is queued or running
+uint32_t ldg_thread_pool_handle_poll(const ldg_thread_pool_handle_t *h)
+{
+    if (LDG_UNLIKELY(!h)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    return (ldg_wg_cunt_get(&h->wg) == 0) ? LDG_ERR_AOK : LDG_ERR_AGAIN;
+}
+
+uint32_t ldg_thread_pool_handle_result(const ldg_thread_pool_handle_t *h, uint32_t *result)
+{
+    if (LDG_UNLIKELY(!h || !result)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    if (ldg_wg_cunt_get(&h->wg) != 0) { return LDG_ERR_AGAIN; }
+
+    *result = h->result;
+
+    return LDG_ERR_AOK;
+}
+
+uint32_t ldg_thread_pool_handle_wait(ldg_thread_pool_handle_t *h, uint64_t timeout_ms)
+{
+    if (LDG_UNLIKELY(!h || !h->pool)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    return ldg_thread_pool_wg_wait((ldg_thread_pool_t *)h->pool, &h->wg, timeout_ms);
+}
+
+// called from one of pool's workers, runs queued tasks instead of sleeping; elsewhere a plain wg wait
+uint32_t ldg_thread_pool_wg_wait(ldg_thread_pool_t *pool, ldg_wg_t *wg, uint64_t timeout_ms)
+{
+    ldg_thread_pool_worker_t *self = thread_pool_worker_self;
+    uint64_t deadline_ms = 0;
+    uint64_t now_ms = 0;
+    uint64_t slice = 0;
+    uint32_t rng = 0;
+    uint32_t ret = 0;
+
+    if (LDG_UNLIKELY(!pool || !wg)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    if (!self || self->pool != pool) { return ldg_wg_wait(wg, timeout_ms); }
+
+    now_ms = thread_pool_monotonic_ms_get();
+    if (LDG_UNLIKELY(now_ms == UINT64_MAX)) { return LDG_ERR_FUNC_ARG_INVALID; }
+
+    if (LDG_UNLIKELY(timeout_ms > UINT64_MAX - now_ms)) { deadline_ms = UINT64_MAX; }
+    else { deadline_ms = now_ms + timeout_ms; }
+
+    rng = (uint32_t)((uintptr_t)wg >> 4) | 1;
+
+    while (ldg_wg_cunt_get(wg) != 0)
+    {
+        if (thread_pool_help(pool, &rng) == LDG_ERR_AOK) { continue; }
+
+        now_ms = thread_pool_monotonic_ms_get();
+        if (now_ms >= deadline_ms) { return LDG_ERR_TIMEOUT; }
+
+        // short slices; new work does not wake us, only the wait group does
+        slice = deadline_ms - now_ms;
+        if (slice > LDG_THREAD_POOL_WAIT_TIMEOUT_MS) { slice = LDG_THREAD_POOL_WAIT_TIMEOUT_MS; }
+
+        ret = ldg_wg_wait(wg, slice);
+        if (ret != LDG_ERR_AOK && ret != LDG_ERR_TIMEOUT) { return ret; }
+    }
+
+    return LDG_ERR_AOK;
+}
+
+// for phased loops run with start(): a worker waits out the phase but gives up with INTERRUPTED once
+// stop() is called, so a party that exits early cannot strand the rest. the barrier must then be re-inited.
+// tasks are not run while waiting; a nested party would have to pass the next phase before this one returns
+uint32_t ldg_thread_pool_barrier_wait(ldg_thread_pool_t *pool, ldg_barrier_t *b, uint8_t *is_last_out)
+{
+    ldg_thread_pool_worker_t *self = thread_pool_worker_self;
+    uint32_t token = 0;
+    uint32_t ret = 0;
+
+    if (LDG_UNLIKELY(!pool || !b)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    if (!self || self->pool != pool) { return ldg_barrier_wait(b, is_last_out); }
+
+    ret = ldg_barrier_arrive(b, &token, is_last_out);
+    if (LDG_UNLIKELY(ret != LDG_ERR_AOK)) { return ret; }
+
+    for (;;)
+    {
+        ret = ldg_barrier_token_wait(b, token, LDG_THREAD_POOL_WAIT_TIMEOUT_MS * LDG_NS_PER_MS);
+        if (ret != LDG_ERR_TIMEOUT) { return ret; }
+
+        if (LDG_RD_ONCE(self->should_stop)) { return LDG_ERR_INTERRUPTED; }
+    }
+}
+
+// parallel loops
+
+// lazy binary splitting: a participant halves its range only when its own queue has run dry,
+// so the split count follows idle workers rather than the range length
+static uint8_t thread_pool_par_local_empty_is(ldg_thread_pool_t *pool)
+{
+    ldg_thread_pool_worker_t *self = thread_pool_worker_self;
+
+    if (pool->deques && self && self->pool == pool) { return ldg_deque_empty_is(&pool->deques[self->id]); }
+
+    return ldg_mpmcu_empty_is(pool->task_queue);
+}
+
+static ldg_thread_pool_par_node_t* thread_pool_par_node_get(ldg_thread_pool_par_job_t *job)
+{
+    uint64_t mask = LDG_RD_ONCE(job->node_free);
+    uint64_t bit = 0;
+    uint32_t idx = 0;
+
+    while (mask)
+    {
+        idx = (uint32_t)__builtin_ctzll(mask);
+        bit = (uint64_t)1 << idx;
+
+        if (LDG_CAS(&job->node_free, &mask, mask & ~bit))
+        {
+            LDG_FETCH_OR(job->node_used, bit);
+            return &job->nodes[idx];
+        }
+    }
+
+    return 0x0;
+}
+
+static void thread_pool_par_node_put(ldg_thread_pool_par_job_t *job, ldg_thread_pool_par_node_t *node)
+{
+    LDG_FETCH_OR(job->node_free, (uint64_t)1 << (uint32_t)(node - job->nodes));
+}
+
+static void thread_pool_par_err_set(ldg_thread_pool_par_job_t *job, uint32_t err)
+{
+    uint32_t expected = LDG_ERR_AOK;
+
+    LDG_CAS(&job->err, &expected, err);
+}
+
+static uint32_t thread_pool_par_task(void *arg);
+
+// accumulates into acc slot `slot`; a node keeps its slot across reuse, which is why join must commute
+static void thread_pool_par_run(ldg_thread_pool_par_job_t *job, uint32_t slot, uint64_t begin, uint64_t end)
+{
+    ldg_thread_pool_par_node_t *node = 0x0;
+    void *acc = 0x0;
+    uint64_t mid = 0;
+    uint64_t stop = 0;
+    uint32_t ret = 0;
+
+    if (job->accs) { acc = job->accs + (uint64_t)slot * job->acc_size; }
+
+    while (begin < end)
+    {
+        if (LDG_UNLIKELY(LDG_RD_ONCE(job->err) != LDG_ERR_AOK)) { return; }
+
+        if (end - begin > job->grain && thread_pool_par_local_empty_is(job->pool))
+        {
+            node = thread_pool_par_node_get(job);
+
+            // out of nodes: enough work is already in flight, keep going serially
+            if (node)
+            {
+                mid = begin + (end - begin) / 2;
+                node->begin = mid;
+                node->end = end;
+
+                LDG_FETCH_ADD(job->pending, 1);
+
+                if (LDG_LIKELY(ldg_thread_pool_submit(job->pool, thread_pool_par_task, node) == LDG_ERR_AOK)) { end = mid; continue; }
+
+                thread_pool_par_node_put(job, node);
+                LDG_FETCH_SUB(job->pending, 1);
+            }
+        }
+
+        stop = (end - begin > job->grain) ? begin + job->grain : end;
+
+        if (job->reduce_fn) { ret = job->reduce_fn(begin, stop, job->ctx, acc); }
+        else { ret = job->range_fn(begin, stop, job->ctx); }
+
+        if (LDG_UNLIKELY(ret != LDG_ERR_AOK)) { thread_pool_par_err_set(job, ret); return; }
+
+        begin = stop;
+    }
+}
+
+static uint32_t thread_pool_par_task(void *arg)
+{
+    ldg_thread_pool_par_node_t *node = (ldg_thread_pool_par_node_t *)arg;
+    ldg_thread_pool_par_job_t *job = (ldg_thread_pool_par_job_t *)node->job;
+
+    thread_pool_par_run(job, (uint32_t)(node - job->nodes), node->begin, node->end);
+    thread_pool_par_node_put(job, node);
+
+    // the caller may return as soon as pending hits zero; a wake on a dead stack address is harmless
+    if (LDG_FETCH_SUB(job->pending, 1) == 1) { ldg_futex_wake(&job->pending, 1, 0); }
+
+    return LDG_ERR_AOK;
+}
+
+static uint32_t thread_pool_par_exec(ldg_thread_pool_par_job_t *job, uint64_t begin, uint64_t end)
+{
+    uint32_t pending = 0;
+    uint32_t rng = 0;
+
+    rng = (uint32_t)((uintptr_t)job >> 6) | 1;
+
+    if (job->grain == 0) { job->grain = (end - begin) / (8 * ((uint64_t)job->pool->worker_cunt + 1)); }
+    if (job->grain == 0) { job->grain = 1; }
+
+    // the caller takes the whole range and splits it like any other participant
+    thread_pool_par_run(job, THREAD_POOL_PAR_NODE_MAX, begin, end);
+
+    // help while anything is outstanding; park only when there is nothing to run
+    while ((pending = LDG_LOAD_ACQUIRE(job->pending)) != 0)
+    {
+        if (thread_pool_help(job->pool, &rng) == LDG_ERR_AOK) { continue; }
+
+        ldg_futex_wait(&job->pending, pending, LDG_THREAD_POOL_WAIT_TIMEOUT_MS * LDG_NS_PER_MS, 0);
+    }
+
+    return LDG_LOAD_ACQUIRE(job->err);
+}
+
+// blocks until every slice has run; the calling thread participates
+uint32_t ldg_thread_pool_parallel_for(ldg_thread_pool_t *pool, uint64_t begin, uint64_t end, uint64_t grain, ldg_thread_pool_range_func_t fn, void *ctx)
+{
+    ldg_thread_pool_par_job_t job = { 0 };
+    uint32_t i = 0;
+
+    if (LDG_UNLIKELY(!pool || !pool->is_init || !fn)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    if (begin >= end) { return LDG_ERR_AOK; }
+
+    job.pool = pool;
+    job.range_fn = fn;
+    job.ctx = ctx;
+    job.grain = grain;
+    job.node_free = UINT64_MAX;
+
+    for (i = 0; i < THREAD_POOL_PAR_NODE_MAX; i++) { job.nodes[i].job = &job; }
+
+    return thread_pool_par_exec(&job, begin, end);
+}
+
+// acc holds the identity on entry and the folded result on return
+uint32_t ldg_thread_pool_parallel_reduce(ldg_thread_pool_t *pool, uint64_t begin, uint64_t end, uint64_t grain, ldg_thread_pool_reduce_func_t fn, ldg_thread_pool_join_func_t join, void *ctx, void *acc, uint64_t acc_size)
+{
+    ldg_thread_pool_par_job_t job = { 0 };
+    void *accs_tmp = 0x0;
+    uint64_t accs_size = 0;
+    uint64_t used = 0;
+    uint32_t i = 0;
+    uint32_t ret = 0;
+
+    if (LDG_UNLIKELY(!pool || !pool->is_init || !fn || !join || !acc)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    if (LDG_UNLIKELY(acc_size == 0)) { return LDG_ERR_FUNC_ARG_INVALID; }
+
+    if (begin >= end) { return LDG_ERR_AOK; }
+
+    // one slot per node plus the caller's
+    if (LDG_UNLIKELY(ldg_arith_64_mul(acc_size, THREAD_POOL_PAR_NODE_MAX + 1, &accs_size) != LDG_ERR_AOK)) { return LDG_ERR_OVERFLOW; }
+
+    ret = ldg_mem_alloc(accs_size, &accs_tmp);
+    if (LDG_UNLIKELY(ret != LDG_ERR_AOK)) { return ret; }
+
+    job.pool = pool;
+    job.reduce_fn = fn;
+    job.ctx = ctx;
+    job.grain = grain;
+    job.accs = (uint8_t *)accs_tmp;
+    job.acc_size = acc_size;
+    job.node_free = UINT64_MAX;
+
+    for (i = 0; i <= THREAD_POOL_PAR_NODE_MAX; i++)
+    {
+        if (i < THREAD_POOL_PAR_NODE_MAX) { job.nodes[i].job = &job; }
+
+        if (LDG_UNLIKELY(ldg_mem_secure_copy(job.accs + (uint64_t)i * acc_size, acc, acc_size) != LDG_ERR_AOK)) { ldg_mem_dealloc(accs_tmp); return LDG_ERR_MEM_BAD; }
+    }
+
+    ret = thread_pool_par_exec(&job, begin, end);
+
+    used = LDG_RD_ONCE(job.node_used);
+
+    // fold into the caller's slot, then hand it back through acc
+    for (i = 0; i < THREAD_POOL_PAR_NODE_MAX && ret == LDG_ERR_AOK; i++)
+    {
+        if (!(used & ((uint64_t)1 << i))) { continue; }
+
+        ret = join(job.accs + (uint64_t)THREAD_POOL_PAR_NODE_MAX * acc_size, job.accs + (uint64_t)i * acc_size, ctx);
+    }
+
+    if (ret == LDG_ERR_AOK && LDG_UNLIKELY(ldg_mem_secure_copy(acc, job.accs + (uint64_t)THREAD_POOL_PAR_NODE_MAX * acc_size, acc_size) != LDG_ERR_AOK)) { ret = LDG_ERR_MEM_BAD; }
+
+    ldg_mem_dealloc(accs_tmp);
 
-    return ldg_mpmc_push(pool->task_queue, &task);
+    return ret;
 }
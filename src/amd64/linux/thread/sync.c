@@ -1,16 +1,43 @@
+#define _GNU_SOURCE
+
 #include <stdint.h>
 #include <string.h>
 #include <errno.h>
 #include <time.h>
 #include <fcntl.h>
+#include <unistd.h>
 #include <pthread.h>
+#include <sched.h>
 #include <semaphore.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
 
 #include <dangling/thread/sync.h>
+#include <dangling/sys/info.h>
 #include <dangling/core/err.h>
 #include <dangling/mem/secure.h>
 #include <dangling/core/macros.h>
+#include <dangling/arch/amd64/atomic.h>
+#include <dangling/arch/amd64/fence.h>
+
+
+static uint64_t sync_monotonic_ms_get(void)
+{
+    struct timespec ts = { 0 };
+
+    if (LDG_UNLIKELY(clock_gettime(CLOCK_MONOTONIC, &ts) != 0)) { return UINT64_MAX; }
+
+    return (uint64_t)ts.tv_sec * LDG_MS_PER_SEC + (uint64_t)ts.tv_nsec / LDG_NS_PER_MS;
+}
+
+static uint64_t sync_monotonic_ns_get(void)
+{
+    struct timespec ts = { 0 };
 
+    if (LDG_UNLIKELY(clock_gettime(CLOCK_MONOTONIC, &ts) != 0)) { return UINT64_MAX; }
+
+    return (uint64_t)ts.tv_sec * LDG_NS_PER_SEC + (uint64_t)ts.tv_nsec;
+}
 
 // impl accessors
 static inline pthread_mutex_t* mut_mtx(ldg_mut_t *m)
@@ -313,3 +340,796 @@ uint32_t ldg_sem_post(ldg_sem_t *s)
 
     return LDG_ERR_AOK;
 }
+
+// sem local
+
+static uint8_t sem_local_take_is(ldg_sem_local_t *s)
+{
+    uint32_t v = LDG_RD_ONCE(s->val);
+
+    while (v != 0) { if (LDG_CAS(&s->val, &v, v - 1)) { return 1; } }
+
+    return 0;
+}
+
+uint32_t ldg_sem_local_init(ldg_sem_local_t *s, uint32_t init_val)
+{
+    if (LDG_UNLIKELY(!s)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    if (LDG_UNLIKELY(init_val > LDG_SEM_LOCAL_MAX)) { return LDG_ERR_OVERFLOW; }
+
+    LDG_WR_ONCE(s->val, init_val);
+    LDG_WR_ONCE(s->waiters, 0);
+
+    return LDG_ERR_AOK;
+}
+
+uint32_t ldg_sem_local_destroy(ldg_sem_local_t *s)
+{
+    if (LDG_UNLIKELY(!s)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    if (LDG_UNLIKELY(LDG_RD_ONCE(s->waiters) != 0)) { return LDG_ERR_BUSY; }
+
+    return LDG_ERR_AOK;
+}
+
+uint32_t ldg_sem_local_wait(ldg_sem_local_t *s)
+{
+    return ldg_sem_local_timedwait(s, LDG_FUTEX_WAIT_INFINITE);
+}
+
+// timeout_ns is relative; LDG_FUTEX_WAIT_INFINITE waits forever
+uint32_t ldg_sem_local_timedwait(ldg_sem_local_t *s, uint64_t timeout_ns)
+{
+    uint64_t deadline_ns = UINT64_MAX;
+    uint64_t now_ns = 0;
+    uint32_t ret = LDG_ERR_AOK;
+
+    if (LDG_UNLIKELY(!s)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    if (LDG_LIKELY(sem_local_take_is(s))) { return LDG_ERR_AOK; }
+
+    if (timeout_ns == 0) { return LDG_ERR_TIMEOUT; }
+
+    if (timeout_ns != LDG_FUTEX_WAIT_INFINITE)
+    {
+        now_ns = sync_monotonic_ns_get();
+        if (LDG_UNLIKELY(now_ns == UINT64_MAX)) { return LDG_ERR_FUNC_ARG_INVALID; }
+
+        if (LDG_LIKELY(timeout_ns < UINT64_MAX - now_ns)) { deadline_ns = now_ns + timeout_ns; }
+    }
+
+    // seq_cst RMW; either post() sees the waiter or the re-check below sees the post
+    LDG_FETCH_ADD(s->waiters, 1);
+
+    while (!sem_local_take_is(s))
+    {
+        if (deadline_ns != UINT64_MAX)
+        {
+            now_ns = sync_monotonic_ns_get();
+            if (now_ns >= deadline_ns) { ret = LDG_ERR_TIMEOUT; break; }
+        }
+
+        ldg_futex_wait(&s->val, 0, (deadline_ns == UINT64_MAX) ? LDG_FUTEX_WAIT_INFINITE : deadline_ns - now_ns, 0);
+    }
+
+    LDG_FETCH_SUB(s->waiters, 1);
+
+    return ret;
+}
+
+uint32_t ldg_sem_local_trywait(ldg_sem_local_t *s)
+{
+    if (LDG_UNLIKELY(!s)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    if (sem_local_take_is(s)) { return LDG_ERR_AOK; }
+
+    return LDG_ERR_BUSY;
+}
+
+uint32_t ldg_sem_local_post(ldg_sem_local_t *s)
+{
+    uint32_t v = 0;
+
+    if (LDG_UNLIKELY(!s)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    v = LDG_RD_ONCE(s->val);
+
+    do
+    {
+        if (LDG_UNLIKELY(v >= LDG_SEM_LOCAL_MAX)) { return LDG_ERR_OVERFLOW; }
+    } while (!LDG_CAS(&s->val, &v, v + 1));
+
+    if (LDG_LIKELY(LDG_RD_ONCE(s->waiters) == 0)) { return LDG_ERR_AOK; }
+
+    return ldg_futex_wake(&s->val, 1, 0);
+}
+
+uint64_t ldg_sem_local_val_get(const ldg_sem_local_t *s)
+{
+    if (LDG_UNLIKELY(!s)) { return UINT64_MAX; }
+
+    return (uint64_t)LDG_LOAD_ACQUIRE(s->val);
+}
+
+// futex
+
+uint32_t ldg_futex_wait(uint32_t *addr, uint32_t expected, uint64_t timeout_ns, uint8_t shared)
+{
+    struct timespec ts = { 0 };
+    struct timespec *ts_ptr = 0x0;
+    int32_t op = FUTEX_WAIT;
+    int64_t ret = 0;
+
+    if (LDG_UNLIKELY(!addr)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    if (!shared) { op |= FUTEX_PRIVATE_FLAG; }
+
+    // FUTEX_WAIT timeout is relative, measured against CLOCK_MONOTONIC
+    if (timeout_ns != LDG_FUTEX_WAIT_INFINITE)
+    {
+        ts.tv_sec = (time_t)(timeout_ns / LDG_NS_PER_SEC);
+        ts.tv_nsec = (int64_t)(timeout_ns % LDG_NS_PER_SEC);
+        ts_ptr = &ts;
+    }
+
+    ret = (int64_t)syscall(SYS_futex, addr, op, expected, ts_ptr, 0x0, 0);
+    if (LDG_LIKELY(ret == 0)) { return LDG_ERR_AOK; }
+
+    // EAGAIN: *addr != expected at entry; caller re-checks its condition either way
+    if (errno == EAGAIN) { return LDG_ERR_AOK; }
+
+    if (errno == ETIMEDOUT) { return LDG_ERR_TIMEOUT; }
+
+    if (errno == EINTR) { return LDG_ERR_INTERRUPTED; }
+
+    return LDG_ERR_FUNC_ARG_INVALID;
+}
+
+uint32_t ldg_futex_wake(uint32_t *addr, uint32_t cunt, uint8_t shared)
+{
+    int32_t op = FUTEX_WAKE;
+
+    if (LDG_UNLIKELY(!addr)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    if (LDG_UNLIKELY(cunt == 0)) { return LDG_ERR_AOK; }
+
+    if (!shared) { op |= FUTEX_PRIVATE_FLAG; }
+
+    if (cunt > (uint32_t)INT32_MAX) { cunt = (uint32_t)INT32_MAX; }
+
+    if (LDG_UNLIKELY(syscall(SYS_futex, addr, op, cunt, 0x0, 0x0, 0) < 0)) { return LDG_ERR_FUNC_ARG_INVALID; }
+
+    return LDG_ERR_AOK;
+}
+
+// lmut
+
+static uint32_t sync_cpu_cunt = 0;
+
+// a spinner can only see the lock come free if the owner is on another cpu
+static uint8_t lmut_spin_is(void)
+{
+    uint32_t cunt = LDG_RD_ONCE(sync_cpu_cunt);
+
+    if (LDG_UNLIKELY(cunt == 0))
+    {
+        if (ldg_sys_cpu_cunt_get(&cunt) != LDG_ERR_AOK || cunt == 0) { cunt = 1; }
+        LDG_WR_ONCE(sync_cpu_cunt, cunt);
+    }
+
+    return cunt > 1;
+}
+
+uint32_t ldg_lmut_init(ldg_lmut_t *m, uint8_t shared)
+{
+    LDG_BOOL_ASSERT(sizeof(ldg_lmut_t) == 8);
+
+    if (LDG_UNLIKELY(!m)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    LDG_WR_ONCE(m->state, LDG_LMUT_UNLOCKED);
+    m->spin = 0;
+    m->is_shared = shared ? 1 : 0;
+    m->is_init = 1;
+
+    return LDG_ERR_AOK;
+}
+
+uint32_t ldg_lmut_destroy(ldg_lmut_t *m)
+{
+    if (LDG_UNLIKELY(!m || !m->is_init)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    if (LDG_UNLIKELY(LDG_RD_ONCE(m->state) != LDG_LMUT_UNLOCKED)) { return LDG_ERR_BUSY; }
+
+    m->is_init = 0;
+
+    return LDG_ERR_AOK;
+}
+
+// userspace cannot see whether the owner is on a cpu; no parked waiters (state 1) stands in for
+// "owner running", so spinning stops as soon as someone else has given up and parked
+uint32_t ldg_lmut_lock(ldg_lmut_t *m)
+{
+    uint32_t expected = LDG_LMUT_UNLOCKED;
+    uint32_t s = 0;
+    uint32_t lim = 0;
+    uint32_t i = 0;
+    int32_t spin = 0;
+
+    if (LDG_UNLIKELY(!m || !m->is_init)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    if (LDG_LIKELY(LDG_CAS(&m->state, &expected, LDG_LMUT_LOCKED))) { return LDG_ERR_AOK; }
+
+    if (lmut_spin_is())
+    {
+        spin = (int32_t)LDG_RD_ONCE(m->spin);
+        lim = (uint32_t)spin * 2 + 10;
+        if (lim > LDG_LMUT_SPIN_MAX) { lim = LDG_LMUT_SPIN_MAX; }
+
+        for (i = 0; i < lim; i++)
+        {
+            s = LDG_RD_ONCE(m->state);
+            if (s == LDG_LMUT_CONTENDED) { break; }
+
+            expected = LDG_LMUT_UNLOCKED;
+            if (s == LDG_LMUT_UNLOCKED && LDG_CAS(&m->state, &expected, LDG_LMUT_LOCKED)) { break; }
+
+            LDG_PAUSE;
+        }
+
+        // move the estimate an eighth of the way toward this round's spin
+        LDG_WR_ONCE(m->spin, (uint16_t)(spin + ((int32_t)i - spin) / 8));
+
+        if (i < lim && s == LDG_LMUT_UNLOCKED) { return LDG_ERR_AOK; }
+    }
+
+    // taken from here on as contended, so the unlock that lets us in also wakes the next waiter
+    while (LDG_XCHG(m->state, LDG_LMUT_CONTENDED) != LDG_LMUT_UNLOCKED)
+    {
+        ldg_futex_wait(&m->state, LDG_LMUT_CONTENDED, LDG_FUTEX_WAIT_INFINITE, m->is_shared);
+    }
+
+    return LDG_ERR_AOK;
+}
+
+uint32_t ldg_lmut_unlock(ldg_lmut_t *m)
+{
+    uint32_t prev = 0;
+
+    if (LDG_UNLIKELY(!m || !m->is_init)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    prev = LDG_XCHG(m->state, LDG_LMUT_UNLOCKED);
+    if (LDG_UNLIKELY(prev == LDG_LMUT_UNLOCKED)) { return LDG_ERR_INVALID; }
+
+    if (prev == LDG_LMUT_CONTENDED) { return ldg_futex_wake(&m->state, 1, m->is_shared); }
+
+    return LDG_ERR_AOK;
+}
+
+uint32_t ldg_lmut_trylock(ldg_lmut_t *m)
+{
+    uint32_t expected = LDG_LMUT_UNLOCKED;
+
+    if (LDG_UNLIKELY(!m || !m->is_init)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    if (LDG_CAS(&m->state, &expected, LDG_LMUT_LOCKED)) { return LDG_ERR_AOK; }
+
+    return LDG_ERR_BUSY;
+}
+
+// rwlock
+
+uint32_t ldg_rwlock_init(ldg_rwlock_t *rw, uint8_t shared)
+{
+    LDG_BOOL_ASSERT(sizeof(ldg_rwlock_t) == 16);
+
+    if (LDG_UNLIKELY(!rw)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    LDG_WR_ONCE(rw->state, 0);
+    LDG_WR_ONCE(rw->drain, 0);
+
+    return ldg_lmut_init(&rw->wmut, shared);
+}
+
+uint32_t ldg_rwlock_destroy(ldg_rwlock_t *rw)
+{
+    if (LDG_UNLIKELY(!rw || !rw->wmut.is_init)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    if (LDG_UNLIKELY(LDG_RD_ONCE(rw->state) != 0)) { return LDG_ERR_BUSY; }
+
+    return ldg_lmut_destroy(&rw->wmut);
+}
+
+uint32_t ldg_rwlock_rd_lock(ldg_rwlock_t *rw)
+{
+    uint32_t s = 0;
+    uint32_t spin = 0;
+
+    if (LDG_UNLIKELY(!rw || !rw->wmut.is_init)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    s = LDG_RD_ONCE(rw->state);
+
+    for (;;)
+    {
+        if (LDG_LIKELY(!(s & LDG_RWLOCK_WR)))
+        {
+            if (LDG_UNLIKELY((s & LDG_RWLOCK_RD_MAX) == LDG_RWLOCK_RD_MAX)) { return LDG_ERR_OVERFLOW; }
+
+            if (LDG_CAS(&rw->state, &s, s + 1)) { return LDG_ERR_AOK; }
+
+            continue;
+        }
+
+        if (spin < LDG_RWLOCK_SPIN_CUNT && lmut_spin_is())
+        {
+            spin++;
+            LDG_PAUSE;
+            s = LDG_RD_ONCE(rw->state);
+            continue;
+        }
+
+        // mark ourselves parked so wr_unlock knows to wake; a failed cas re-evaluates the new state
+        if (!(s & LDG_RWLOCK_RD_WAIT) && !LDG_CAS(&rw->state, &s, s | LDG_RWLOCK_RD_WAIT)) { continue; }
+
+        ldg_futex_wait(&rw->state, s | LDG_RWLOCK_RD_WAIT, LDG_FUTEX_WAIT_INFINITE, rw->wmut.is_shared);
+        s = LDG_RD_ONCE(rw->state);
+    }
+}
+
+uint32_t ldg_rwlock_rd_trylock(ldg_rwlock_t *rw)
+{
+    uint32_t s = 0;
+
+    if (LDG_UNLIKELY(!rw || !rw->wmut.is_init)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    s = LDG_RD_ONCE(rw->state);
+
+    do
+    {
+        if (s & LDG_RWLOCK_WR) { return LDG_ERR_BUSY; }
+
+        if (LDG_UNLIKELY((s & LDG_RWLOCK_RD_MAX) == LDG_RWLOCK_RD_MAX)) { return LDG_ERR_OVERFLOW; }
+    } while (!LDG_CAS(&rw->state, &s, s + 1));
+
+    return LDG_ERR_AOK;
+}
+
+// the last reader out while a writer is draining bumps drain so the writer's futex wait cannot miss it
+uint32_t ldg_rwlock_rd_unlock(ldg_rwlock_t *rw)
+{
+    uint32_t s = 0;
+
+    if (LDG_UNLIKELY(!rw || !rw->wmut.is_init)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    s = LDG_RD_ONCE(rw->state);
+
+    do
+    {
+        if (LDG_UNLIKELY((s & LDG_RWLOCK_RD_MAX) == 0)) { return LDG_ERR_INVALID; }
+    } while (!LDG_CAS(&rw->state, &s, s - 1));
+
+    if ((s & LDG_RWLOCK_RD_MAX) == 1 && (s & LDG_RWLOCK_WR))
+    {
+        LDG_FETCH_ADD(rw->drain, 1);
+        return ldg_futex_wake(&rw->drain, 1, rw->wmut.is_shared);
+    }
+
+    return LDG_ERR_AOK;
+}
+
+uint32_t ldg_rwlock_wr_lock(ldg_rwlock_t *rw)
+{
+    uint32_t d = 0;
+    uint32_t i = 0;
+    uint32_t ret = 0;
+
+    if (LDG_UNLIKELY(!rw || !rw->wmut.is_init)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    ret = ldg_lmut_lock(&rw->wmut);
+    if (LDG_UNLIKELY(ret != LDG_ERR_AOK)) { return ret; }
+
+    // from here no new reader gets in; wait out the ones already inside
+    LDG_FETCH_OR(rw->state, LDG_RWLOCK_WR);
+
+    if (lmut_spin_is())
+    {
+        for (i = 0; i < LDG_RWLOCK_SPIN_CUNT && (LDG_RD_ONCE(rw->state) & LDG_RWLOCK_RD_MAX); i++) { LDG_PAUSE; }
+    }
+
+    for (;;)
+    {
+        // drain is read before the reader cunt; a reader leaving in between changes drain and fails the wait
+        d = LDG_LOAD_ACQUIRE(rw->drain);
+        if ((LDG_RD_ONCE(rw->state) & LDG_RWLOCK_RD_MAX) == 0) { return LDG_ERR_AOK; }
+
+        ldg_futex_wait(&rw->drain, d, LDG_FUTEX_WAIT_INFINITE, rw->wmut.is_shared);
+    }
+}
+
+uint32_t ldg_rwlock_wr_trylock(ldg_rwlock_t *rw)
+{
+    uint32_t expected = 0;
+
+    if (LDG_UNLIKELY(!rw || !rw->wmut.is_init)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    if (ldg_lmut_trylock(&rw->wmut) != LDG_ERR_AOK) { return LDG_ERR_BUSY; }
+
+    if (LDG_CAS(&rw->state, &expected, LDG_RWLOCK_WR)) { return LDG_ERR_AOK; }
+
+    ldg_lmut_unlock(&rw->wmut);
+
+    return LDG_ERR_BUSY;
+}
+
+uint32_t ldg_rwlock_wr_unlock(ldg_rwlock_t *rw)
+{
+    uint32_t s = 0;
+
+    if (LDG_UNLIKELY(!rw || !rw->wmut.is_init)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    if (LDG_UNLIKELY(!(LDG_RD_ONCE(rw->state) & LDG_RWLOCK_WR))) { return LDG_ERR_INVALID; }
+
+    s = LDG_FETCH_AND(rw->state, ~(LDG_RWLOCK_WR | LDG_RWLOCK_RD_WAIT));
+
+    if (s & LDG_RWLOCK_RD_WAIT) { ldg_futex_wake(&rw->state, INT32_MAX, rw->wmut.is_shared); }
+
+    return ldg_lmut_unlock(&rw->wmut);
+}
+
+// seqlock
+
+uint32_t ldg_seqlock_init(ldg_seqlock_t *sl, uint8_t shared)
+{
+    LDG_BOOL_ASSERT(sizeof(ldg_seqlock_t) == 16);
+
+    if (LDG_UNLIKELY(!sl)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    LDG_WR_ONCE(sl->seq, 0);
+
+    return ldg_lmut_init(&sl->wmut, shared);
+}
+
+uint32_t ldg_seqlock_destroy(ldg_seqlock_t *sl)
+{
+    if (LDG_UNLIKELY(!sl || !sl->wmut.is_init)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    return ldg_lmut_destroy(&sl->wmut);
+}
+
+// a writer preempted mid-write would leave readers spinning for its whole time slice; give the cpu back instead
+uint32_t ldg_seqlock_rd_begin(const ldg_seqlock_t *sl, uint32_t *seq)
+{
+    uint32_t s = 0;
+    uint32_t spin = 0;
+
+    if (LDG_UNLIKELY(!sl || !seq)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    for (;;)
+    {
+        s = LDG_LOAD_ACQUIRE(sl->seq);
+        if (LDG_LIKELY(!(s & 1))) { break; }
+
+        if (++spin < LDG_SEQLOCK_SPIN_CUNT) { LDG_PAUSE; }
+        else { spin = 0; sched_yield(); }
+    }
+
+    *seq = s;
+
+    return LDG_ERR_AOK;
+}
+
+// 1 when a write overlapped the read; the copied fields must be thrown away
+uint8_t ldg_seqlock_rd_retry_is(const ldg_seqlock_t *sl, uint32_t seq)
+{
+    if (LDG_UNLIKELY(!sl)) { return 1; }
+
+    // orders the caller's data loads before the re-read of seq
+    LDG_SMP_RMB();
+
+    return LDG_RD_ONCE(sl->seq) != seq;
+}
+
+uint32_t ldg_seqlock_wr_lock(ldg_seqlock_t *sl)
+{
+    uint32_t ret = 0;
+
+    if (LDG_UNLIKELY(!sl || !sl->wmut.is_init)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    ret = ldg_lmut_lock(&sl->wmut);
+    if (LDG_UNLIKELY(ret != LDG_ERR_AOK)) { return ret; }
+
+    LDG_WR_ONCE(sl->seq, sl->seq + 1);
+
+    // the odd seq must be visible before any of the writer's data stores
+    LDG_SMP_WMB();
+
+    return LDG_ERR_AOK;
+}
+
+uint32_t ldg_seqlock_wr_unlock(ldg_seqlock_t *sl)
+{
+    if (LDG_UNLIKELY(!sl || !sl->wmut.is_init)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    if (LDG_UNLIKELY(!(LDG_RD_ONCE(sl->seq) & 1))) { return LDG_ERR_INVALID; }
+
+    LDG_STORE_RELEASE(sl->seq, sl->seq + 1);
+
+    return ldg_lmut_unlock(&sl->wmut);
+}
+
+// evcnt; waiter: prep -> re-check condition -> wait or cancel. notifier: publish -> notify
+
+uint32_t ldg_evcnt_init(ldg_evcnt_t *ec)
+{
+    if (LDG_UNLIKELY(!ec)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    LDG_WR_ONCE(ec->epoch, 0);
+    LDG_WR_ONCE(ec->waiters, 0);
+
+    return LDG_ERR_AOK;
+}
+
+uint32_t ldg_evcnt_prep(ldg_evcnt_t *ec, uint32_t *key_out)
+{
+    if (LDG_UNLIKELY(!ec || !key_out)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    // seq_cst RMW; orders the caller's condition re-check after the waiter is visible
+    LDG_FETCH_ADD(ec->waiters, 1);
+    *key_out = LDG_LOAD_ACQUIRE(ec->epoch);
+
+    return LDG_ERR_AOK;
+}
+
+uint32_t ldg_evcnt_cancel(ldg_evcnt_t *ec)
+{
+    if (LDG_UNLIKELY(!ec)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    LDG_FETCH_SUB(ec->waiters, 1);
+
+    return LDG_ERR_AOK;
+}
+
+uint32_t ldg_evcnt_wait(ldg_evcnt_t *ec, uint32_t key, uint64_t timeout_ns)
+{
+    uint32_t ret = 0;
+
+    if (LDG_UNLIKELY(!ec)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    ret = ldg_futex_wait(&ec->epoch, key, timeout_ns, 0);
+    LDG_FETCH_SUB(ec->waiters, 1);
+
+    return ret;
+}
+
+uint32_t ldg_evcnt_notify(ldg_evcnt_t *ec, uint8_t all)
+{
+    if (LDG_UNLIKELY(!ec)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    // pairs with the RMW in prep(); either the waiter sees the publish or we see the waiter
+    LDG_SMP_MB();
+    if (LDG_LIKELY(LDG_RD_ONCE(ec->waiters) == 0)) { return LDG_ERR_AOK; }
+
+    LDG_FETCH_ADD(ec->epoch, 1);
+
+    return ldg_futex_wake(&ec->epoch, all ? (uint32_t)INT32_MAX : 1, 0);
+}
+
+// wait group
+
+uint32_t ldg_wg_init(ldg_wg_t *wg, uint32_t cunt)
+{
+    if (LDG_UNLIKELY(!wg)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    if (LDG_UNLIKELY(cunt > LDG_WG_CUNT_MAX)) { return LDG_ERR_OVERFLOW; }
+
+    LDG_WR_ONCE(wg->cunt, cunt);
+
+    return LDG_ERR_AOK;
+}
+
+uint32_t ldg_wg_add(ldg_wg_t *wg, uint32_t n)
+{
+    uint32_t w = 0;
+
+    if (LDG_UNLIKELY(!wg)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    w = LDG_RD_ONCE(wg->cunt);
+
+    do
+    {
+        if (LDG_UNLIKELY(n > LDG_WG_CUNT_MAX - (w & LDG_WG_CUNT_MAX))) { return LDG_ERR_OVERFLOW; }
+    } while (!LDG_CAS_WEAK(&wg->cunt, &w, w + n));
+
+    return LDG_ERR_AOK;
+}
+
+// the last done clears the waiter bit in the same CAS and never touches wg afterwards except to wake
+uint32_t ldg_wg_done(ldg_wg_t *wg)
+{
+    uint32_t w = 0;
+    uint32_t next = 0;
+
+    if (LDG_UNLIKELY(!wg)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    w = LDG_RD_ONCE(wg->cunt);
+
+    do
+    {
+        if (LDG_UNLIKELY((w & LDG_WG_CUNT_MAX) == 0)) { return LDG_ERR_INVALID; }
+
+        next = ((w & LDG_WG_CUNT_MAX) == 1) ? 0 : w - 1;
+    } while (!LDG_CAS_WEAK(&wg->cunt, &w, next));
+
+    if (next == 0 && (w & ~LDG_WG_CUNT_MAX)) { return ldg_futex_wake(&wg->cunt, INT32_MAX, 0); }
+
+    return LDG_ERR_AOK;
+}
+
+uint32_t ldg_wg_wait(ldg_wg_t *wg, uint64_t timeout_ms)
+{
+    uint32_t w = 0;
+    uint64_t deadline_ms = 0;
+    uint64_t now_ms = 0;
+    uint64_t remaining = 0;
+
+    if (LDG_UNLIKELY(!wg)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    if ((LDG_LOAD_ACQUIRE(wg->cunt) & LDG_WG_CUNT_MAX) == 0) { return LDG_ERR_AOK; }
+
+    now_ms = sync_monotonic_ms_get();
+    if (LDG_UNLIKELY(now_ms == UINT64_MAX)) { return LDG_ERR_FUNC_ARG_INVALID; }
+
+    if (LDG_UNLIKELY(timeout_ms > UINT64_MAX - now_ms)) { deadline_ms = UINT64_MAX; }
+    else { deadline_ms = now_ms + timeout_ms; }
+
+    for (;;)
+    {
+        w = LDG_LOAD_ACQUIRE(wg->cunt);
+        if ((w & LDG_WG_CUNT_MAX) == 0) { return LDG_ERR_AOK; }
+
+        // announce ourselves so done() knows to issue the wake syscall
+        if (!(w & ~LDG_WG_CUNT_MAX))
+        {
+            if (!LDG_CAS(&wg->cunt, &w, w | ~LDG_WG_CUNT_MAX)) { continue; }
+
+            w |= ~LDG_WG_CUNT_MAX;
+        }
+
+        now_ms = sync_monotonic_ms_get();
+        if (now_ms >= deadline_ms) { return LDG_ERR_TIMEOUT; }
+
+        remaining = deadline_ms - now_ms;
+        remaining = (remaining > LDG_FUTEX_WAIT_INFINITE / LDG_NS_PER_MS) ? LDG_FUTEX_WAIT_INFINITE : remaining * LDG_NS_PER_MS;
+
+        ldg_futex_wait(&wg->cunt, w, remaining, 0);
+    }
+}
+
+uint64_t ldg_wg_cunt_get(const ldg_wg_t *wg)
+{
+    if (LDG_UNLIKELY(!wg)) { return UINT64_MAX; }
+
+    return (uint64_t)(LDG_LOAD_ACQUIRE(wg->cunt) & LDG_WG_CUNT_MAX);
+}
+
+// barrier
+
+uint32_t ldg_barrier_init(ldg_barrier_t *b, uint32_t parties)
+{
+    if (LDG_UNLIKELY(!b)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    if (LDG_UNLIKELY(parties == 0)) { return LDG_ERR_FUNC_ARG_INVALID; }
+
+    LDG_WR_ONCE(b->left, parties);
+    LDG_WR_ONCE(b->parties, parties);
+    LDG_WR_ONCE(b->gen, 0);
+    LDG_WR_ONCE(b->waiters, 0);
+
+    return LDG_ERR_AOK;
+}
+
+uint32_t ldg_barrier_destroy(ldg_barrier_t *b)
+{
+    if (LDG_UNLIKELY(!b)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    if (LDG_UNLIKELY(LDG_RD_ONCE(b->left) != LDG_RD_ONCE(b->parties) || LDG_RD_ONCE(b->waiters))) { return LDG_ERR_BUSY; }
+
+    LDG_WR_ONCE(b->parties, 0);
+
+    return LDG_ERR_AOK;
+}
+
+uint32_t ldg_barrier_wait(ldg_barrier_t *b, uint8_t *is_last_out)
+{
+    uint32_t token = 0;
+    uint32_t ret = 0;
+
+    ret = ldg_barrier_arrive(b, &token, is_last_out);
+    if (LDG_UNLIKELY(ret != LDG_ERR_AOK)) { return ret; }
+
+    return ldg_barrier_token_wait(b, token, LDG_FUTEX_WAIT_INFINITE);
+}
+
+// never blocks; work that does not depend on the other parties can run between arrive and token_wait.
+// exactly one party per phase sees is_last set, and it has already released the rest
+uint32_t ldg_barrier_arrive(ldg_barrier_t *b, uint32_t *token_out, uint8_t *is_last_out)
+{
+    uint32_t gen = 0;
+
+    if (LDG_UNLIKELY(!b || !token_out)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    if (LDG_UNLIKELY(LDG_RD_ONCE(b->parties) == 0)) { return LDG_ERR_NOT_INIT; }
+
+    // read before arriving; gen cannot move until this thread has arrived
+    gen = LDG_LOAD_ACQUIRE(b->gen);
+    *token_out = gen;
+
+    if (LDG_SUB_FETCH(b->left, 1) != 0)
+    {
+        if (is_last_out) { *is_last_out = 0; }
+        return LDG_ERR_AOK;
+    }
+
+    // re-armed before the release, so a fast thread's next arrive counts against the new phase
+    LDG_WR_ONCE(b->left, LDG_RD_ONCE(b->parties));
+
+    // seq_cst RMW; either the waiter count below sees a parked thread or its re-check sees the new gen
+    LDG_ADD_FETCH(b->gen, 1);
+
+    if (is_last_out) { *is_last_out = 1; }
+
+    if (LDG_RD_ONCE(b->waiters) == 0) { return LDG_ERR_AOK; }
+
+    return ldg_futex_wake(&b->gen, INT32_MAX, 0);
+}
+
+// token from arrive(); returns once that phase has completed. timeout_ns is relative;
+// LDG_FUTEX_WAIT_INFINITE waits forever. a timeout leaves this thread counted as arrived
+uint32_t ldg_barrier_token_wait(ldg_barrier_t *b, uint32_t token, uint64_t timeout_ns)
+{
+    uint64_t deadline_ns = UINT64_MAX;
+    uint64_t now_ns = 0;
+    uint32_t ret = LDG_ERR_AOK;
+    uint32_t i = 0;
+
+    if (LDG_UNLIKELY(!b)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    if (LDG_LOAD_ACQUIRE(b->gen) != token) { return LDG_ERR_AOK; }
+
+    // the last party is usually a few hundred ns behind; parking costs a syscall on both sides
+    if (lmut_spin_is())
+    {
+        for (i = 0; i < LDG_BARRIER_SPIN_CUNT; i++)
+        {
+            LDG_PAUSE;
+            if (LDG_LOAD_ACQUIRE(b->gen) != token) { return LDG_ERR_AOK; }
+        }
+    }
+
+    if (timeout_ns == 0) { return LDG_ERR_TIMEOUT; }
+
+    if (timeout_ns != LDG_FUTEX_WAIT_INFINITE)
+    {
+        now_ns = sync_monotonic_ns_get();
+        if (LDG_UNLIKELY(now_ns == UINT64_MAX)) { return LDG_ERR_FUNC_ARG_INVALID; }
+
+        if (LDG_LIKELY(timeout_ns < UINT64_MAX - now_ns)) { deadline_ns = now_ns + timeout_ns; }
+    }
+
+    LDG_FETCH_ADD(b->waiters, 1);
+
+    while (LDG_LOAD_ACQUIRE(b->gen) == token)
+    {
+        if (deadline_ns != UINT64_MAX)
+        {
+            now_ns = sync_monotonic_ns_get();
+            if (now_ns >= deadline_ns) { ret = LDG_ERR_TIMEOUT; break; }
+        }
+
+        ldg_futex_wait(&b->gen, token, (deadline_ns == UINT64_MAX) ? LDG_FUTEX_WAIT_INFINITE : deadline_ns - now_ns, 0);
+    }
+
+    LDG_FETCH_SUB(b->waiters, 1);
+
+    return ret;
+}
@@ -0,0 +1,106 @@
+section .text
+
+; rcx = ctx, rdx = stack lo, r8 = stack size, r9 = fn, [rsp + 40] = arg
+; lays out the frame ldg_ctx_swap pops so the first switch returns into ctx_entry
+global ldg_ctx_make
+ldg_ctx_make:
+    mov     r10, [rsp + 40]
+    lea     rax, [rdx + r8]
+    and     rax, -16
+    sub     rax, 264
+
+    lea     r11, [rax + 264]
+    mov     [rax], r11
+    mov     [rax + 8], rdx
+    mov     [rax + 16], rdx
+
+    xor     r11d, r11d
+    mov     r8d, 20
+    lea     rdx, [rax + 24]
+
+.zero:
+    mov     [rdx], r11
+    add     rdx, 8
+    dec     r8d
+    jnz     .zero
+
+    mov     dword [rax + 184], 0x1F80
+    mov     dword [rax + 188], 0x027F
+    mov     [rax + 192], r11
+    mov     [rax + 200], r11
+    mov     [rax + 208], r9
+    mov     [rax + 216], r10
+    mov     [rax + 224], r11
+    mov     [rax + 232], r11
+    mov     [rax + 240], r11
+    mov     [rax + 248], r11
+    lea     r11, [rel ctx_entry]
+    mov     [rax + 256], r11
+
+    mov     [rcx], rax
+    ret
+
+; rcx = from, rdx = to; win64 callee-saved set including xmm6-15, mxcsr, the x87 control word
+; and the TIB stack base / limit / deallocation stack so __chkstk probes the right stack
+global ldg_ctx_swap
+ldg_ctx_swap:
+    push    rbp
+    push    rbx
+    push    rdi
+    push    rsi
+    push    r12
+    push    r13
+    push    r14
+    push    r15
+    sub     rsp, 168
+    movdqu  [rsp], xmm6
+    movdqu  [rsp + 16], xmm7
+    movdqu  [rsp + 32], xmm8
+    movdqu  [rsp + 48], xmm9
+    movdqu  [rsp + 64], xmm10
+    movdqu  [rsp + 80], xmm11
+    movdqu  [rsp + 96], xmm12
+    movdqu  [rsp + 112], xmm13
+    movdqu  [rsp + 128], xmm14
+    movdqu  [rsp + 144], xmm15
+    stmxcsr [rsp + 160]
+    fnstcw  [rsp + 164]
+    push    qword [gs:0x1478]
+    push    qword [gs:0x10]
+    push    qword [gs:0x08]
+
+    mov     [rcx], rsp
+    mov     rsp, [rdx]
+
+    pop     qword [gs:0x08]
+    pop     qword [gs:0x10]
+    pop     qword [gs:0x1478]
+    ldmxcsr [rsp + 160]
+    fldcw   [rsp + 164]
+    movdqu  xmm6, [rsp]
+    movdqu  xmm7, [rsp + 16]
+    movdqu  xmm8, [rsp + 32]
+    movdqu  xmm9, [rsp + 48]
+    movdqu  xmm10, [rsp + 64]
+    movdqu  xmm11, [rsp + 80]
+    movdqu  xmm12, [rsp + 96]
+    movdqu  xmm13, [rsp + 112]
+    movdqu  xmm14, [rsp + 128]
+    movdqu  xmm15, [rsp + 144]
+    add     rsp, 168
+    pop     r15
+    pop     r14
+    pop     r13
+    pop     r12
+    pop     rsi
+    pop     rdi
+    pop     rbx
+    pop     rbp
+    ret
+
+; first ret of a fresh context lands here with rsp 16-aligned; r13 = fn, r12 = arg
+ctx_entry:
+    mov     rcx, r12
+    sub     rsp, 32
+    call    r13
+    ud2
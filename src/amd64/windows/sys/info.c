@@ -81,3 +81,100 @@ uint32_t ldg_sys_pid_get(uint64_t *pid)
 
     return LDG_ERR_AOK;
 }
+
+// topo
+
+#define INFO_GROUP_CPU_MAX 64
+
+// processor group 0 only; thread affinity masks cannot span groups anyway
+uint32_t ldg_sys_cpu_topo_get(ldg_sys_cpu_topo_t *out, uint32_t cap, uint32_t *cunt)
+{
+    SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX *info = 0x0;
+    uint8_t *buff = 0x0;
+    DWORD len = 0;
+    DWORD off = 0;
+    DWORD_PTR proc_mask = 0;
+    DWORD_PTR sys_mask = 0;
+    uint32_t core_of[INFO_GROUP_CPU_MAX] = { 0 };
+    uint32_t pkg_of[INFO_GROUP_CPU_MAX] = { 0 };
+    uint32_t smt_of[INFO_GROUP_CPU_MAX] = { 0 };
+    uint8_t present[INFO_GROUP_CPU_MAX] = { 0 };
+    uint32_t core_idx = 0;
+    uint32_t pkg_idx = 0;
+    uint32_t smt = 0;
+    uint32_t bit = 0;
+    uint32_t g = 0;
+    uint32_t n = 0;
+    KAFFINITY mask = 0;
+    ldg_sys_cpu_topo_t *t = 0x0;
+
+    if (LDG_UNLIKELY(!out || !cunt)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    *cunt = 0;
+
+    if (LDG_UNLIKELY(cap == 0)) { return LDG_ERR_FUNC_ARG_INVALID; }
+
+    if (LDG_UNLIKELY(GetLogicalProcessorInformationEx(RelationAll, 0x0, &len) || GetLastError() != ERROR_INSUFFICIENT_BUFFER)) { return LDG_ERR_UNSUPPORTED; }
+
+    buff = (uint8_t *)malloc((size_t)len);
+    if (LDG_UNLIKELY(!buff)) { return LDG_ERR_ALLOC_NULL; }
+
+    if (LDG_UNLIKELY(!GetLogicalProcessorInformationEx(RelationAll, (SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX *)buff, &len))) { free(buff); return LDG_ERR_UNSUPPORTED; }
+
+    for (off = 0; off < len; off += info->Size)
+    {
+        info = (SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX *)(buff + off);
+
+        if (info->Relationship != RelationProcessorCore && info->Relationship != RelationProcessorPackage) { continue; }
+
+        for (g = 0; g < info->Processor.GroupCount; g++)
+        {
+            if (info->Processor.GroupMask[g].Group != 0) { continue; }
+
+            mask = info->Processor.GroupMask[g].Mask;
+            smt = 0;
+
+            for (bit = 0; bit < INFO_GROUP_CPU_MAX; bit++)
+            {
+                if (!(mask & ((KAFFINITY)1 << bit))) { continue; }
+
+                if (info->Relationship == RelationProcessorCore)
+                {
+                    present[bit] = 1;
+                    core_of[bit] = core_idx;
+                    smt_of[bit] = smt++;
+                }
+                else { pkg_of[bit] = pkg_idx; }
+            }
+        }
+
+        if (info->Relationship == RelationProcessorCore) { core_idx++; }
+        else { pkg_idx++; }
+    }
+
+    free(buff);
+
+    if (!GetProcessAffinityMask(GetCurrentProcess(), &proc_mask, &sys_mask)) { proc_mask = (DWORD_PTR)~(DWORD_PTR)0; }
+
+    for (bit = 0; bit < INFO_GROUP_CPU_MAX; bit++)
+    {
+        if (!present[bit] || !(proc_mask & ((DWORD_PTR)1 << bit))) { continue; }
+
+        if (n >= cap) { *cunt = n; return LDG_ERR_FULL; }
+
+        t = &out[n];
+
+        if (LDG_UNLIKELY(memset(t, 0, sizeof(ldg_sys_cpu_topo_t)) != t)) { return LDG_ERR_MEM_BAD; }
+
+        t->cpu_id = bit;
+        t->core_id = core_of[bit];
+        t->pkg_id = pkg_of[bit];
+        t->smt_idx = smt_of[bit];
+
+        n++;
+    }
+
+    *cunt = n;
+
+    return LDG_ERR_AOK;
+}
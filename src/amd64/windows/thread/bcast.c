@@ -0,0 +1,314 @@
+#include <string.h>
+#include <windows.h>
+
+#include <dangling/thread/bcast.h>
+#include <dangling/thread/sync.h>
+#include <dangling/core/err.h>
+#include <dangling/mem/secure.h>
+#include <dangling/mem/alloc.h>
+#include <dangling/core/macros.h>
+#include <dangling/core/arith.h>
+#include <dangling/arch/amd64/atomic.h>
+#include <dangling/arch/amd64/fence.h>
+
+// stands in for a consumer index when the producer is the one waiting
+#define BCAST_PRODUCER UINT32_MAX
+
+static uint64_t bcast_monotonic_ns_get(void)
+{
+    LARGE_INTEGER freq = { 0 };
+    LARGE_INTEGER ctr = { 0 };
+
+    if (LDG_UNLIKELY(!QueryPerformanceFrequency(&freq) || !QueryPerformanceCounter(&ctr))) { return UINT64_MAX; }
+
+    // split so the multiply cannot overflow at high counter frequencies
+    return (uint64_t)(ctr.QuadPart / freq.QuadPart) * LDG_NS_PER_SEC + (uint64_t)(ctr.QuadPart % freq.QuadPart) * LDG_NS_PER_SEC / (uint64_t)freq.QuadPart;
+}
+
+static uint8_t bcast_cap_pow2_is(uint64_t cap)
+{
+    return (cap > 0) && ((cap & (cap - 1)) == 0);
+}
+
+// only spin and yield waiters never park, so only they let the wakeup side skip its fence
+static uint8_t bcast_park_is(const ldg_bcast_t *b)
+{
+    return b->wait == LDG_BCAST_WAIT_SPIN_YIELD_PARK || b->wait == LDG_BCAST_WAIT_PARK;
+}
+
+static uint64_t bcast_gate_get(const ldg_bcast_t *b)
+{
+    uint64_t gate = UINT64_MAX;
+    uint64_t seq = 0;
+    uint32_t i = 0;
+
+    for (i = 0; i < b->consumer_cunt; i++)
+    {
+        seq = LDG_LOAD_ACQUIRE(b->cursors[i].seq);
+        if (seq < gate) { gate = seq; }
+    }
+
+    return gate;
+}
+
+// the producer rescans the cursors only when its cached gate says the ring is full
+static uint8_t bcast_ready_is(ldg_bcast_t *b, uint32_t c)
+{
+    if (c != BCAST_PRODUCER) { return LDG_LOAD_ACQUIRE(b->pub) != LDG_RD_ONCE(b->cursors[c].seq); }
+
+    if (b->claim - b->gate < b->cap) { return 1; }
+
+    b->gate = bcast_gate_get(b);
+
+    return b->claim - b->gate < b->cap;
+}
+
+static uint32_t bcast_wait(ldg_bcast_t *b, uint32_t c, uint64_t timeout_ns)
+{
+    ldg_evcnt_t *ec = (c == BCAST_PRODUCER) ? &b->space_ec : &b->data_ec;
+    uint64_t deadline_ns = UINT64_MAX;
+    uint64_t now_ns = 0;
+    uint64_t remaining = LDG_FUTEX_WAIT_INFINITE;
+    uint32_t key = 0;
+    uint32_t i = 0;
+
+    if (bcast_ready_is(b, c)) { return LDG_ERR_AOK; }
+
+    if (timeout_ns == 0) { return LDG_ERR_TIMEOUT; }
+
+    if (timeout_ns != LDG_FUTEX_WAIT_INFINITE)
+    {
+        now_ns = bcast_monotonic_ns_get();
+        if (LDG_UNLIKELY(now_ns == UINT64_MAX)) { return LDG_ERR_FUNC_ARG_INVALID; }
+
+        if (LDG_LIKELY(timeout_ns < UINT64_MAX - now_ns)) { deadline_ns = now_ns + timeout_ns; }
+    }
+
+    for (i = 0;; i++)
+    {
+        if (bcast_ready_is(b, c)) { return LDG_ERR_AOK; }
+
+        if (deadline_ns != UINT64_MAX && (i & 63) == 0 && bcast_monotonic_ns_get() >= deadline_ns) { return LDG_ERR_TIMEOUT; }
+
+        if (b->wait == LDG_BCAST_WAIT_SPIN || (b->wait == LDG_BCAST_WAIT_SPIN_YIELD_PARK && i < LDG_BCAST_SPIN_CUNT))
+        {
+            LDG_PAUSE;
+            continue;
+        }
+
+        if (b->wait == LDG_BCAST_WAIT_YIELD || (b->wait == LDG_BCAST_WAIT_SPIN_YIELD_PARK && i < LDG_BCAST_SPIN_CUNT + LDG_BCAST_YIELD_CUNT))
+        {
+            SwitchToThread();
+            continue;
+        }
+
+        ldg_evcnt_prep(ec, &key);
+
+        if (bcast_ready_is(b, c)) { ldg_evcnt_cancel(ec); return LDG_ERR_AOK; }
+
+        if (deadline_ns != UINT64_MAX)
+        {
+            now_ns = bcast_monotonic_ns_get();
+            if (now_ns >= deadline_ns) { ldg_evcnt_cancel(ec); return LDG_ERR_TIMEOUT; }
+
+            remaining = deadline_ns - now_ns;
+        }
+
+        ldg_evcnt_wait(ec, key, remaining);
+    }
+}
+
+uint32_t ldg_bcast_init(ldg_bcast_t *b, uint64_t item_size, uint64_t cap, uint32_t consumer_cunt, uint32_t wait)
+{
+    void *buff_tmp = 0x0;
+    uint64_t buff_size = 0;
+    uint32_t ret = 0;
+
+    if (LDG_UNLIKELY(!b)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    if (LDG_UNLIKELY(item_size == 0 || !bcast_cap_pow2_is(cap))) { return LDG_ERR_FUNC_ARG_INVALID; }
+
+    if (LDG_UNLIKELY(consumer_cunt == 0 || consumer_cunt > LDG_BCAST_CONSUMER_MAX)) { return LDG_ERR_FUNC_ARG_INVALID; }
+
+    if (LDG_UNLIKELY(wait > LDG_BCAST_WAIT_PARK)) { return LDG_ERR_FUNC_ARG_INVALID; }
+
+    if (LDG_UNLIKELY(ldg_arith_64_mul(item_size, cap, &buff_size) != LDG_ERR_AOK)) { return LDG_ERR_OVERFLOW; }
+
+    if (LDG_UNLIKELY(memset(b, 0, sizeof(ldg_bcast_t)) != b)) { return LDG_ERR_MEM_BAD; }
+
+    ret = ldg_mem_alloc(buff_size, &buff_tmp);
+    if (LDG_UNLIKELY(ret != LDG_ERR_AOK)) { return ret; }
+
+    b->buff = (uint8_t *)buff_tmp;
+
+    if (LDG_UNLIKELY(memset(b->buff, 0, buff_size) != b->buff)) { ldg_mem_dealloc(b->buff); b->buff = 0x0; return LDG_ERR_MEM_BAD; }
+
+    b->item_size = item_size;
+    b->cap = cap;
+    b->mask = cap - 1;
+    b->consumer_cunt = consumer_cunt;
+    b->wait = wait;
+
+    ldg_evcnt_init(&b->data_ec);
+    ldg_evcnt_init(&b->space_ec);
+
+    return LDG_ERR_AOK;
+}
+
+uint32_t ldg_bcast_shutdown(ldg_bcast_t *b)
+{
+    if (LDG_UNLIKELY(!b)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    if (b->buff)
+    {
+        ldg_mem_dealloc(b->buff);
+        b->buff = 0x0;
+    }
+
+    b->item_size = 0;
+    b->cap = 0;
+    b->mask = 0;
+    b->consumer_cunt = 0;
+
+    return LDG_ERR_AOK;
+}
+
+// producer only. the slot is the producer's until publish(); several may be claimed and then published at once
+uint32_t ldg_bcast_claim(ldg_bcast_t *b, void **slot_out, uint64_t *seq_out)
+{
+    if (LDG_UNLIKELY(!b || !slot_out || !seq_out)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    if (LDG_UNLIKELY(!b->buff)) { return LDG_ERR_NOT_INIT; }
+
+    if (!bcast_ready_is(b, BCAST_PRODUCER)) { return LDG_ERR_FULL; }
+
+    *seq_out = b->claim;
+    *slot_out = b->buff + (b->claim & b->mask) * b->item_size;
+    b->claim++;
+
+    return LDG_ERR_AOK;
+}
+
+// timeout_ns is relative; LDG_FUTEX_WAIT_INFINITE waits forever
+uint32_t ldg_bcast_claim_wait(ldg_bcast_t *b, void **slot_out, uint64_t *seq_out, uint64_t timeout_ns)
+{
+    uint32_t ret = 0;
+
+    if (LDG_UNLIKELY(!b || !slot_out || !seq_out)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    if (LDG_UNLIKELY(!b->buff)) { return LDG_ERR_NOT_INIT; }
+
+    ret = bcast_wait(b, BCAST_PRODUCER, timeout_ns);
+    if (ret != LDG_ERR_AOK) { return ret; }
+
+    return ldg_bcast_claim(b, slot_out, seq_out);
+}
+
+// makes every claimed sequence up to and including seq visible to all consumers
+uint32_t ldg_bcast_publish(ldg_bcast_t *b, uint64_t seq)
+{
+    if (LDG_UNLIKELY(!b)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    if (LDG_UNLIKELY(!b->buff)) { return LDG_ERR_NOT_INIT; }
+
+    if (LDG_UNLIKELY(seq >= b->claim)) { return LDG_ERR_INVALID; }
+
+    if (seq < LDG_RD_ONCE(b->pub)) { return LDG_ERR_AOK; }
+
+    LDG_STORE_RELEASE(b->pub, seq + 1);
+
+    if (bcast_park_is(b)) { return ldg_evcnt_notify(&b->data_ec, 1); }
+
+    return LDG_ERR_AOK;
+}
+
+uint32_t ldg_bcast_push(ldg_bcast_t *b, const void *item)
+{
+    void *slot = 0x0;
+    uint64_t seq = 0;
+    uint32_t ret = 0;
+
+    if (LDG_UNLIKELY(!b || !item)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    ret = ldg_bcast_claim(b, &slot, &seq);
+    if (ret != LDG_ERR_AOK) { return ret; }
+
+    if (LDG_UNLIKELY(ldg_mem_secure_copy(slot, item, b->item_size) != LDG_ERR_AOK)) { return LDG_ERR_MEM_BAD; }
+
+    return ldg_bcast_publish(b, seq);
+}
+
+// everything published past the consumer's cursor, as one batch: sequences [seq, seq + cunt).
+// read them in place with slot_get(); they stay valid until release()
+uint32_t ldg_bcast_read(ldg_bcast_t *b, uint32_t consumer, uint64_t *seq_out, uint64_t *cunt_out)
+{
+    uint64_t cur = 0;
+    uint64_t pub = 0;
+
+    if (LDG_UNLIKELY(!b || !seq_out || !cunt_out)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    if (LDG_UNLIKELY(!b->buff)) { return LDG_ERR_NOT_INIT; }
+
+    if (LDG_UNLIKELY(consumer >= b->consumer_cunt)) { return LDG_ERR_FUNC_ARG_INVALID; }
+
+    cur = LDG_RD_ONCE(b->cursors[consumer].seq);
+    pub = LDG_LOAD_ACQUIRE(b->pub);
+
+    *seq_out = cur;
+    *cunt_out = pub - cur;
+
+    return (pub == cur) ? LDG_ERR_EMPTY : LDG_ERR_AOK;
+}
+
+// timeout_ns is relative; LDG_FUTEX_WAIT_INFINITE waits forever
+uint32_t ldg_bcast_read_wait(ldg_bcast_t *b, uint32_t consumer, uint64_t *seq_out, uint64_t *cunt_out, uint64_t timeout_ns)
+{
+    uint32_t ret = 0;
+
+    if (LDG_UNLIKELY(!b || !seq_out || !cunt_out)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    if (LDG_UNLIKELY(!b->buff)) { return LDG_ERR_NOT_INIT; }
+
+    if (LDG_UNLIKELY(consumer >= b->consumer_cunt)) { return LDG_ERR_FUNC_ARG_INVALID; }
+
+    ret = bcast_wait(b, consumer, timeout_ns);
+    if (ret != LDG_ERR_AOK) { return ret; }
+
+    return ldg_bcast_read(b, consumer, seq_out, cunt_out);
+}
+
+// no range check; seq must come from claim() or a read() batch that has not been released
+void* ldg_bcast_slot_get(const ldg_bcast_t *b, uint64_t seq)
+{
+    if (LDG_UNLIKELY(!b || !b->buff)) { return 0x0; }
+
+    return b->buff + (seq & b->mask) * b->item_size;
+}
+
+// hands the consumer's oldest cunt items back; the producer reuses a slot once every consumer has
+uint32_t ldg_bcast_release(ldg_bcast_t *b, uint32_t consumer, uint64_t cunt)
+{
+    uint64_t cur = 0;
+
+    if (LDG_UNLIKELY(!b)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    if (LDG_UNLIKELY(!b->buff)) { return LDG_ERR_NOT_INIT; }
+
+    if (LDG_UNLIKELY(consumer >= b->consumer_cunt)) { return LDG_ERR_FUNC_ARG_INVALID; }
+
+    cur = LDG_RD_ONCE(b->cursors[consumer].seq);
+    if (LDG_UNLIKELY(cunt > LDG_LOAD_ACQUIRE(b->pub) - cur)) { return LDG_ERR_INVALID; }
+
+    LDG_STORE_RELEASE(b->cursors[consumer].seq, cur + cunt);
+
+    if (bcast_park_is(b)) { return ldg_evcnt_notify(&b->space_ec, 0); }
+
+    return LDG_ERR_AOK;
+}
+
+uint64_t ldg_bcast_cunt_get(const ldg_bcast_t *b, uint32_t consumer)
+{
+    if (LDG_UNLIKELY(!b || consumer >= b->consumer_cunt)) { return UINT64_MAX; }
+
+    return LDG_LOAD_ACQUIRE(b->pub) - LDG_LOAD_ACQUIRE(b->cursors[consumer].seq);
+}
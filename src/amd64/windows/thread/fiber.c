@@ -0,0 +1,504 @@
+#include <string.h>
+#include <windows.h>
+
+#include <dangling/thread/fiber.h>
+#include <dangling/thread/pool.h>
+#include <dangling/thread/timer.h>
+#include <dangling/thread/mpmc.h>
+#include <dangling/thread/yield.h>
+#include <dangling/sys/info.h>
+#include <dangling/core/err.h>
+#include <dangling/mem/alloc.h>
+#include <dangling/core/macros.h>
+#include <dangling/arch/amd64/ctx.h>
+#include <dangling/arch/amd64/atomic.h>
+#include <dangling/arch/amd64/fence.h>
+
+#define FIBER_ACT_YIELD 0
+#define FIBER_ACT_SUSPEND 1
+#define FIBER_ACT_EXIT 2
+
+// pending resume() permit, carried in the state word next to RUNNING or READY
+#define FIBER_WAKE 0x100u
+
+static __thread ldg_fiber_t *fiber_current = 0x0;
+
+// a fiber may resume on another worker; the accessors stay out of line so no caller caches the TLS address across a switch
+static __attribute__((noinline)) ldg_fiber_t* fiber_current_get(void)
+{
+    return fiber_current;
+}
+
+static __attribute__((noinline)) void fiber_current_set(ldg_fiber_t *f)
+{
+    fiber_current = f;
+}
+
+static uint64_t fiber_monotonic_ms_get(void)
+{
+    return (uint64_t)GetTickCount64();
+}
+
+static uint64_t fiber_deadline_get(uint64_t timeout_ms)
+{
+    uint64_t now_ms = fiber_monotonic_ms_get();
+
+    if (LDG_UNLIKELY(now_ms == UINT64_MAX || timeout_ms > UINT64_MAX - now_ms)) { return UINT64_MAX; }
+
+    return now_ms + timeout_ms;
+}
+
+// stacks
+
+// the low page is PAGE_NOACCESS so an overflow faults instead of running into the neighbouring stack
+static uint32_t fiber_stack_get(ldg_fiber_sched_t *s, uint8_t **out)
+{
+    uint8_t *base = 0x0;
+    void *map = 0x0;
+    DWORD old = 0;
+
+    ldg_mut_lock(&s->mut);
+
+    if (s->stack_free)
+    {
+        base = (uint8_t *)s->stack_free;
+        s->stack_free = *(void **)(base + s->page_size);
+        s->stack_cunt--;
+    }
+
+    ldg_mut_unlock(&s->mut);
+
+    if (base) { *out = base; return LDG_ERR_AOK; }
+
+    map = VirtualAlloc(0x0, (SIZE_T)(s->page_size + s->stack_size), MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    if (LDG_UNLIKELY(!map)) { return LDG_ERR_ALLOC_NULL; }
+
+    if (LDG_UNLIKELY(!VirtualProtect(map, (SIZE_T)s->page_size, PAGE_NOACCESS, &old))) { VirtualFree(map, 0, MEM_RELEASE); return LDG_ERR_MEM_BAD; }
+
+    *out = (uint8_t *)map;
+
+    return LDG_ERR_AOK;
+}
+
+// the freelist link lives in the lowest usable word of the cached stack
+static void fiber_stack_put(ldg_fiber_sched_t *s, uint8_t *base)
+{
+    ldg_mut_lock(&s->mut);
+
+    if (s->stack_cunt < s->stack_cap)
+    {
+        *(void **)(base + s->page_size) = s->stack_free;
+        s->stack_free = base;
+        s->stack_cunt++;
+
+        ldg_mut_unlock(&s->mut);
+        return;
+    }
+
+    ldg_mut_unlock(&s->mut);
+
+    VirtualFree(base, 0, MEM_RELEASE);
+}
+
+// lifetime
+
+static void fiber_unref(ldg_fiber_t *f)
+{
+    ldg_fiber_sched_t *s = f->sched;
+
+    if (LDG_SUB_FETCH(f->ref, 1) != 0) { return; }
+
+    if (f->stack) { fiber_stack_put(s, f->stack); }
+
+    ldg_mem_dealloc(f);
+
+    LDG_FETCH_SUB(s->live, 1);
+}
+
+static uint32_t fiber_run(void *arg);
+
+static uint32_t fiber_submit(ldg_fiber_t *f)
+{
+    return ldg_thread_pool_submit(f->sched->pool, fiber_run, f);
+}
+
+// moves to next while keeping a pending permit
+static void fiber_state_move(ldg_fiber_t *f, uint32_t next)
+{
+    uint32_t s = LDG_RD_ONCE(f->state);
+
+    while (!LDG_CAS(&f->state, &s, (s & FIBER_WAKE) | next)) { }
+}
+
+static void fiber_main(void *arg)
+{
+    ldg_fiber_t *f = (ldg_fiber_t *)arg;
+
+    f->result = f->func(f->arg);
+    f->action = FIBER_ACT_EXIT;
+
+    ldg_ctx_swap(&f->ctx, &f->home);
+}
+
+// one pool task per time slice: switch in, and on the way out act on whatever the fiber asked for;
+// a requeue the pool refuses (shutting down, out of memory) runs the next slice here rather than losing the fiber
+static uint32_t fiber_run(void *arg)
+{
+    ldg_fiber_t *f = (ldg_fiber_t *)arg;
+    uint32_t expected = 0;
+
+    for (;;)
+    {
+        fiber_state_move(f, LDG_FIBER_RUNNING);
+
+        fiber_current_set(f);
+        ldg_ctx_swap(&f->home, &f->ctx);
+        fiber_current_set(0x0);
+
+        if (f->action == FIBER_ACT_YIELD)
+        {
+            fiber_state_move(f, LDG_FIBER_READY);
+            if (fiber_submit(f) == LDG_ERR_AOK) { return LDG_ERR_AOK; }
+            continue;
+        }
+
+        if (f->action != FIBER_ACT_SUSPEND) { break; }
+
+        // once SUSPENDED is visible a resume() may requeue it and it may finish elsewhere; f is off limits
+        expected = LDG_FIBER_RUNNING;
+        if (LDG_CAS(&f->state, &expected, LDG_FIBER_SUSPENDED)) { return LDG_ERR_AOK; }
+
+        // a resume() landed while we were switching out and left its permit; spend it on a requeue
+        LDG_STORE_RELEASE(f->state, LDG_FIBER_READY);
+        if (fiber_submit(f) == LDG_ERR_AOK) { return LDG_ERR_AOK; }
+    }
+
+    // off its stack for good; hand the stack back before the joiner can free the fiber
+    fiber_stack_put(f->sched, f->stack);
+    f->stack = 0x0;
+
+    LDG_STORE_RELEASE(f->state, LDG_FIBER_DONE);
+    ldg_wg_done(&f->done);
+
+    return LDG_ERR_AOK;
+}
+
+// a resume the pool refuses still has to run the fiber, or it stays READY with nothing queued and its joiner hangs.
+// the caller may itself be a fiber, whose current pointer fiber_run clears on the way out
+static void fiber_run_inline(ldg_fiber_t *f)
+{
+    ldg_fiber_t *self = fiber_current_get();
+
+    fiber_run(f);
+    fiber_current_set(self);
+}
+
+static uint32_t fiber_timer_fire(void *arg)
+{
+    ldg_fiber_t *f = (ldg_fiber_t *)arg;
+
+    LDG_STORE_RELEASE(f->slept, 1);
+    ldg_fiber_resume(f);
+    fiber_unref(f);
+
+    return LDG_ERR_AOK;
+}
+
+// a few yields, then exponentially longer sleeps on the wheel; never parks the worker thread
+static void fiber_backoff(uint32_t *round)
+{
+    uint64_t ns = 0;
+
+    if (*round < LDG_FIBER_SPIN_CUNT)
+    {
+        (*round)++;
+        ldg_fiber_yield();
+        return;
+    }
+
+    ns = (uint64_t)LDG_KIB << (*round - LDG_FIBER_SPIN_CUNT);
+    if (ns >= LDG_FIBER_SLEEP_MAX_NS) { ns = LDG_FIBER_SLEEP_MAX_NS; }
+    else { (*round)++; }
+
+    ldg_fiber_sleep(ns);
+}
+
+// scheduler
+
+// stack_size and stack_cap of 0 take LDG_FIBER_STACK_SIZE and LDG_FIBER_STACK_CACHE
+uint32_t ldg_fiber_sched_create(ldg_thread_pool_t *pool, uint64_t stack_size, uint64_t stack_cap, ldg_fiber_sched_t **out)
+{
+    ldg_fiber_sched_t *s = 0x0;
+    void *tmp = 0x0;
+    uint64_t page = 0;
+    uint32_t ret = 0;
+
+    if (LDG_UNLIKELY(!pool || !out)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    *out = 0x0;
+
+    if (LDG_UNLIKELY(!pool->is_init)) { return LDG_ERR_FUNC_ARG_INVALID; }
+
+    ret = ldg_sys_page_size_get(&page);
+    if (LDG_UNLIKELY(ret != LDG_ERR_AOK)) { return ret; }
+
+    if (stack_size == 0) { stack_size = LDG_FIBER_STACK_SIZE; }
+    if (LDG_UNLIKELY(stack_size > UINT64_MAX - 2 * page)) { return LDG_ERR_OVERFLOW; }
+
+    stack_size = (stack_size + page - 1) / page * page;
+
+    ret = ldg_mem_alloc((uint64_t)sizeof(ldg_fiber_sched_t), &tmp);
+    if (LDG_UNLIKELY(ret != LDG_ERR_AOK)) { return ret; }
+
+    s = (ldg_fiber_sched_t *)tmp;
+
+    if (LDG_UNLIKELY(memset(s, 0, sizeof(ldg_fiber_sched_t)) != s)) { ldg_mem_dealloc(s); return LDG_ERR_MEM_BAD; }
+
+    ret = ldg_mut_init(&s->mut, 0);
+    if (LDG_UNLIKELY(ret != LDG_ERR_AOK)) { ldg_mem_dealloc(s); return ret; }
+
+    // sleep timers only resume fibers, so they fire straight on the tick thread
+    ret = ldg_timer_wheel_create(0x0, 0, &s->wheel);
+    if (ret == LDG_ERR_AOK) { ret = ldg_timer_wheel_start(s->wheel); }
+    if (LDG_UNLIKELY(ret != LDG_ERR_AOK))
+    {
+        if (s->wheel) { ldg_timer_wheel_destroy(&s->wheel); }
+        ldg_mut_destroy(&s->mut);
+        ldg_mem_dealloc(s);
+        return ret;
+    }
+
+    s->pool = pool;
+    s->page_size = page;
+    s->stack_size = stack_size;
+    s->stack_cap = stack_cap ? stack_cap : LDG_FIBER_STACK_CACHE;
+
+    *out = s;
+
+    return LDG_ERR_AOK;
+}
+
+// BUSY while any fiber created from it has not been destroyed
+uint32_t ldg_fiber_sched_destroy(ldg_fiber_sched_t **s)
+{
+    uint8_t *base = 0x0;
+    uint32_t ret = 0;
+
+    if (LDG_UNLIKELY(!s || !*s)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    if (LDG_UNLIKELY(LDG_RD_ONCE((*s)->live) != 0)) { return LDG_ERR_BUSY; }
+
+    ret = ldg_timer_wheel_destroy(&(*s)->wheel);
+
+    while ((*s)->stack_free)
+    {
+        base = (uint8_t *)(*s)->stack_free;
+        (*s)->stack_free = *(void **)(base + (*s)->page_size);
+        VirtualFree(base, 0, MEM_RELEASE);
+    }
+
+    ldg_mut_destroy(&(*s)->mut);
+    ldg_mem_dealloc(*s);
+    *s = 0x0;
+
+    return ret;
+}
+
+// fibers
+
+// the fiber is runnable on return; it starts on whichever worker picks it up first
+uint32_t ldg_fiber_create(ldg_fiber_sched_t *s, ldg_thread_pool_worker_func_t func, void *arg, ldg_fiber_t **out)
+{
+    ldg_fiber_t *f = 0x0;
+    void *tmp = 0x0;
+    uint32_t ret = 0;
+
+    if (LDG_UNLIKELY(!s || !func || !out)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    *out = 0x0;
+
+    ret = ldg_mem_alloc((uint64_t)sizeof(ldg_fiber_t), &tmp);
+    if (LDG_UNLIKELY(ret != LDG_ERR_AOK)) { return ret; }
+
+    f = (ldg_fiber_t *)tmp;
+
+    if (LDG_UNLIKELY(memset(f, 0, sizeof(ldg_fiber_t)) != f)) { ldg_mem_dealloc(f); return LDG_ERR_MEM_BAD; }
+
+    ret = fiber_stack_get(s, &f->stack);
+    if (LDG_UNLIKELY(ret != LDG_ERR_AOK)) { ldg_mem_dealloc(f); return ret; }
+
+    f->sched = s;
+    f->func = func;
+    f->arg = arg;
+    f->ref = 1;
+    f->state = LDG_FIBER_READY;
+
+    ldg_wg_init(&f->done, 1);
+    ldg_ctx_make(&f->ctx, f->stack + s->page_size, s->stack_size, fiber_main, f);
+
+    LDG_FETCH_ADD(s->live, 1);
+
+    ret = fiber_submit(f);
+    if (LDG_UNLIKELY(ret != LDG_ERR_AOK)) { fiber_unref(f); return ret; }
+
+    *out = f;
+
+    return LDG_ERR_AOK;
+}
+
+// BUSY until the fiber's function has returned; a pending sleep timer keeps the memory alive until it fires
+uint32_t ldg_fiber_destroy(ldg_fiber_t **f)
+{
+    if (LDG_UNLIKELY(!f || !*f)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    if (LDG_UNLIKELY(ldg_wg_cunt_get(&(*f)->done) != 0)) { return LDG_ERR_BUSY; }
+
+    fiber_unref(*f);
+    *f = 0x0;
+
+    return LDG_ERR_AOK;
+}
+
+// from a fiber the wait yields; from a pool worker it helps; elsewhere it blocks
+uint32_t ldg_fiber_join(ldg_fiber_t *f, uint64_t timeout_ms)
+{
+    ldg_fiber_t *self = fiber_current_get();
+    uint64_t deadline_ms = 0;
+    uint32_t round = 0;
+
+    if (LDG_UNLIKELY(!f)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    if (LDG_UNLIKELY(f == self)) { return LDG_ERR_INVALID; }
+
+    if (!self) { return ldg_thread_pool_wg_wait(f->sched->pool, &f->done, timeout_ms); }
+
+    deadline_ms = fiber_deadline_get(timeout_ms);
+
+    while (ldg_wg_cunt_get(&f->done) != 0)
+    {
+        if (fiber_monotonic_ms_get() >= deadline_ms) { return LDG_ERR_TIMEOUT; }
+
+        fiber_backoff(&round);
+    }
+
+    return LDG_ERR_AOK;
+}
+
+uint32_t ldg_fiber_result_get(const ldg_fiber_t *f, uint32_t *result)
+{
+    if (LDG_UNLIKELY(!f || !result)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    if (ldg_wg_cunt_get(&f->done) != 0) { return LDG_ERR_AGAIN; }
+
+    *result = f->result;
+
+    return LDG_ERR_AOK;
+}
+
+ldg_fiber_t* ldg_fiber_self(void)
+{
+    return fiber_current_get();
+}
+
+// back of the pool's queue; INVALID outside a fiber
+uint32_t ldg_fiber_yield(void)
+{
+    ldg_fiber_t *f = fiber_current_get();
+
+    if (LDG_UNLIKELY(!f)) { return LDG_ERR_INVALID; }
+
+    f->action = FIBER_ACT_YIELD;
+    ldg_ctx_swap(&f->ctx, &f->home);
+
+    return LDG_ERR_AOK;
+}
+
+// park/unpark semantics: one permit, so a resume() that came first makes this return at once.
+// may return without a matching resume(); wait in a loop on your own condition
+uint32_t ldg_fiber_suspend(void)
+{
+    ldg_fiber_t *f = fiber_current_get();
+    uint32_t expected = LDG_FIBER_RUNNING | FIBER_WAKE;
+
+    if (LDG_UNLIKELY(!f)) { return LDG_ERR_INVALID; }
+
+    if (LDG_CAS(&f->state, &expected, LDG_FIBER_RUNNING)) { return LDG_ERR_AOK; }
+
+    f->action = FIBER_ACT_SUSPEND;
+    ldg_ctx_swap(&f->ctx, &f->home);
+
+    return LDG_ERR_AOK;
+}
+
+// any thread; requeues a suspended fiber, or runs it on the calling thread if the pool will not take it, otherwise
+// leaves a permit for its next suspend()
+uint32_t ldg_fiber_resume(ldg_fiber_t *f)
+{
+    uint32_t s = 0;
+
+    if (LDG_UNLIKELY(!f)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    s = LDG_RD_ONCE(f->state);
+
+    for (;;)
+    {
+        if (s == LDG_FIBER_SUSPENDED)
+        {
+            if (!LDG_CAS(&f->state, &s, LDG_FIBER_READY)) { continue; }
+
+            if (fiber_submit(f) != LDG_ERR_AOK) { fiber_run_inline(f); }
+
+            return LDG_ERR_AOK;
+        }
+
+        if (s == LDG_FIBER_DONE || (s & FIBER_WAKE)) { return LDG_ERR_AOK; }
+
+        if (LDG_CAS(&f->state, &s, s | FIBER_WAKE)) { return LDG_ERR_AOK; }
+    }
+}
+
+// suspends on the scheduler's timer wheel; outside a fiber it is ldg_thread_yield()
+uint32_t ldg_fiber_sleep(uint64_t ns)
+{
+    ldg_fiber_t *f = fiber_current_get();
+    uint32_t ret = 0;
+
+    if (!f) { return ldg_thread_yield(ns); }
+
+    LDG_WR_ONCE(f->slept, 0);
+
+    // the timer's reference keeps f alive until the callback is done with it
+    LDG_FETCH_ADD(f->ref, 1);
+
+    ret = ldg_timer_arm(f->sched->wheel, &f->timer, ns, 0, fiber_timer_fire, f);
+    if (LDG_UNLIKELY(ret != LDG_ERR_AOK)) { LDG_FETCH_SUB(f->ref, 1); return ret; }
+
+    while (!LDG_LOAD_ACQUIRE(f->slept)) { ldg_fiber_suspend(); }
+
+    return LDG_ERR_AOK;
+}
+
+// inside a fiber a pop that finds the queue empty backs off with yields and wheel sleeps
+// instead of parking the worker; outside one it is ldg_mpmc_wait()
+uint32_t ldg_fiber_mpmc_wait(ldg_mpmc_queue_t *q, void *item_out, uint64_t timeout_ms)
+{
+    uint64_t deadline_ms = 0;
+    uint32_t round = 0;
+    uint32_t ret = 0;
+
+    if (LDG_UNLIKELY(!q || !item_out)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    if (!fiber_current_get()) { return ldg_mpmc_wait(q, item_out, timeout_ms); }
+
+    deadline_ms = fiber_deadline_get(timeout_ms);
+
+    for (;;)
+    {
+        ret = ldg_mpmc_pop(q, item_out);
+        if (ret != LDG_ERR_EMPTY && ret != LDG_ERR_AGAIN) { return ret; }
+
+        if (fiber_monotonic_ms_get() >= deadline_ms) { return LDG_ERR_TIMEOUT; }
+
+        fiber_backoff(&round);
+    }
+}
@@ -0,0 +1,389 @@
+#include <string.h>
+#include <windows.h>
+
+#include <dangling/thread/graph.h>
+#include <dangling/thread/pool.h>
+#include <dangling/core/err.h>
+#include <dangling/mem/alloc.h>
+#include <dangling/core/macros.h>
+#include <dangling/core/arith.h>
+#include <dangling/arch/amd64/atomic.h>
+#include <dangling/arch/amd64/fence.h>
+
+static uint64_t graph_monotonic_ns_get(void)
+{
+    LARGE_INTEGER freq = { 0 };
+    LARGE_INTEGER ctr = { 0 };
+
+    if (LDG_UNLIKELY(!QueryPerformanceFrequency(&freq) || !QueryPerformanceCounter(&ctr))) { return 0; }
+
+    // split so the multiply cannot overflow at high counter frequencies
+    return (uint64_t)(ctr.QuadPart / freq.QuadPart) * LDG_NS_PER_SEC + (uint64_t)(ctr.QuadPart % freq.QuadPart) * LDG_NS_PER_SEC / (uint64_t)freq.QuadPart;
+}
+
+static uint32_t graph_arr_alloc(uint64_t cunt, uint64_t item_size, void **out)
+{
+    uint64_t size = 0;
+
+    *out = 0x0;
+
+    if (cunt == 0) { return LDG_ERR_AOK; }
+
+    if (LDG_UNLIKELY(ldg_arith_64_mul(cunt, item_size, &size) != LDG_ERR_AOK)) { return LDG_ERR_OVERFLOW; }
+
+    return ldg_mem_alloc(size, out);
+}
+
+uint32_t ldg_task_graph_create(ldg_thread_pool_t *pool, uint32_t node_cap, uint32_t edge_cap, ldg_task_graph_t **out)
+{
+    ldg_task_graph_t *g = 0x0;
+    void *tmp = 0x0;
+    uint32_t ret = 0;
+
+    if (LDG_UNLIKELY(!pool || !out)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    *out = 0x0;
+
+    if (LDG_UNLIKELY(!pool->is_init || node_cap == 0 || node_cap == LDG_TASK_GRAPH_NODE_NONE)) { return LDG_ERR_FUNC_ARG_INVALID; }
+
+    ret = ldg_mem_alloc((uint64_t)sizeof(ldg_task_graph_t), &tmp);
+    if (LDG_UNLIKELY(ret != LDG_ERR_AOK)) { return ret; }
+
+    g = (ldg_task_graph_t *)tmp;
+
+    if (LDG_UNLIKELY(memset(g, 0, sizeof(ldg_task_graph_t)) != g)) { ldg_mem_dealloc(g); return LDG_ERR_MEM_BAD; }
+
+    g->pool = pool;
+    g->node_cap = node_cap;
+    g->edge_cap = edge_cap;
+
+    ret = graph_arr_alloc(node_cap, sizeof(ldg_task_graph_node_t), &tmp);
+    g->nodes = (ldg_task_graph_node_t *)tmp;
+
+    if (ret == LDG_ERR_AOK) { ret = graph_arr_alloc(node_cap, sizeof(uint32_t), &tmp); g->order = (uint32_t *)tmp; }
+
+    if (ret == LDG_ERR_AOK) { ret = graph_arr_alloc(edge_cap, sizeof(uint32_t), &tmp); g->edge_src = (uint32_t *)tmp; }
+
+    if (ret == LDG_ERR_AOK) { ret = graph_arr_alloc(edge_cap, sizeof(uint32_t), &tmp); g->edge_dst = (uint32_t *)tmp; }
+
+    if (ret == LDG_ERR_AOK) { ret = graph_arr_alloc(edge_cap, sizeof(uint32_t), &tmp); g->succ = (uint32_t *)tmp; }
+
+    if (LDG_UNLIKELY(ret != LDG_ERR_AOK))
+    {
+        ldg_task_graph_destroy(&g);
+        return ret;
+    }
+
+    *out = g;
+
+    return LDG_ERR_AOK;
+}
+
+uint32_t ldg_task_graph_destroy(ldg_task_graph_t **g)
+{
+    if (LDG_UNLIKELY(!g || !*g)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    if (LDG_UNLIKELY(LDG_RD_ONCE((*g)->is_running))) { return LDG_ERR_BUSY; }
+
+    if ((*g)->nodes) { ldg_mem_dealloc((*g)->nodes); }
+    if ((*g)->order) { ldg_mem_dealloc((*g)->order); }
+    if ((*g)->edge_src) { ldg_mem_dealloc((*g)->edge_src); }
+    if ((*g)->edge_dst) { ldg_mem_dealloc((*g)->edge_dst); }
+    if ((*g)->succ) { ldg_mem_dealloc((*g)->succ); }
+
+    ldg_mem_dealloc(*g);
+    *g = 0x0;
+
+    return LDG_ERR_AOK;
+}
+
+uint32_t ldg_task_graph_node_add(ldg_task_graph_t *g, ldg_thread_pool_worker_func_t func, void *arg, uint32_t *id_out)
+{
+    ldg_task_graph_node_t *node = 0x0;
+
+    if (LDG_UNLIKELY(!g || !func || !id_out)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    if (LDG_UNLIKELY(LDG_RD_ONCE(g->is_running))) { return LDG_ERR_BUSY; }
+
+    if (LDG_UNLIKELY(g->node_cunt >= g->node_cap)) { return LDG_ERR_FULL; }
+
+    node = &g->nodes[g->node_cunt];
+
+    if (LDG_UNLIKELY(memset(node, 0, sizeof(ldg_task_graph_node_t)) != node)) { return LDG_ERR_MEM_BAD; }
+
+    node->func = func;
+    node->arg = arg;
+    node->graph = g;
+    node->cp_prev = LDG_TASK_GRAPH_NODE_NONE;
+
+    *id_out = g->node_cunt++;
+    g->is_dirty = 1;
+
+    return LDG_ERR_AOK;
+}
+
+// from runs before to; cycles are only detected by the next run()
+uint32_t ldg_task_graph_edge_add(ldg_task_graph_t *g, uint32_t from, uint32_t to)
+{
+    if (LDG_UNLIKELY(!g)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    if (LDG_UNLIKELY(LDG_RD_ONCE(g->is_running))) { return LDG_ERR_BUSY; }
+
+    if (LDG_UNLIKELY(from >= g->node_cunt || to >= g->node_cunt || from == to)) { return LDG_ERR_FUNC_ARG_INVALID; }
+
+    if (LDG_UNLIKELY(g->edge_cunt >= g->edge_cap)) { return LDG_ERR_FULL; }
+
+    g->edge_src[g->edge_cunt] = from;
+    g->edge_dst[g->edge_cunt] = to;
+    g->edge_cunt++;
+    g->is_dirty = 1;
+
+    return LDG_ERR_AOK;
+}
+
+// edge list -> per-node successor ranges in succ[], plus a topological order; INVALID on a cycle
+static uint32_t graph_freeze(ldg_task_graph_t *g)
+{
+    ldg_task_graph_node_t *node = 0x0;
+    uint32_t i = 0;
+    uint32_t j = 0;
+    uint32_t off = 0;
+    uint32_t hd = 0;
+    uint32_t tail = 0;
+
+    for (i = 0; i < g->node_cunt; i++)
+    {
+        g->nodes[i].succ_cunt = 0;
+        g->nodes[i].dep_cunt = 0;
+    }
+
+    for (i = 0; i < g->edge_cunt; i++)
+    {
+        g->nodes[g->edge_src[i]].succ_cunt++;
+        g->nodes[g->edge_dst[i]].dep_cunt++;
+    }
+
+    for (i = 0; i < g->node_cunt; i++)
+    {
+        g->nodes[i].succ_off = off;
+        g->nodes[i].pending = 0;
+        off += g->nodes[i].succ_cunt;
+    }
+
+    // pending doubles as the fill cursor here and as the in-degree countdown below
+    for (i = 0; i < g->edge_cunt; i++)
+    {
+        node = &g->nodes[g->edge_src[i]];
+        g->succ[node->succ_off + node->pending++] = g->edge_dst[i];
+    }
+
+    for (i = 0; i < g->node_cunt; i++)
+    {
+        g->nodes[i].pending = g->nodes[i].dep_cunt;
+        if (g->nodes[i].dep_cunt == 0) { g->order[tail++] = i; }
+    }
+
+    while (hd < tail)
+    {
+        node = &g->nodes[g->order[hd++]];
+
+        for (j = 0; j < node->succ_cunt; j++)
+        {
+            if (--g->nodes[g->succ[node->succ_off + j]].pending == 0) { g->order[tail++] = g->succ[node->succ_off + j]; }
+        }
+    }
+
+    if (LDG_UNLIKELY(tail != g->node_cunt)) { return LDG_ERR_INVALID; }
+
+    g->is_dirty = 0;
+
+    return LDG_ERR_AOK;
+}
+
+static uint32_t graph_node_task(void *arg)
+{
+    ldg_task_graph_node_t *node = (ldg_task_graph_node_t *)arg;
+    ldg_task_graph_node_t *next = 0x0;
+    ldg_task_graph_node_t *succ = 0x0;
+    ldg_task_graph_t *g = (ldg_task_graph_t *)node->graph;
+    uint32_t expected = 0;
+    uint32_t i = 0;
+
+    while (node)
+    {
+        next = 0x0;
+        node->start_ns = graph_monotonic_ns_get();
+
+        // after a failure the rest of the graph drains without running; skipped nodes report AGAIN
+        if (LDG_LIKELY(LDG_RD_ONCE(g->err) == LDG_ERR_AOK))
+        {
+            node->result = node->func(node->arg);
+
+            expected = LDG_ERR_AOK;
+            if (LDG_UNLIKELY(node->result != LDG_ERR_AOK)) { LDG_CAS(&g->err, &expected, node->result); }
+        }
+        else { node->result = LDG_ERR_AGAIN; }
+
+        node->end_ns = graph_monotonic_ns_get();
+
+        // first ready successor continues on this thread; the rest go to the pool
+        for (i = 0; i < node->succ_cunt; i++)
+        {
+            succ = &g->nodes[g->succ[node->succ_off + i]];
+
+            if (LDG_SUB_FETCH(succ->pending, 1) != 0) { continue; }
+
+            if (!next) { next = succ; }
+            else if (LDG_UNLIKELY(ldg_thread_pool_submit(g->pool, graph_node_task, succ) != LDG_ERR_AOK)) { graph_node_task(succ); }
+        }
+
+        // next is still counted in done_wg, so g stays alive past this point
+        ldg_wg_done(&g->done_wg);
+        node = next;
+    }
+
+    return LDG_ERR_AOK;
+}
+
+// blocks until every node has run or been skipped; returns the first failing node's result
+uint32_t ldg_task_graph_run(ldg_task_graph_t *g)
+{
+    ldg_task_graph_node_t *node = 0x0;
+    uint8_t expected = 0;
+    uint32_t i = 0;
+    uint32_t ret = 0;
+
+    if (LDG_UNLIKELY(!g)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    if (LDG_UNLIKELY(!LDG_CAS(&g->is_running, &expected, 1))) { return LDG_ERR_BUSY; }
+
+    if (g->is_dirty)
+    {
+        ret = graph_freeze(g);
+        if (LDG_UNLIKELY(ret != LDG_ERR_AOK)) { LDG_STORE_RELEASE(g->is_running, 0); return ret; }
+    }
+
+    for (i = 0; i < g->node_cunt; i++)
+    {
+        node = &g->nodes[i];
+        node->pending = node->dep_cunt;
+        node->result = LDG_ERR_AOK;
+        node->start_ns = 0;
+        node->end_ns = 0;
+    }
+
+    g->err = LDG_ERR_AOK;
+    ldg_wg_init(&g->done_wg, g->node_cunt);
+
+    g->run_start_ns = graph_monotonic_ns_get();
+
+    // roots lead the topological order
+    for (i = 0; i < g->node_cunt && g->nodes[g->order[i]].dep_cunt == 0; i++)
+    {
+        node = &g->nodes[g->order[i]];
+
+        if (LDG_UNLIKELY(ldg_thread_pool_submit(g->pool, graph_node_task, node) != LDG_ERR_AOK)) { graph_node_task(node); }
+    }
+
+    ret = ldg_thread_pool_wg_wait(g->pool, &g->done_wg, UINT64_MAX);
+
+    g->run_end_ns = graph_monotonic_ns_get();
+
+    if (LDG_LIKELY(ret == LDG_ERR_AOK)) { ret = LDG_RD_ONCE(g->err); }
+
+    LDG_STORE_RELEASE(g->is_running, 0);
+
+    return ret;
+}
+
+uint32_t ldg_task_graph_node_result_get(const ldg_task_graph_t *g, uint32_t id, uint32_t *result)
+{
+    if (LDG_UNLIKELY(!g || !result)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    if (LDG_UNLIKELY(id >= g->node_cunt)) { return LDG_ERR_FUNC_ARG_INVALID; }
+
+    if (LDG_UNLIKELY(LDG_LOAD_ACQUIRE(g->is_running))) { return LDG_ERR_BUSY; }
+
+    *result = g->nodes[id].result;
+
+    return LDG_ERR_AOK;
+}
+
+// offsets from the start of the last run
+uint32_t ldg_task_graph_node_time_get(const ldg_task_graph_t *g, uint32_t id, uint64_t *start_ns, uint64_t *end_ns)
+{
+    const ldg_task_graph_node_t *node = 0x0;
+
+    if (LDG_UNLIKELY(!g || !start_ns || !end_ns)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    if (LDG_UNLIKELY(id >= g->node_cunt)) { return LDG_ERR_FUNC_ARG_INVALID; }
+
+    if (LDG_UNLIKELY(LDG_LOAD_ACQUIRE(g->is_running))) { return LDG_ERR_BUSY; }
+
+    node = &g->nodes[id];
+
+    if (LDG_UNLIKELY(node->end_ns == 0)) { return LDG_ERR_NOT_FOUND; }
+
+    *start_ns = node->start_ns - g->run_start_ns;
+    *end_ns = node->end_ns - g->run_start_ns;
+
+    return LDG_ERR_AOK;
+}
+
+// longest chain of measured node durations from the last run; FULL with *cunt set when path is too small
+uint32_t ldg_task_graph_critical_path_get(ldg_task_graph_t *g, uint32_t *path, uint32_t cap, uint32_t *cunt, uint64_t *len_ns)
+{
+    ldg_task_graph_node_t *node = 0x0;
+    ldg_task_graph_node_t *succ = 0x0;
+    uint32_t i = 0;
+    uint32_t j = 0;
+    uint32_t tail = LDG_TASK_GRAPH_NODE_NONE;
+    uint32_t n = 0;
+
+    if (LDG_UNLIKELY(!g || !cunt || !len_ns)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    *cunt = 0;
+    *len_ns = 0;
+
+    if (LDG_UNLIKELY(LDG_LOAD_ACQUIRE(g->is_running))) { return LDG_ERR_BUSY; }
+
+    if (LDG_UNLIKELY(g->is_dirty || g->node_cunt == 0 || g->nodes[g->order[0]].end_ns == 0)) { return LDG_ERR_NOT_FOUND; }
+
+    for (i = 0; i < g->node_cunt; i++)
+    {
+        g->nodes[i].cp_len_ns = 0;
+        g->nodes[i].cp_prev = LDG_TASK_GRAPH_NODE_NONE;
+    }
+
+    // cp_len_ns holds the longest predecessor chain until the node itself is visited
+    for (i = 0; i < g->node_cunt; i++)
+    {
+        node = &g->nodes[g->order[i]];
+        node->cp_len_ns += node->end_ns - node->start_ns;
+
+        if (tail == LDG_TASK_GRAPH_NODE_NONE || node->cp_len_ns > g->nodes[tail].cp_len_ns) { tail = g->order[i]; }
+
+        for (j = 0; j < node->succ_cunt; j++)
+        {
+            succ = &g->nodes[g->succ[node->succ_off + j]];
+
+            if (node->cp_len_ns > succ->cp_len_ns)
+            {
+                succ->cp_len_ns = node->cp_len_ns;
+                succ->cp_prev = g->order[i];
+            }
+        }
+    }
+
+    *len_ns = g->nodes[tail].cp_len_ns;
+
+    for (i = tail; i != LDG_TASK_GRAPH_NODE_NONE; i = g->nodes[i].cp_prev) { n++; }
+
+    *cunt = n;
+
+    if (n > cap || !path) { return LDG_ERR_FULL; }
+
+    for (i = tail; i != LDG_TASK_GRAPH_NODE_NONE; i = g->nodes[i].cp_prev) { path[--n] = i; }
+
+    return LDG_ERR_AOK;
+}
@@ -0,0 +1,416 @@
+#include <string.h>
+
+#include <dangling/thread/hmap.h>
+#include <dangling/thread/reclaim.h>
+#include <dangling/core/err.h>
+#include <dangling/mem/alloc.h>
+#include <dangling/core/macros.h>
+#include <dangling/arch/amd64/atomic.h>
+
+#define HMAP_MARK ((uintptr_t)1)
+#define HMAP_PTR(x) ((ldg_hmap_node_t *)((x) & ~HMAP_MARK))
+#define HMAP_SIZE_MAX ((uint64_t)LDG_HMAP_SEG0_SIZE << (LDG_HMAP_SEG_MAX - 1))
+
+// splitmix64 finalizer; a bijection, so distinct keys never share a hash
+static uint64_t hmap_hash(uint64_t key)
+{
+    key ^= key >> 30;
+    key *= 0xBF58476D1CE4E5B9ULL;
+    key ^= key >> 27;
+    key *= 0x94D049BB133111EBULL;
+    key ^= key >> 31;
+
+    return key;
+}
+
+static uint64_t hmap_reverse(uint64_t x)
+{
+    x = __builtin_bswap64(x);
+    x = ((x >> 4) & 0x0F0F0F0F0F0F0F0FULL) | ((x & 0x0F0F0F0F0F0F0F0FULL) << 4);
+    x = ((x >> 2) & 0x3333333333333333ULL) | ((x & 0x3333333333333333ULL) << 2);
+    x = ((x >> 1) & 0x5555555555555555ULL) | ((x & 0x5555555555555555ULL) << 1);
+
+    return x;
+}
+
+// regular keys are odd and bucket dummies even, so a bucket's dummy sorts ahead of everything hashed to it
+static uint64_t hmap_so_regular(uint64_t h)
+{
+    return hmap_reverse(h) | 1;
+}
+
+static uint64_t hmap_so_dummy(uint64_t b)
+{
+    return hmap_reverse(b);
+}
+
+// a bucket's parent is itself with the top bit cleared; its items are split out of the parent's run
+static uint64_t hmap_parent(uint64_t b)
+{
+    return b & ~((uint64_t)1 << (63 - __builtin_clzll(b)));
+}
+
+static ldg_hmap_node_t **hmap_slot_get(ldg_hmap_t *m, uint64_t b)
+{
+    ldg_hmap_node_t **seg = 0x0;
+    void *tmp = 0x0;
+    uint64_t seg_size = LDG_HMAP_SEG0_SIZE;
+    uint64_t off = b;
+    uint32_t s = 0;
+    uint32_t hb = 0;
+
+    if (b >= LDG_HMAP_SEG0_SIZE)
+    {
+        hb = (uint32_t)(63 - __builtin_clzll(b));
+        s = hb - (uint32_t)__builtin_ctzll(LDG_HMAP_SEG0_SIZE) + 1;
+        seg_size = (uint64_t)1 << hb;
+        off = b - seg_size;
+    }
+
+    seg = LDG_LOAD_ACQUIRE(m->segs[s]);
+    if (seg) { return &seg[off]; }
+
+    if (LDG_UNLIKELY(ldg_mem_alloc(seg_size * sizeof(ldg_hmap_node_t *), &tmp) != LDG_ERR_AOK)) { return 0x0; }
+    memset(tmp, 0, seg_size * sizeof(ldg_hmap_node_t *));
+
+    if (!LDG_CAS(&m->segs[s], &seg, (ldg_hmap_node_t **)tmp)) { ldg_mem_dealloc(tmp); }
+    else { seg = (ldg_hmap_node_t **)tmp; }
+
+    return &seg[off];
+}
+
+// walks from hd to the first node at or past (so_key, key), unlinking and retiring marked nodes on the way
+static uint32_t hmap_find(ldg_ebr_thread_t *t, ldg_hmap_node_t *hd, uint64_t so_key, uint64_t key, uintptr_t **prev_out, ldg_hmap_node_t **cur_out)
+{
+    uintptr_t *prev = 0x0;
+    ldg_hmap_node_t *cur = 0x0;
+    uintptr_t next = 0;
+    uintptr_t exp = 0;
+
+retry:
+    prev = &hd->next;
+    cur = HMAP_PTR(LDG_LOAD_ACQUIRE(*prev));
+
+    for (;;)
+    {
+        if (!cur) { break; }
+
+        next = LDG_LOAD_ACQUIRE(cur->next);
+
+        if (next & HMAP_MARK)
+        {
+            exp = (uintptr_t)cur;
+            if (!LDG_CAS(prev, &exp, next & ~HMAP_MARK)) { goto retry; }
+
+            ldg_ebr_retire(t, &cur->rn, cur, ldg_ebr_node_recycle);
+            cur = HMAP_PTR(next);
+            continue;
+        }
+
+        if (cur->so_key > so_key || (cur->so_key == so_key && cur->key >= key)) { break; }
+
+        prev = &cur->next;
+        cur = HMAP_PTR(next);
+    }
+
+    *prev_out = prev;
+    *cur_out = cur;
+
+    return cur && cur->so_key == so_key && cur->key == key;
+}
+
+static ldg_hmap_node_t *hmap_bucket_get(ldg_hmap_t *m, ldg_ebr_thread_t *t, uint64_t b)
+{
+    ldg_hmap_node_t **slot = 0x0;
+    ldg_hmap_node_t *parent = 0x0;
+    ldg_hmap_node_t *dummy = 0x0;
+    ldg_hmap_node_t *cur = 0x0;
+    ldg_hmap_node_t *exp = 0x0;
+    uintptr_t *prev = 0x0;
+    uintptr_t link = 0;
+    void *tmp = 0x0;
+
+    slot = hmap_slot_get(m, b);
+    if (LDG_UNLIKELY(!slot)) { return 0x0; }
+
+    dummy = LDG_LOAD_ACQUIRE(*slot);
+    if (dummy) { return dummy; }
+
+    // bucket 0 is made at create, so the recursion ends there; depth is at most log2 of the bucket cunt
+    parent = hmap_bucket_get(m, t, hmap_parent(b));
+    if (LDG_UNLIKELY(!parent)) { return 0x0; }
+
+    if (LDG_UNLIKELY(ldg_mem_alloc((uint64_t)sizeof(ldg_hmap_node_t), &tmp) != LDG_ERR_AOK)) { return 0x0; }
+
+    dummy = (ldg_hmap_node_t *)tmp;
+    memset(dummy, 0, sizeof(ldg_hmap_node_t));
+    dummy->so_key = hmap_so_dummy(b);
+
+    for (;;)
+    {
+        if (hmap_find(t, parent, dummy->so_key, 0, &prev, &cur))
+        {
+            // another thread split it first; ours was never published
+            ldg_mem_dealloc(dummy);
+            dummy = cur;
+            break;
+        }
+
+        dummy->next = (uintptr_t)cur;
+        link = (uintptr_t)cur;
+        if (LDG_CAS(prev, &link, (uintptr_t)dummy)) { break; }
+    }
+
+    // dummies are never removed, so a lost race here leaves the same node in the slot
+    exp = 0x0;
+    LDG_CAS(slot, &exp, dummy);
+
+    return dummy;
+}
+
+static ldg_hmap_node_t *hmap_hd_get(ldg_hmap_t *m, ldg_ebr_thread_t *t, uint64_t h)
+{
+    return hmap_bucket_get(m, t, h & (LDG_LOAD_ACQUIRE(m->size) - 1));
+}
+
+// each insert may double the bucket cunt; the new buckets split off lazily as keys land in them
+static void hmap_grow(ldg_hmap_t *m, uint64_t cunt)
+{
+    uint64_t size = LDG_LOAD_ACQUIRE(m->size);
+
+    if (cunt <= size * LDG_HMAP_LOAD_FACTOR || size >= HMAP_SIZE_MAX) { return; }
+
+    LDG_CAS(&m->size, &size, size << 1);
+}
+
+uint32_t ldg_hmap_create(ldg_ebr_t *ebr, uint64_t cap, ldg_hmap_t **out)
+{
+    ldg_hmap_t *m = 0x0;
+    ldg_hmap_node_t **slot = 0x0;
+    void *tmp = 0x0;
+    uint64_t size = LDG_HMAP_SEG0_SIZE;
+    uint32_t ret = 0;
+
+    if (LDG_UNLIKELY(!ebr || !out)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    *out = 0x0;
+
+    while (size * LDG_HMAP_LOAD_FACTOR < cap && size < HMAP_SIZE_MAX) { size <<= 1; }
+
+    ret = ldg_mem_alloc((uint64_t)sizeof(ldg_hmap_t), &tmp);
+    if (LDG_UNLIKELY(ret != LDG_ERR_AOK)) { return ret; }
+
+    m = (ldg_hmap_t *)tmp;
+
+    if (LDG_UNLIKELY(memset(m, 0, sizeof(ldg_hmap_t)) != m)) { ldg_mem_dealloc(m); return LDG_ERR_MEM_BAD; }
+
+    m->ebr = ebr;
+    m->size = size;
+
+    slot = hmap_slot_get(m, 0);
+    if (LDG_UNLIKELY(!slot)) { ldg_mem_dealloc(m); return LDG_ERR_ALLOC_NULL; }
+
+    ret = ldg_mem_alloc((uint64_t)sizeof(ldg_hmap_node_t), &tmp);
+    if (LDG_UNLIKELY(ret != LDG_ERR_AOK)) { ldg_mem_dealloc(m->segs[0]); ldg_mem_dealloc(m); return ret; }
+
+    memset(tmp, 0, sizeof(ldg_hmap_node_t));
+    *slot = (ldg_hmap_node_t *)tmp;
+
+    *out = m;
+
+    return LDG_ERR_AOK;
+}
+
+// no thread may be using the map; nodes already removed belong to the ebr domain and go with it
+uint32_t ldg_hmap_destroy(ldg_hmap_t **m)
+{
+    ldg_hmap_node_t *n = 0x0;
+    ldg_hmap_node_t *next = 0x0;
+    uint32_t s = 0;
+
+    if (LDG_UNLIKELY(!m || !*m)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    for (n = (*m)->segs[0][0]; n; n = next)
+    {
+        next = HMAP_PTR(n->next);
+        ldg_mem_dealloc(n);
+    }
+
+    for (s = 0; s < LDG_HMAP_SEG_MAX; s++)
+    {
+        if ((*m)->segs[s]) { ldg_mem_dealloc((*m)->segs[s]); }
+    }
+
+    ldg_mem_dealloc(*m);
+    *m = 0x0;
+
+    return LDG_ERR_AOK;
+}
+
+uint32_t ldg_hmap_get(ldg_hmap_t *m, ldg_ebr_thread_t *t, uint64_t key, uint64_t *val_out)
+{
+    ldg_hmap_node_t *hd = 0x0;
+    ldg_hmap_node_t *cur = 0x0;
+    uintptr_t *prev = 0x0;
+    uint64_t h = 0;
+    uint32_t ret = LDG_ERR_NOT_FOUND;
+
+    if (LDG_UNLIKELY(!m || !t || !val_out)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    if (LDG_UNLIKELY(t->ebr != m->ebr)) { return LDG_ERR_FUNC_ARG_INVALID; }
+
+    h = hmap_hash(key);
+
+    ldg_ebr_enter(t);
+
+    hd = hmap_hd_get(m, t, h);
+    if (LDG_UNLIKELY(!hd)) { ret = LDG_ERR_ALLOC_NULL; }
+    else if (hmap_find(t, hd, hmap_so_regular(h), key, &prev, &cur))
+    {
+        *val_out = LDG_LOAD_ACQUIRE(cur->val);
+        ret = LDG_ERR_AOK;
+    }
+
+    ldg_ebr_exit(t);
+
+    return ret;
+}
+
+static uint32_t hmap_upsert(ldg_hmap_t *m, ldg_ebr_thread_t *t, uint64_t key, uint64_t val, uint32_t is_replace)
+{
+    ldg_hmap_node_t *hd = 0x0;
+    ldg_hmap_node_t *cur = 0x0;
+    ldg_hmap_node_t *n = 0x0;
+    uintptr_t *prev = 0x0;
+    uintptr_t link = 0;
+    void *tmp = 0x0;
+    uint64_t h = 0;
+    uint64_t so_key = 0;
+    uint32_t ret = 0;
+
+    if (LDG_UNLIKELY(!m || !t)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    if (LDG_UNLIKELY(t->ebr != m->ebr)) { return LDG_ERR_FUNC_ARG_INVALID; }
+
+    h = hmap_hash(key);
+    so_key = hmap_so_regular(h);
+
+    ldg_ebr_enter(t);
+
+    hd = hmap_hd_get(m, t, h);
+    if (LDG_UNLIKELY(!hd)) { ldg_ebr_exit(t); return LDG_ERR_ALLOC_NULL; }
+
+    for (;;)
+    {
+        if (hmap_find(t, hd, so_key, key, &prev, &cur))
+        {
+            // a racing remove may unlink cur right after; the put then simply ordered before it
+            if (is_replace) { LDG_XCHG(cur->val, val); }
+
+            ret = is_replace ? LDG_ERR_AOK : LDG_ERR_EXISTS;
+            break;
+        }
+
+        if (!n)
+        {
+            // off the calling record's cache, so the global allocator and its lock stay off the write path
+            ret = ldg_ebr_node_get(t, (uint64_t)sizeof(ldg_hmap_node_t), &tmp);
+            if (LDG_UNLIKELY(ret != LDG_ERR_AOK)) { break; }
+
+            n = (ldg_hmap_node_t *)tmp;
+            memset(n, 0, sizeof(ldg_hmap_node_t));
+            n->so_key = so_key;
+            n->key = key;
+            n->val = val;
+        }
+
+        n->next = (uintptr_t)cur;
+        link = (uintptr_t)cur;
+        if (LDG_CAS(prev, &link, (uintptr_t)n))
+        {
+            hmap_grow(m, LDG_ADD_FETCH(m->cunt, 1));
+            n = 0x0;
+            ret = LDG_ERR_AOK;
+            break;
+        }
+    }
+
+    // never published, but the retire hands it back to this record's cache for the next insert
+    if (n) { ldg_ebr_retire(t, &n->rn, n, ldg_ebr_node_recycle); }
+
+    ldg_ebr_exit(t);
+
+    return ret;
+}
+
+uint32_t ldg_hmap_insert(ldg_hmap_t *m, ldg_ebr_thread_t *t, uint64_t key, uint64_t val)
+{
+    return hmap_upsert(m, t, key, val, 0);
+}
+
+uint32_t ldg_hmap_put(ldg_hmap_t *m, ldg_ebr_thread_t *t, uint64_t key, uint64_t val)
+{
+    return hmap_upsert(m, t, key, val, 1);
+}
+
+uint32_t ldg_hmap_remove(ldg_hmap_t *m, ldg_ebr_thread_t *t, uint64_t key, uint64_t *val_out)
+{
+    ldg_hmap_node_t *hd = 0x0;
+    ldg_hmap_node_t *cur = 0x0;
+    uintptr_t *prev = 0x0;
+    uintptr_t next = 0;
+    uintptr_t exp = 0;
+    uint64_t h = 0;
+    uint64_t so_key = 0;
+    uint32_t ret = LDG_ERR_NOT_FOUND;
+
+    if (LDG_UNLIKELY(!m || !t)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    if (LDG_UNLIKELY(t->ebr != m->ebr)) { return LDG_ERR_FUNC_ARG_INVALID; }
+
+    h = hmap_hash(key);
+    so_key = hmap_so_regular(h);
+
+    ldg_ebr_enter(t);
+
+    hd = hmap_hd_get(m, t, h);
+    if (LDG_UNLIKELY(!hd)) { ldg_ebr_exit(t); return LDG_ERR_ALLOC_NULL; }
+
+    while (hmap_find(t, hd, so_key, key, &prev, &cur))
+    {
+        next = LDG_LOAD_ACQUIRE(cur->next);
+        if (next & HMAP_MARK) { continue; }
+
+        // the mark is the linearization point; whoever sets it owns the removal
+        if (!LDG_CAS(&cur->next, &next, next | HMAP_MARK)) { continue; }
+
+        if (val_out) { *val_out = LDG_LOAD_ACQUIRE(cur->val); }
+
+        LDG_SUB_FETCH(m->cunt, 1);
+
+        exp = (uintptr_t)cur;
+        if (LDG_CAS(prev, &exp, next)) { ldg_ebr_retire(t, &cur->rn, cur, ldg_ebr_node_recycle); }
+        else { hmap_find(t, hd, so_key, key, &prev, &cur); }
+
+        ret = LDG_ERR_AOK;
+        break;
+    }
+
+    ldg_ebr_exit(t);
+
+    return ret;
+}
+
+uint64_t ldg_hmap_cunt_get(const ldg_hmap_t *m)
+{
+    if (LDG_UNLIKELY(!m)) { return UINT64_MAX; }
+
+    return LDG_LOAD_ACQUIRE(m->cunt);
+}
+
+uint64_t ldg_hmap_bucket_cunt_get(const ldg_hmap_t *m)
+{
+    if (LDG_UNLIKELY(!m)) { return UINT64_MAX; }
+
+    return LDG_LOAD_ACQUIRE(m->size);
+}
@@ -0,0 +1,149 @@
+#include <string.h>
+#include <windows.h>
+
+#include <dangling/thread/pcnt.h>
+#include <dangling/sys/info.h>
+#include <dangling/core/err.h>
+#include <dangling/mem/alloc.h>
+#include <dangling/core/macros.h>
+#include <dangling/core/arith.h>
+#include <dangling/arch/amd64/atomic.h>
+#include <dangling/arch/amd64/fence.h>
+
+// 1-based id handing out thread rows round robin; 0 until the thread first needs one
+static uint32_t pcnt_thread_next = 0;
+static __thread uint32_t pcnt_thread_id = 0;
+
+static uint32_t pcnt_thread_row_get(const ldg_pcnt_t *p)
+{
+    while (LDG_UNLIKELY(pcnt_thread_id == 0)) { pcnt_thread_id = LDG_ADD_FETCH(pcnt_thread_next, 1); }
+
+    return p->cpu_row_cunt + (pcnt_thread_id - 1) % p->thread_row_cunt;
+}
+
+// no rseq here, so there are no cpu rows and every add goes to a thread row
+uint32_t ldg_pcnt_create(uint32_t cunt, ldg_pcnt_t **out)
+{
+    ldg_pcnt_t *p = 0x0;
+    void *tmp = 0x0;
+    uint32_t cpu_cunt = 0;
+    uint64_t stride = 0;
+    uint64_t rows_size = 0;
+    uint32_t ret = 0;
+
+    if (LDG_UNLIKELY(!out)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    *out = 0x0;
+
+    if (LDG_UNLIKELY(cunt == 0)) { return LDG_ERR_FUNC_ARG_INVALID; }
+
+    ret = ldg_sys_cpu_cunt_get(&cpu_cunt);
+    if (LDG_UNLIKELY(ret != LDG_ERR_AOK)) { return ret; }
+
+    stride = ((uint64_t)cunt * sizeof(uint64_t) + LDG_AMD64_CACHE_LINE_WIDTH - 1) & ~((uint64_t)LDG_AMD64_CACHE_LINE_WIDTH - 1);
+
+    if (LDG_UNLIKELY(ldg_arith_64_mul(stride, (uint64_t)cpu_cunt, &rows_size) != LDG_ERR_AOK)) { return LDG_ERR_OVERFLOW; }
+
+    ret = ldg_mem_alloc((uint64_t)sizeof(ldg_pcnt_t), &tmp);
+    if (LDG_UNLIKELY(ret != LDG_ERR_AOK)) { return ret; }
+
+    p = (ldg_pcnt_t *)tmp;
+
+    if (LDG_UNLIKELY(memset(p, 0, sizeof(ldg_pcnt_t)) != p)) { ldg_mem_dealloc(p); return LDG_ERR_MEM_BAD; }
+
+    ret = ldg_mem_alloc(rows_size, &tmp);
+    if (LDG_UNLIKELY(ret != LDG_ERR_AOK)) { ldg_mem_dealloc(p); return ret; }
+
+    if (LDG_UNLIKELY(memset(tmp, 0, rows_size) != tmp)) { ldg_mem_dealloc(tmp); ldg_mem_dealloc(p); return LDG_ERR_MEM_BAD; }
+
+    p->rows = (uint64_t *)tmp;
+    p->stride = stride / sizeof(uint64_t);
+    p->cunt = cunt;
+    p->cpu_row_cunt = 0;
+    p->thread_row_cunt = cpu_cunt;
+    p->row_cunt = cpu_cunt;
+
+    *out = p;
+
+    return LDG_ERR_AOK;
+}
+
+uint32_t ldg_pcnt_destroy(ldg_pcnt_t **p)
+{
+    if (LDG_UNLIKELY(!p || !*p)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    ldg_mem_dealloc((*p)->rows);
+    ldg_mem_dealloc(*p);
+    *p = 0x0;
+
+    return LDG_ERR_AOK;
+}
+
+uint32_t ldg_pcnt_add(ldg_pcnt_t *p, uint32_t idx, uint64_t val)
+{
+    if (LDG_UNLIKELY(!p)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    if (LDG_UNLIKELY(idx >= p->cunt)) { return LDG_ERR_FUNC_ARG_INVALID; }
+
+    LDG_FETCH_ADD_RELAXED(p->rows[(uint64_t)pcnt_thread_row_get(p) * p->stride + idx], val);
+
+    return LDG_ERR_AOK;
+}
+
+uint32_t ldg_pcnt_sub(ldg_pcnt_t *p, uint32_t idx, uint64_t val)
+{
+    return ldg_pcnt_add(p, idx, (uint64_t)0 - val);
+}
+
+// rows are summed one at a time, so the result is not a snapshot of any single instant
+uint64_t ldg_pcnt_sum_get(const ldg_pcnt_t *p, uint32_t idx)
+{
+    uint64_t sum = 0;
+    uint32_t r = 0;
+
+    if (LDG_UNLIKELY(!p || idx >= p->cunt)) { return UINT64_MAX; }
+
+    for (r = 0; r < p->row_cunt; r++) { sum += LDG_RD_ONCE(p->rows[(uint64_t)r * p->stride + idx]); }
+
+    return sum;
+}
+
+// sums the first cap counters in one pass over the rows
+uint32_t ldg_pcnt_sums_get(const ldg_pcnt_t *p, uint64_t *out, uint32_t cap)
+{
+    const uint64_t *row = 0x0;
+    uint32_t cunt = 0;
+    uint32_t r = 0;
+    uint32_t i = 0;
+
+    if (LDG_UNLIKELY(!p || !out)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    cunt = (cap < p->cunt) ? cap : p->cunt;
+
+    if (LDG_UNLIKELY(memset(out, 0, (uint64_t)cunt * sizeof(uint64_t)) != out)) { return LDG_ERR_MEM_BAD; }
+
+    for (r = 0; r < p->row_cunt; r++)
+    {
+        row = p->rows + (uint64_t)r * p->stride;
+
+        for (i = 0; i < cunt; i++) { out[i] += LDG_RD_ONCE(row[i]); }
+    }
+
+    return LDG_ERR_AOK;
+}
+
+uint32_t ldg_pcnt_rst(ldg_pcnt_t *p)
+{
+    uint64_t i = 0;
+
+    if (LDG_UNLIKELY(!p)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    for (i = 0; i < (uint64_t)p->row_cunt * p->stride; i++) { LDG_WR_ONCE(p->rows[i], 0); }
+
+    return LDG_ERR_AOK;
+}
+
+uint8_t ldg_pcnt_rseq_is(void)
+{
+    return 0;
+}
@@ -0,0 +1,542 @@
+#include <string.h>
+
+#include <dangling/thread/reclaim.h>
+#include <dangling/core/err.h>
+#include <dangling/mem/alloc.h>
+#include <dangling/core/macros.h>
+#include <dangling/arch/amd64/atomic.h>
+#include <dangling/arch/amd64/fence.h>
+
+// node may live inside ptr, so next is read before anything is freed
+static uint64_t reclaim_list_free(ldg_reclaim_node_t *n)
+{
+    ldg_reclaim_node_t *next = 0x0;
+    uint64_t cunt = 0;
+
+    while (n)
+    {
+        next = n->next;
+
+        if (n->func) { n->func(n->ptr); }
+        else { ldg_mem_dealloc(n->ptr); }
+
+        n = next;
+        cunt++;
+    }
+
+    return cunt;
+}
+
+// ebr
+
+void ldg_ebr_node_recycle(void *ptr)
+{
+    ldg_mem_dealloc(ptr);
+}
+
+// as reclaim_list_free, but recycled nodes are kept on t while its cache has room
+static uint64_t ebr_list_free(ldg_ebr_thread_t *t, ldg_reclaim_node_t *n)
+{
+    ldg_reclaim_node_t *next = 0x0;
+    uint64_t cunt = 0;
+
+    while (n)
+    {
+        next = n->next;
+
+        if (n->func == ldg_ebr_node_recycle && t->cache_cunt < LDG_EBR_CACHE_MAX)
+        {
+            n->next = t->cache;
+            t->cache = n;
+            t->cache_cunt++;
+        }
+        else if (n->func) { n->func(n->ptr); }
+        else { ldg_mem_dealloc(n->ptr); }
+
+        n = next;
+        cunt++;
+    }
+
+    return cunt;
+}
+
+// the epoch moves only once every thread inside a critical section has seen the current one
+static uint32_t ebr_advance(ldg_ebr_t *ebr)
+{
+    ldg_ebr_thread_t *r = 0x0;
+    uint64_t e = 0;
+    uint64_t s = 0;
+
+    LDG_SMP_MB();
+
+    e = LDG_LOAD_ACQUIRE(ebr->epoch);
+
+    for (r = LDG_LOAD_ACQUIRE(ebr->threads); r; r = r->next)
+    {
+        s = LDG_LOAD_ACQUIRE(r->state);
+        if ((s & 1) && (s >> 1) != e) { return LDG_ERR_AGAIN; }
+    }
+
+    if (!LDG_CAS(&ebr->epoch, &e, e + 1)) { return LDG_ERR_AGAIN; }
+
+    return LDG_ERR_AOK;
+}
+
+static void ebr_collect(ldg_ebr_thread_t *t)
+{
+    uint64_t e = LDG_LOAD_ACQUIRE(t->ebr->epoch);
+    uint32_t i = 0;
+
+    for (i = 0; i < LDG_EBR_BUCKETS; i++)
+    {
+        if (!t->bucket[i] || t->bucket_epoch[i] + 2 > e) { continue; }
+
+        t->retired_cunt -= ebr_list_free(t, t->bucket[i]);
+        t->bucket[i] = 0x0;
+    }
+}
+
+uint32_t ldg_ebr_create(ldg_ebr_t **out)
+{
+    ldg_ebr_t *ebr = 0x0;
+    void *tmp = 0x0;
+    uint32_t ret = 0;
+
+    if (LDG_UNLIKELY(!out)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    *out = 0x0;
+
+    ret = ldg_mem_alloc((uint64_t)sizeof(ldg_ebr_t), &tmp);
+    if (LDG_UNLIKELY(ret != LDG_ERR_AOK)) { return ret; }
+
+    ebr = (ldg_ebr_t *)tmp;
+
+    if (LDG_UNLIKELY(memset(ebr, 0, sizeof(ldg_ebr_t)) != ebr)) { ldg_mem_dealloc(ebr); return LDG_ERR_MEM_BAD; }
+
+    *out = ebr;
+
+    return LDG_ERR_AOK;
+}
+
+// no thread may be inside a critical section; every retired node is freed regardless of epoch
+uint32_t ldg_ebr_destroy(ldg_ebr_t **ebr)
+{
+    ldg_ebr_thread_t *r = 0x0;
+    ldg_ebr_thread_t *next = 0x0;
+    uint32_t i = 0;
+
+    if (LDG_UNLIKELY(!ebr || !*ebr)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    for (r = (*ebr)->threads; r; r = next)
+    {
+        next = r->next;
+
+        for (i = 0; i < LDG_EBR_BUCKETS; i++) { reclaim_list_free(r->bucket[i]); }
+
+        reclaim_list_free(r->cache);
+
+        ldg_mem_dealloc(r);
+    }
+
+    ldg_mem_dealloc(*ebr);
+    *ebr = 0x0;
+
+    return LDG_ERR_AOK;
+}
+
+uint32_t ldg_ebr_thread_register(ldg_ebr_t *ebr, ldg_ebr_thread_t **out)
+{
+    ldg_ebr_thread_t *r = 0x0;
+    ldg_ebr_thread_t *hd = 0x0;
+    void *tmp = 0x0;
+    uint32_t exp = 0;
+    uint32_t ret = 0;
+
+    if (LDG_UNLIKELY(!ebr || !out)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    *out = 0x0;
+
+    for (r = LDG_LOAD_ACQUIRE(ebr->threads); r; r = r->next)
+    {
+        exp = 0;
+        if (LDG_RD_ONCE(r->is_used) == 0 && LDG_CAS(&r->is_used, &exp, 1))
+        {
+            ebr_collect(r);
+            *out = r;
+            return LDG_ERR_AOK;
+        }
+    }
+
+    ret = ldg_mem_alloc((uint64_t)sizeof(ldg_ebr_thread_t), &tmp);
+    if (LDG_UNLIKELY(ret != LDG_ERR_AOK)) { return ret; }
+
+    r = (ldg_ebr_thread_t *)tmp;
+
+    if (LDG_UNLIKELY(memset(r, 0, sizeof(ldg_ebr_thread_t)) != r)) { ldg_mem_dealloc(r); return LDG_ERR_MEM_BAD; }
+
+    r->ebr = ebr;
+    r->is_used = 1;
+
+    hd = LDG_LOAD_ACQUIRE(ebr->threads);
+    do
+    {
+        r->next = hd;
+    } while (!LDG_CAS(&ebr->threads, &hd, r));
+
+    LDG_FETCH_ADD(ebr->thread_cunt, 1);
+
+    *out = r;
+
+    return LDG_ERR_AOK;
+}
+
+uint32_t ldg_ebr_thread_unregister(ldg_ebr_thread_t **t)
+{
+    if (LDG_UNLIKELY(!t || !*t)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    if (LDG_UNLIKELY((*t)->nest)) { return LDG_ERR_BUSY; }
+
+    ldg_ebr_flush(*t);
+
+    LDG_STORE_RELEASE((*t)->is_used, 0);
+    *t = 0x0;
+
+    return LDG_ERR_AOK;
+}
+
+// nests; only the outermost enter announces the epoch
+uint32_t ldg_ebr_enter(ldg_ebr_thread_t *t)
+{
+    uint64_t e = 0;
+
+    if (LDG_UNLIKELY(!t)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    if (t->nest++) { return LDG_ERR_AOK; }
+
+    e = LDG_LOAD_ACQUIRE(t->ebr->epoch);
+    LDG_WR_ONCE(t->state, (e << 1) | 1);
+
+    // the announcement must be visible before any shared pointer is read
+    LDG_SMP_MB();
+
+    return LDG_ERR_AOK;
+}
+
+uint32_t ldg_ebr_exit(ldg_ebr_thread_t *t)
+{
+    if (LDG_UNLIKELY(!t)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    if (LDG_UNLIKELY(!t->nest)) { return LDG_ERR_INVALID; }
+
+    if (--t->nest) { return LDG_ERR_AOK; }
+
+    LDG_STORE_RELEASE(t->state, 0);
+
+    return LDG_ERR_AOK;
+}
+
+// node must already be unreachable from the structure; it is freed no earlier than two epochs later
+uint32_t ldg_ebr_retire(ldg_ebr_thread_t *t, ldg_reclaim_node_t *node, void *ptr, ldg_reclaim_free_func_t func)
+{
+    uint64_t e = 0;
+    uint32_t i = 0;
+
+    if (LDG_UNLIKELY(!t || !node || !ptr)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    node->ptr = ptr;
+    node->func = func;
+
+    e = LDG_LOAD_ACQUIRE(t->ebr->epoch);
+    i = (uint32_t)(e % LDG_EBR_BUCKETS);
+
+    // a bucket still tagged with an older epoch is at least three epochs stale, so it is free to go
+    if (t->bucket[i] && t->bucket_epoch[i] != e)
+    {
+        t->retired_cunt -= ebr_list_free(t, t->bucket[i]);
+        t->bucket[i] = 0x0;
+    }
+
+    node->next = t->bucket[i];
+    t->bucket[i] = node;
+    t->bucket_epoch[i] = e;
+    t->retired_cunt++;
+
+    if (t->retired_cunt >= LDG_EBR_BATCH)
+    {
+        ebr_advance(t->ebr);
+        ebr_collect(t);
+    }
+
+    return LDG_ERR_AOK;
+}
+
+// frees everything this thread retired once no critical section can still see it; returns again if
+// another thread holds the epoch back
+uint32_t ldg_ebr_flush(ldg_ebr_thread_t *t)
+{
+    uint32_t i = 0;
+
+    if (LDG_UNLIKELY(!t)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    if (LDG_UNLIKELY(t->nest)) { return LDG_ERR_BUSY; }
+
+    for (i = 0; i < LDG_EBR_BUCKETS && t->retired_cunt; i++)
+    {
+        ebr_advance(t->ebr);
+        ebr_collect(t);
+    }
+
+    return t->retired_cunt ? LDG_ERR_AGAIN : LDG_ERR_AOK;
+}
+
+// a node this record recycled if it has one, otherwise a fresh allocation; INVALID if size is not the domain's
+uint32_t ldg_ebr_node_get(ldg_ebr_thread_t *t, uint64_t size, void **out)
+{
+    ldg_reclaim_node_t *n = 0x0;
+    uint64_t exp = 0;
+
+    if (LDG_UNLIKELY(!t || !out)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    if (LDG_UNLIKELY(LDG_RD_ONCE(t->ebr->node_size) != size))
+    {
+        if (LDG_UNLIKELY(size == 0 || (!LDG_CAS(&t->ebr->node_size, &exp, size) && exp != size))) { return LDG_ERR_FUNC_ARG_INVALID; }
+    }
+
+    n = t->cache;
+    if (!n) { return ldg_mem_alloc(size, out); }
+
+    t->cache = n->next;
+    t->cache_cunt--;
+    *out = n->ptr;
+
+    return LDG_ERR_AOK;
+}
+
+uint64_t ldg_ebr_epoch_get(const ldg_ebr_t *ebr)
+{
+    if (LDG_UNLIKELY(!ebr)) { return UINT64_MAX; }
+
+    return LDG_LOAD_ACQUIRE(ebr->epoch);
+}
+
+// hp
+
+static uint32_t hp_is_protected(const ldg_hp_t *hp, const void *ptr)
+{
+    const ldg_hp_rec_t *r = 0x0;
+    uint32_t i = 0;
+
+    for (r = LDG_LOAD_ACQUIRE(hp->recs); r; r = r->next)
+    {
+        for (i = 0; i < LDG_HP_SLOTS; i++)
+        {
+            if (LDG_LOAD_ACQUIRE(r->hp[i]) == ptr) { return 1; }
+        }
+    }
+
+    return 0;
+}
+
+uint32_t ldg_hp_create(ldg_hp_t **out)
+{
+    ldg_hp_t *hp = 0x0;
+    void *tmp = 0x0;
+    uint32_t ret = 0;
+
+    if (LDG_UNLIKELY(!out)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    *out = 0x0;
+
+    ret = ldg_mem_alloc((uint64_t)sizeof(ldg_hp_t), &tmp);
+    if (LDG_UNLIKELY(ret != LDG_ERR_AOK)) { return ret; }
+
+    hp = (ldg_hp_t *)tmp;
+
+    if (LDG_UNLIKELY(memset(hp, 0, sizeof(ldg_hp_t)) != hp)) { ldg_mem_dealloc(hp); return LDG_ERR_MEM_BAD; }
+
+    *out = hp;
+
+    return LDG_ERR_AOK;
+}
+
+// no record may still publish a pointer; every retired node is freed
+uint32_t ldg_hp_destroy(ldg_hp_t **hp)
+{
+    ldg_hp_rec_t *r = 0x0;
+    ldg_hp_rec_t *next = 0x0;
+
+    if (LDG_UNLIKELY(!hp || !*hp)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    for (r = (*hp)->recs; r; r = next)
+    {
+        next = r->next;
+        reclaim_list_free(r->retired);
+        ldg_mem_dealloc(r);
+    }
+
+    ldg_mem_dealloc(*hp);
+    *hp = 0x0;
+
+    return LDG_ERR_AOK;
+}
+
+uint32_t ldg_hp_rec_acquire(ldg_hp_t *hp, ldg_hp_rec_t **out)
+{
+    ldg_hp_rec_t *r = 0x0;
+    ldg_hp_rec_t *hd = 0x0;
+    void *tmp = 0x0;
+    uint32_t exp = 0;
+    uint32_t ret = 0;
+
+    if (LDG_UNLIKELY(!hp || !out)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    *out = 0x0;
+
+    for (r = LDG_LOAD_ACQUIRE(hp->recs); r; r = r->next)
+    {
+        exp = 0;
+        if (LDG_RD_ONCE(r->is_used) == 0 && LDG_CAS(&r->is_used, &exp, 1))
+        {
+            *out = r;
+            return LDG_ERR_AOK;
+        }
+    }
+
+    ret = ldg_mem_alloc((uint64_t)sizeof(ldg_hp_rec_t), &tmp);
+    if (LDG_UNLIKELY(ret != LDG_ERR_AOK)) { return ret; }
+
+    r = (ldg_hp_rec_t *)tmp;
+
+    if (LDG_UNLIKELY(memset(r, 0, sizeof(ldg_hp_rec_t)) != r)) { ldg_mem_dealloc(r); return LDG_ERR_MEM_BAD; }
+
+    r->dom = hp;
+    r->is_used = 1;
+
+    hd = LDG_LOAD_ACQUIRE(hp->recs);
+    do
+    {
+        r->next = hd;
+    } while (!LDG_CAS(&hp->recs, &hd, r));
+
+    LDG_FETCH_ADD(hp->rec_cunt, 1);
+
+    *out = r;
+
+    return LDG_ERR_AOK;
+}
+
+// clears every slot; nodes still protected elsewhere stay on the record for its next owner
+uint32_t ldg_hp_rec_release(ldg_hp_rec_t **rec)
+{
+    uint32_t i = 0;
+
+    if (LDG_UNLIKELY(!rec || !*rec)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    for (i = 0; i < LDG_HP_SLOTS; i++) { LDG_STORE_RELEASE((*rec)->hp[i], 0x0); }
+
+    ldg_hp_scan(*rec);
+
+    LDG_STORE_RELEASE((*rec)->is_used, 0);
+    *rec = 0x0;
+
+    return LDG_ERR_AOK;
+}
+
+// publishes *src in slot and re-reads it until the two agree, so the pointer in out cannot be freed
+// before the slot is cleared or reused
+uint32_t ldg_hp_protect(ldg_hp_rec_t *rec, uint32_t slot, void *const *src, void **out)
+{
+    void *p = 0x0;
+    void *q = 0x0;
+
+    if (LDG_UNLIKELY(!rec || !src || !out)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    if (LDG_UNLIKELY(slot >= LDG_HP_SLOTS)) { return LDG_ERR_FUNC_ARG_INVALID; }
+
+    p = LDG_LOAD_ACQUIRE(*src);
+
+    for (;;)
+    {
+        LDG_WR_ONCE(rec->hp[slot], p);
+
+        // store-load: the slot must be visible before src is read again
+        LDG_SMP_MB();
+
+        q = LDG_LOAD_ACQUIRE(*src);
+        if (q == p) { break; }
+
+        p = q;
+    }
+
+    *out = p;
+
+    return LDG_ERR_AOK;
+}
+
+uint32_t ldg_hp_clear(ldg_hp_rec_t *rec, uint32_t slot)
+{
+    if (LDG_UNLIKELY(!rec)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    if (LDG_UNLIKELY(slot >= LDG_HP_SLOTS)) { return LDG_ERR_FUNC_ARG_INVALID; }
+
+    LDG_STORE_RELEASE(rec->hp[slot], 0x0);
+
+    return LDG_ERR_AOK;
+}
+
+// node must already be unreachable from the structure
+uint32_t ldg_hp_retire(ldg_hp_rec_t *rec, ldg_reclaim_node_t *node, void *ptr, ldg_reclaim_free_func_t func)
+{
+    if (LDG_UNLIKELY(!rec || !node || !ptr)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    node->ptr = ptr;
+    node->func = func;
+    node->next = rec->retired;
+    rec->retired = node;
+    rec->retired_cunt++;
+
+    if (rec->retired_cunt >= LDG_HP_SCAN_MIN + LDG_HP_SLOTS * LDG_RD_ONCE(rec->dom->rec_cunt)) { ldg_hp_scan(rec); }
+
+    return LDG_ERR_AOK;
+}
+
+// frees every retired node no record publishes; returns again if some are still protected
+uint32_t ldg_hp_scan(ldg_hp_rec_t *rec)
+{
+    ldg_reclaim_node_t *n = 0x0;
+    ldg_reclaim_node_t *next = 0x0;
+    ldg_reclaim_node_t *keep = 0x0;
+    uint64_t kept = 0;
+
+    if (LDG_UNLIKELY(!rec)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    // the unlinks that preceded retire must be visible before any slot is read
+    LDG_SMP_MB();
+
+    n = rec->retired;
+    rec->retired = 0x0;
+
+    while (n)
+    {
+        next = n->next;
+
+        if (hp_is_protected(rec->dom, n->ptr))
+        {
+            n->next = keep;
+            keep = n;
+            kept++;
+        }
+        else
+        {
+            n->next = 0x0;
+            reclaim_list_free(n);
+        }
+
+        n = next;
+    }
+
+    rec->retired = keep;
+    rec->retired_cunt = kept;
+
+    return kept ? LDG_ERR_AGAIN : LDG_ERR_AOK;
+}
@@ -0,0 +1,443 @@
+#include <string.h>
+#include <windows.h>
+
+#include <dangling/thread/shmq.h>
+#include <dangling/thread/mpmc.h>
+#include <dangling/thread/sync.h>
+#include <dangling/core/err.h>
+#include <dangling/mem/secure.h>
+#include <dangling/core/macros.h>
+#include <dangling/arch/amd64/atomic.h>
+#include <dangling/arch/amd64/fence.h>
+
+// claim attempts before an mpmc push / pop gives up with AGAIN
+#define SHMQ_MAX_SPIN 1024
+// WaitOnAddress does not cross processes, so a parked peer polls: this many yields, then 1 ms sleeps
+#define SHMQ_PARK_YIELD_CUNT 64
+
+static uint64_t shmq_monotonic_ns_get(void)
+{
+    LARGE_INTEGER freq = { 0 };
+    LARGE_INTEGER ctr = { 0 };
+
+    if (LDG_UNLIKELY(!QueryPerformanceFrequency(&freq) || !QueryPerformanceCounter(&ctr))) { return UINT64_MAX; }
+
+    // split so the multiply cannot overflow at high counter frequencies
+    return (uint64_t)(ctr.QuadPart / freq.QuadPart) * LDG_NS_PER_SEC + (uint64_t)(ctr.QuadPart % freq.QuadPart) * LDG_NS_PER_SEC / (uint64_t)freq.QuadPart;
+}
+
+static uint8_t shmq_cap_pow2_is(uint64_t cap)
+{
+    return (cap > 0) && ((cap & (cap - 1)) == 0);
+}
+
+static uint32_t shmq_name_copy(ldg_shmq_t *q, const char *name)
+{
+    uint64_t name_len = strlen(name);
+
+    if (LDG_UNLIKELY(name_len == 0 || name_len >= LDG_SHMQ_NAME_MAX)) { return LDG_ERR_FUNC_ARG_INVALID; }
+
+    if (LDG_UNLIKELY(ldg_mem_secure_copy(q->name, name, name_len) != LDG_ERR_AOK)) { return LDG_ERR_MEM_BAD; }
+
+    q->name[name_len] = LDG_STR_TERM;
+
+    return LDG_ERR_AOK;
+}
+
+// spsc slots are bare items; mpmc slots carry the ldg_mpmc_slot_t sequence word on its own line
+static uint32_t shmq_layout_get(uint32_t kind, uint64_t item_size, uint64_t cap, uint64_t *slot_size, uint64_t *seg_size)
+{
+    uint64_t slot = 0;
+
+    if (kind == LDG_SHMQ_SPSC)
+    {
+        if (LDG_UNLIKELY(item_size > UINT64_MAX - 7)) { return LDG_ERR_OVERFLOW; }
+        slot = (item_size + 7) & ~(uint64_t)7;
+    }
+    else
+    {
+        if (LDG_UNLIKELY(item_size > UINT64_MAX - 2 * LDG_AMD64_CACHE_LINE_WIDTH)) { return LDG_ERR_OVERFLOW; }
+        slot = LDG_ALIGNED_UP(sizeof(ldg_mpmc_slot_t) + item_size);
+    }
+
+    if (LDG_UNLIKELY(slot > (UINT64_MAX - sizeof(ldg_shmq_hdr_t)) / cap)) { return LDG_ERR_OVERFLOW; }
+
+    *slot_size = slot;
+    *seg_size = sizeof(ldg_shmq_hdr_t) + slot * cap;
+
+    return LDG_ERR_AOK;
+}
+
+// everything in the header may have been written by another process, and may be rewritten after we check it:
+// copy the geometry into the handle once and validate that copy, so push / pop never take an offset from the segment
+static uint32_t shmq_hdr_load(ldg_shmq_t *q, const ldg_shmq_hdr_t *hdr, uint64_t map_size)
+{
+    uint64_t slot_size = 0;
+    uint64_t seg_size = 0;
+
+    if (LDG_LOAD_ACQUIRE(hdr->magic) != LDG_SHMQ_MAGIC) { return LDG_ERR_AGAIN; }
+
+    if (LDG_UNLIKELY(LDG_RD_ONCE(hdr->version) != LDG_SHMQ_VERSION)) { return LDG_ERR_UNSUPPORTED; }
+
+    q->kind = LDG_RD_ONCE(hdr->kind);
+    q->item_size = LDG_RD_ONCE(hdr->item_size);
+    q->slot_size = LDG_RD_ONCE(hdr->slot_size);
+    q->cap = LDG_RD_ONCE(hdr->cap);
+    q->mask = LDG_RD_ONCE(hdr->mask);
+
+    if (LDG_UNLIKELY(q->kind > LDG_SHMQ_MPMC || q->item_size == 0 || !shmq_cap_pow2_is(q->cap) || q->mask != q->cap - 1)) { return LDG_ERR_INVALID; }
+
+    if (LDG_UNLIKELY(shmq_layout_get(q->kind, q->item_size, q->cap, &slot_size, &seg_size) != LDG_ERR_AOK)) { return LDG_ERR_INVALID; }
+
+    if (LDG_UNLIKELY(q->slot_size != slot_size || LDG_RD_ONCE(hdr->seg_size) != seg_size || LDG_RD_ONCE(hdr->data_off) != sizeof(ldg_shmq_hdr_t) || seg_size > map_size)) { return LDG_ERR_INVALID; }
+
+    return LDG_ERR_AOK;
+}
+
+static uint8_t* shmq_slot_get(const ldg_shmq_t *q, uint64_t pos)
+{
+    return q->data + (pos & q->mask) * q->slot_size;
+}
+
+// the seq bump is what a polling peer compares against; skipped while nobody is parked
+static void shmq_notify(uint32_t *seq, uint32_t *waiters)
+{
+    LDG_SMP_MB();
+    if (LDG_LIKELY(LDG_RD_ONCE(*waiters) == 0)) { return; }
+
+    LDG_FETCH_ADD(*seq, 1);
+}
+
+static uint32_t shmq_deadline_get(uint64_t timeout_ns, uint64_t *deadline_ns)
+{
+    uint64_t now_ns = 0;
+
+    *deadline_ns = UINT64_MAX;
+
+    if (timeout_ns == LDG_FUTEX_WAIT_INFINITE) { return LDG_ERR_AOK; }
+
+    now_ns = shmq_monotonic_ns_get();
+    if (LDG_UNLIKELY(now_ns == UINT64_MAX)) { return LDG_ERR_FUNC_ARG_INVALID; }
+
+    if (LDG_LIKELY(timeout_ns < UINT64_MAX - now_ns)) { *deadline_ns = now_ns + timeout_ns; }
+
+    return LDG_ERR_AOK;
+}
+
+// registered on waiters, with the key read after, so a notify between the failed attempt and the nap changes seq
+static uint32_t shmq_park(uint32_t *seq, uint32_t key, uint64_t deadline_ns, uint32_t *round)
+{
+    if (LDG_LOAD_ACQUIRE(*seq) != key) { return LDG_ERR_AOK; }
+
+    if (deadline_ns != UINT64_MAX && shmq_monotonic_ns_get() >= deadline_ns) { return LDG_ERR_TIMEOUT; }
+
+    if (*round < SHMQ_PARK_YIELD_CUNT) { (*round)++; SwitchToThread(); }
+    else { Sleep(1); }
+
+    return LDG_ERR_AOK;
+}
+
+// segment
+
+// kind is LDG_SHMQ_SPSC or LDG_SHMQ_MPMC; cap must be a power of two. EXISTS if the name is taken
+uint32_t ldg_shmq_create(ldg_shmq_t *q, const char *name, uint32_t kind, uint64_t item_size, uint64_t cap)
+{
+    ldg_shmq_hdr_t *hdr = 0x0;
+    ldg_mpmc_slot_t *slot = 0x0;
+    void *map = 0x0;
+    HANDLE h = 0x0;
+    uint64_t slot_size = 0;
+    uint64_t seg_size = 0;
+    uint64_t i = 0;
+    uint32_t ret = 0;
+
+    if (LDG_UNLIKELY(!q || !name)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    if (LDG_UNLIKELY(memset(q, 0, sizeof(ldg_shmq_t)) != q)) { return LDG_ERR_MEM_BAD; }
+
+    if (LDG_UNLIKELY(kind > LDG_SHMQ_MPMC || item_size == 0 || !shmq_cap_pow2_is(cap))) { return LDG_ERR_FUNC_ARG_INVALID; }
+
+    ret = shmq_layout_get(kind, item_size, cap, &slot_size, &seg_size);
+    if (LDG_UNLIKELY(ret != LDG_ERR_AOK)) { return ret; }
+
+    ret = shmq_name_copy(q, name);
+    if (LDG_UNLIKELY(ret != LDG_ERR_AOK)) { return ret; }
+
+    h = CreateFileMappingA(INVALID_HANDLE_VALUE, 0x0, PAGE_READWRITE, (DWORD)(seg_size >> 32), (DWORD)seg_size, name);
+    if (LDG_UNLIKELY(!h)) { return LDG_ERR_ALLOC_NULL; }
+
+    if (LDG_UNLIKELY(GetLastError() == ERROR_ALREADY_EXISTS)) { CloseHandle(h); return LDG_ERR_EXISTS; }
+
+    map = MapViewOfFile(h, FILE_MAP_ALL_ACCESS, 0, 0, (SIZE_T)seg_size);
+    if (LDG_UNLIKELY(!map)) { CloseHandle(h); return LDG_ERR_ALLOC_NULL; }
+
+    // a fresh pagefile-backed section reads as zeroes, so only the non-zero fields need writing
+    hdr = (ldg_shmq_hdr_t *)map;
+    hdr->version = LDG_SHMQ_VERSION;
+    hdr->kind = kind;
+    hdr->item_size = item_size;
+    hdr->slot_size = slot_size;
+    hdr->cap = cap;
+    hdr->mask = cap - 1;
+    hdr->data_off = sizeof(ldg_shmq_hdr_t);
+    hdr->seg_size = seg_size;
+
+    q->hdr = hdr;
+    q->data = (uint8_t *)map + sizeof(ldg_shmq_hdr_t);
+    q->kind = kind;
+    q->item_size = item_size;
+    q->slot_size = slot_size;
+    q->cap = cap;
+    q->mask = cap - 1;
+
+    if (kind == LDG_SHMQ_MPMC)
+    {
+        for (i = 0; i < cap; i++)
+        {
+            slot = (ldg_mpmc_slot_t *)shmq_slot_get(q, i);
+            LDG_WR_ONCE(slot->seq, i);
+        }
+    }
+
+    // attach() treats the segment as ready only once it sees the magic
+    LDG_STORE_RELEASE(hdr->magic, LDG_SHMQ_MAGIC);
+
+    q->handle = (void *)h;
+    q->map_size = seg_size;
+    q->is_owner = 1;
+    q->is_init = 1;
+
+    return LDG_ERR_AOK;
+}
+
+// NOT_FOUND if no such segment; AGAIN while its creator is still initializing it
+uint32_t ldg_shmq_attach(ldg_shmq_t *q, const char *name)
+{
+    MEMORY_BASIC_INFORMATION mbi = { 0 };
+    void *map = 0x0;
+    HANDLE h = 0x0;
+    uint32_t ret = 0;
+
+    if (LDG_UNLIKELY(!q || !name)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    if (LDG_UNLIKELY(memset(q, 0, sizeof(ldg_shmq_t)) != q)) { return LDG_ERR_MEM_BAD; }
+
+    ret = shmq_name_copy(q, name);
+    if (LDG_UNLIKELY(ret != LDG_ERR_AOK)) { return ret; }
+
+    h = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, name);
+    if (LDG_UNLIKELY(!h)) { return (GetLastError() == ERROR_FILE_NOT_FOUND) ? LDG_ERR_NOT_FOUND : LDG_ERR_DENIED; }
+
+    // a zero length maps the whole section; its size is only known from the view
+    map = MapViewOfFile(h, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+    if (LDG_UNLIKELY(!map)) { CloseHandle(h); return LDG_ERR_ALLOC_NULL; }
+
+    if (LDG_UNLIKELY(VirtualQuery(map, &mbi, sizeof(mbi)) == 0 || (uint64_t)mbi.RegionSize < sizeof(ldg_shmq_hdr_t)))
+    {
+        UnmapViewOfFile(map);
+        CloseHandle(h);
+        return LDG_ERR_INVALID;
+    }
+
+    ret = shmq_hdr_load(q, (const ldg_shmq_hdr_t *)map, (uint64_t)mbi.RegionSize);
+    if (ret != LDG_ERR_AOK) { UnmapViewOfFile(map); CloseHandle(h); return ret; }
+
+    q->hdr = (ldg_shmq_hdr_t *)map;
+    q->data = (uint8_t *)map + sizeof(ldg_shmq_hdr_t);
+    q->handle = (void *)h;
+    q->map_size = (uint64_t)mbi.RegionSize;
+    q->is_owner = 0;
+    q->is_init = 1;
+
+    return LDG_ERR_AOK;
+}
+
+// the name lives until the last handle onto the section is closed, whoever created it
+uint32_t ldg_shmq_detach(ldg_shmq_t *q)
+{
+    uint32_t ret = LDG_ERR_AOK;
+
+    if (LDG_UNLIKELY(!q || !q->is_init)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    if (LDG_UNLIKELY(!UnmapViewOfFile(q->hdr))) { ret = LDG_ERR_FUNC_ARG_INVALID; }
+
+    if (LDG_UNLIKELY(!CloseHandle((HANDLE)q->handle) && ret == LDG_ERR_AOK)) { ret = LDG_ERR_FUNC_ARG_INVALID; }
+
+    q->handle = 0x0;
+
+    q->hdr = 0x0;
+    q->data = 0x0;
+    q->is_init = 0;
+
+    return ret;
+}
+
+// ring
+
+uint32_t ldg_shmq_push(ldg_shmq_t *q, const void *item)
+{
+    ldg_shmq_hdr_t *hdr = 0x0;
+    ldg_mpmc_slot_t *slot = 0x0;
+    uint64_t pos = 0;
+    int64_t dif = 0;
+    uint32_t spin = 0;
+
+    if (LDG_UNLIKELY(!q || !item)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    if (LDG_UNLIKELY(!q->is_init)) { return LDG_ERR_NOT_INIT; }
+
+    hdr = q->hdr;
+
+    if (q->kind == LDG_SHMQ_SPSC)
+    {
+        pos = LDG_RD_ONCE(hdr->hd);
+        if (pos - LDG_LOAD_ACQUIRE(hdr->tail) >= q->cap) { return LDG_ERR_FULL; }
+
+        if (LDG_UNLIKELY(ldg_mem_secure_copy(shmq_slot_get(q, pos), item, q->item_size) != LDG_ERR_AOK)) { return LDG_ERR_MEM_BAD; }
+
+        LDG_STORE_RELEASE(hdr->hd, pos + 1);
+        shmq_notify(&hdr->data_seq, &hdr->data_waiters);
+
+        return LDG_ERR_AOK;
+    }
+
+    pos = LDG_RD_ONCE(hdr->hd);
+
+    // the peer owns seq and the cursors too; a slot it corrupted or stalled on must not hang this process
+    for (spin = 0; spin < SHMQ_MAX_SPIN; spin++)
+    {
+        slot = (ldg_mpmc_slot_t *)shmq_slot_get(q, pos);
+        dif = (int64_t)(LDG_LOAD_ACQUIRE(slot->seq) - pos);
+
+        if (dif == 0 && LDG_CAS(&hdr->hd, &pos, pos + 1)) { break; }
+        if (dif < 0) { return LDG_ERR_FULL; }
+        if (dif > 0) { LDG_PAUSE; pos = LDG_RD_ONCE(hdr->hd); }
+    }
+
+    if (LDG_UNLIKELY(spin >= SHMQ_MAX_SPIN)) { return LDG_ERR_AGAIN; }
+
+    if (LDG_UNLIKELY(ldg_mem_secure_copy(slot->data, item, q->item_size) != LDG_ERR_AOK)) { return LDG_ERR_MEM_BAD; }
+
+    LDG_STORE_RELEASE(slot->seq, pos + 1);
+    shmq_notify(&hdr->data_seq, &hdr->data_waiters);
+
+    return LDG_ERR_AOK;
+}
+
+uint32_t ldg_shmq_pop(ldg_shmq_t *q, void *item_out)
+{
+    ldg_shmq_hdr_t *hdr = 0x0;
+    ldg_mpmc_slot_t *slot = 0x0;
+    uint64_t pos = 0;
+    int64_t dif = 0;
+    uint32_t spin = 0;
+
+    if (LDG_UNLIKELY(!q || !item_out)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    if (LDG_UNLIKELY(!q->is_init)) { return LDG_ERR_NOT_INIT; }
+
+    hdr = q->hdr;
+
+    if (q->kind == LDG_SHMQ_SPSC)
+    {
+        pos = LDG_RD_ONCE(hdr->tail);
+        if (pos == LDG_LOAD_ACQUIRE(hdr->hd)) { return LDG_ERR_EMPTY; }
+
+        if (LDG_UNLIKELY(ldg_mem_secure_copy(item_out, shmq_slot_get(q, pos), q->item_size) != LDG_ERR_AOK)) { return LDG_ERR_MEM_BAD; }
+
+        LDG_STORE_RELEASE(hdr->tail, pos + 1);
+        shmq_notify(&hdr->space_seq, &hdr->space_waiters);
+
+        return LDG_ERR_AOK;
+    }
+
+    pos = LDG_RD_ONCE(hdr->tail);
+
+    // the peer owns seq and the cursors too; a slot it corrupted or stalled on must not hang this process
+    for (spin = 0; spin < SHMQ_MAX_SPIN; spin++)
+    {
+        slot = (ldg_mpmc_slot_t *)shmq_slot_get(q, pos);
+        dif = (int64_t)(LDG_LOAD_ACQUIRE(slot->seq) - (pos + 1));
+
+        if (dif == 0 && LDG_CAS(&hdr->tail, &pos, pos + 1)) { break; }
+        if (dif < 0) { return LDG_ERR_EMPTY; }
+        if (dif > 0) { LDG_PAUSE; pos = LDG_RD_ONCE(hdr->tail); }
+    }
+
+    if (LDG_UNLIKELY(spin >= SHMQ_MAX_SPIN)) { return LDG_ERR_AGAIN; }
+
+    if (LDG_UNLIKELY(ldg_mem_secure_copy(item_out, slot->data, q->item_size) != LDG_ERR_AOK)) { return LDG_ERR_MEM_BAD; }
+
+    LDG_STORE_RELEASE(slot->seq, pos + q->cap);
+    shmq_notify(&hdr->space_seq, &hdr->space_waiters);
+
+    return LDG_ERR_AOK;
+}
+
+// timeout_ns is relative; LDG_FUTEX_WAIT_INFINITE waits forever
+uint32_t ldg_shmq_push_wait(ldg_shmq_t *q, const void *item, uint64_t timeout_ns)
+{
+    uint64_t deadline_ns = 0;
+    uint32_t round = 0;
+    uint32_t key = 0;
+    uint32_t ret = 0;
+
+    ret = ldg_shmq_push(q, item);
+    if (ret != LDG_ERR_FULL) { return ret; }
+
+    ret = shmq_deadline_get(timeout_ns, &deadline_ns);
+    if (LDG_UNLIKELY(ret != LDG_ERR_AOK)) { return ret; }
+
+    do
+    {
+        LDG_FETCH_ADD(q->hdr->space_waiters, 1);
+        key = LDG_LOAD_ACQUIRE(q->hdr->space_seq);
+
+        ret = ldg_shmq_push(q, item);
+        if (ret == LDG_ERR_FULL && shmq_park(&q->hdr->space_seq, key, deadline_ns, &round) == LDG_ERR_TIMEOUT) { ret = LDG_ERR_TIMEOUT; }
+
+        LDG_FETCH_SUB(q->hdr->space_waiters, 1);
+    } while (ret == LDG_ERR_FULL);
+
+    return ret;
+}
+
+uint32_t ldg_shmq_pop_wait(ldg_shmq_t *q, void *item_out, uint64_t timeout_ns)
+{
+    uint64_t deadline_ns = 0;
+    uint32_t round = 0;
+    uint32_t key = 0;
+    uint32_t ret = 0;
+
+    ret = ldg_shmq_pop(q, item_out);
+    if (ret != LDG_ERR_EMPTY) { return ret; }
+
+    ret = shmq_deadline_get(timeout_ns, &deadline_ns);
+    if (LDG_UNLIKELY(ret != LDG_ERR_AOK)) { return ret; }
+
+    do
+    {
+        LDG_FETCH_ADD(q->hdr->data_waiters, 1);
+        key = LDG_LOAD_ACQUIRE(q->hdr->data_seq);
+
+        ret = ldg_shmq_pop(q, item_out);
+        if (ret == LDG_ERR_EMPTY && shmq_park(&q->hdr->data_seq, key, deadline_ns, &round) == LDG_ERR_TIMEOUT) { ret = LDG_ERR_TIMEOUT; }
+
+        LDG_FETCH_SUB(q->hdr->data_waiters, 1);
+    } while (ret == LDG_ERR_EMPTY);
+
+    return ret;
+}
+
+uint64_t ldg_shmq_cunt_get(const ldg_shmq_t *q)
+{
+    uint64_t hd = 0;
+    uint64_t tail = 0;
+
+    if (LDG_UNLIKELY(!q || !q->is_init)) { return UINT64_MAX; }
+
+    tail = LDG_LOAD_ACQUIRE(q->hdr->tail);
+    hd = LDG_LOAD_ACQUIRE(q->hdr->hd);
+
+    return (hd >= tail) ? hd - tail : 0;
+}
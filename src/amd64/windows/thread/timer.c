@@ -0,0 +1,482 @@
+#include <string.h>
+#include <windows.h>
+
+#include <dangling/thread/timer.h>
+#include <dangling/thread/pool.h>
+#include <dangling/thread/sync.h>
+#include <dangling/core/err.h>
+#include <dangling/mem/alloc.h>
+#include <dangling/core/macros.h>
+#include <dangling/arch/amd64/atomic.h>
+#include <dangling/arch/amd64/fence.h>
+
+#define TIMER_WHEEL_SLOT_MASK (LDG_TIMER_WHEEL_SLOTS - 1)
+
+typedef struct ldg_timer_fire
+{
+    ldg_thread_pool_worker_func_t func;
+    void *arg;
+} ldg_timer_fire_t;
+
+static uint64_t timer_monotonic_ns_get(void)
+{
+    LARGE_INTEGER freq = { 0 };
+    LARGE_INTEGER ctr = { 0 };
+
+    if (LDG_UNLIKELY(!QueryPerformanceFrequency(&freq) || !QueryPerformanceCounter(&ctr))) { return 0; }
+
+    // split so the multiply cannot overflow at high counter frequencies
+    return (uint64_t)(ctr.QuadPart / freq.QuadPart) * LDG_NS_PER_SEC + (uint64_t)(ctr.QuadPart % freq.QuadPart) * LDG_NS_PER_SEC / (uint64_t)freq.QuadPart;
+}
+
+// tick k covers [origin + k * tick_ns, origin + (k + 1) * tick_ns)
+static uint64_t timer_wheel_tick_get(const ldg_timer_wheel_t *w, uint64_t ns)
+{
+    if (ns <= w->origin_ns) { return 0; }
+
+    return (ns - w->origin_ns) / w->tick_ns;
+}
+
+// the level is the highest 6-bit digit where expire and now differ, the slot is expire's digit there;
+// a timer then drops a level each time now reaches its prefix, so every step is O(1)
+static void timer_wheel_link(ldg_timer_wheel_t *w, ldg_timer_t *t)
+{
+    uint64_t diff = t->expire ^ w->now;
+    uint32_t lvl = 0;
+    uint32_t slot = 0;
+
+    if (diff) { lvl = (uint32_t)(63 - __builtin_clzll(diff)) / LDG_TIMER_WHEEL_LVL_BITS; }
+
+    if (lvl < LDG_TIMER_WHEEL_LVLS) { slot = (uint32_t)(t->expire >> (lvl * LDG_TIMER_WHEEL_LVL_BITS)) & TIMER_WHEEL_SLOT_MASK; }
+    else
+    {
+        // beyond the top level: park in the slot the top level reaches last, re-placed when it cascades
+        lvl = LDG_TIMER_WHEEL_LVLS - 1;
+        slot = (uint32_t)((w->now >> (lvl * LDG_TIMER_WHEEL_LVL_BITS)) - 1) & TIMER_WHEEL_SLOT_MASK;
+    }
+
+    t->lvl = (uint8_t)lvl;
+    t->slot = (uint8_t)slot;
+    t->prev = 0x0;
+    t->next = w->slots[lvl][slot];
+
+    if (t->next) { t->next->prev = t; }
+
+    w->slots[lvl][slot] = t;
+    w->occupied[lvl] |= (uint64_t)1 << slot;
+}
+
+static void timer_wheel_unlink(ldg_timer_wheel_t *w, ldg_timer_t *t)
+{
+    if (t->prev) { t->prev->next = t->next; }
+    else { w->slots[t->lvl][t->slot] = t->next; }
+
+    if (t->next) { t->next->prev = t->prev; }
+
+    if (!w->slots[t->lvl][t->slot]) { w->occupied[t->lvl] &= ~((uint64_t)1 << t->slot); }
+
+    t->prev = 0x0;
+    t->next = 0x0;
+}
+
+// first tick at which anything fires or cascades; UINT64_MAX when the wheel is empty
+static uint64_t timer_wheel_next_tick(const ldg_timer_wheel_t *w)
+{
+    uint64_t best = UINT64_MAX;
+    uint64_t occ = 0;
+    uint64_t base = 0;
+    uint64_t tick = 0;
+    uint32_t shift = 0;
+    uint32_t cur = 0;
+    uint32_t off = 0;
+    uint32_t lvl = 0;
+
+    for (lvl = 0; lvl < LDG_TIMER_WHEEL_LVLS; lvl++)
+    {
+        occ = w->occupied[lvl];
+        if (!occ) { continue; }
+
+        shift = lvl * LDG_TIMER_WHEEL_LVL_BITS;
+        cur = (uint32_t)(w->now >> shift) & TIMER_WHEEL_SLOT_MASK;
+
+        // rotate so bit 0 is the current slot; the distance to the first set bit is the slot offset
+        if (cur) { occ = (occ >> cur) | (occ << (LDG_TIMER_WHEEL_SLOTS - cur)); }
+        off = (uint32_t)__builtin_ctzll(occ);
+
+        base = (w->now >> (shift + LDG_TIMER_WHEEL_LVL_BITS)) << (shift + LDG_TIMER_WHEEL_LVL_BITS);
+        tick = base + ((uint64_t)(cur + off) << shift);
+
+        if (tick < w->now) { tick = w->now; }
+
+        if (tick < best) { best = tick; }
+    }
+
+    return best;
+}
+
+static void timer_wheel_cascade(ldg_timer_wheel_t *w, uint32_t lvl)
+{
+    ldg_timer_t *t = 0x0;
+    ldg_timer_t *next = 0x0;
+    uint32_t slot = (uint32_t)(w->now >> (lvl * LDG_TIMER_WHEEL_LVL_BITS)) & TIMER_WHEEL_SLOT_MASK;
+
+    t = w->slots[lvl][slot];
+    w->slots[lvl][slot] = 0x0;
+    w->occupied[lvl] &= ~((uint64_t)1 << slot);
+
+    for (; t; t = next)
+    {
+        next = t->next;
+        timer_wheel_link(w, t);
+    }
+}
+
+// a failed submit (pool already shut down) still runs the callback rather than losing it
+static void timer_wheel_dispatch(ldg_timer_wheel_t *w, const ldg_timer_fire_t *batch, uint32_t n)
+{
+    uint32_t i = 0;
+
+    for (i = 0; i < n; i++)
+    {
+        if (w->pool && ldg_thread_pool_submit(w->pool, batch[i].func, batch[i].arg) == LDG_ERR_AOK) { continue; }
+
+        batch[i].func(batch[i].arg);
+    }
+}
+
+// runs every tick before the current one; callbacks are dispatched outside the lock in batches
+static uint64_t timer_wheel_run(ldg_timer_wheel_t *w, uint64_t target)
+{
+    ldg_timer_fire_t batch[LDG_TIMER_WHEEL_BATCH];
+    ldg_timer_t *t = 0x0;
+    uint64_t next = 0;
+    uint64_t fired = 0;
+    uint32_t lvl = 0;
+    uint32_t slot = 0;
+    uint32_t n = 0;
+
+    ldg_mut_lock(&w->mut);
+
+    while (w->now < target)
+    {
+        next = timer_wheel_next_tick(w);
+
+        // nothing due in between; jump instead of walking empty ticks
+        if (next >= target) { w->now = target; break; }
+
+        w->now = next;
+
+        for (lvl = LDG_TIMER_WHEEL_LVLS - 1; lvl > 0; lvl--)
+        {
+            if ((w->now & (((uint64_t)1 << (lvl * LDG_TIMER_WHEEL_LVL_BITS)) - 1)) == 0) { timer_wheel_cascade(w, lvl); }
+        }
+
+        slot = (uint32_t)w->now & TIMER_WHEEL_SLOT_MASK;
+
+        // arms that land on this tick while we are unlocked join the same slot and go out in this loop
+        while (w->slots[0][slot])
+        {
+            for (n = 0; n < LDG_TIMER_WHEEL_BATCH && (t = w->slots[0][slot]) != 0x0; n++)
+            {
+                timer_wheel_unlink(w, t);
+
+                batch[n].func = t->func;
+                batch[n].arg = t->arg;
+
+                // a driver that fell behind gets one call per periodic timer, not a burst of missed periods
+                if (t->period)
+                {
+                    t->expire = w->now + t->period;
+                    if (t->expire < target) { t->expire = target; }
+
+                    timer_wheel_link(w, t);
+                }
+                else
+                {
+                    t->state = LDG_TIMER_IDLE;
+                    w->pending--;
+                }
+            }
+
+            fired += n;
+
+            ldg_mut_unlock(&w->mut);
+            timer_wheel_dispatch(w, batch, n);
+            ldg_mut_lock(&w->mut);
+        }
+
+        w->now++;
+    }
+
+    ldg_mut_unlock(&w->mut);
+
+    return fired;
+}
+
+// sleeps until the next due tick; an arm earlier than that bumps seq and wakes it
+static DWORD WINAPI timer_wheel_thread_enter(LPVOID arg)
+{
+    ldg_timer_wheel_t *w = (ldg_timer_wheel_t *)arg;
+    uint64_t next = 0;
+    uint64_t now_ns = 0;
+    uint64_t due_ns = 0;
+    uint64_t wait_ns = 0;
+    uint32_t seq = 0;
+
+    while (!LDG_RD_ONCE(w->should_stop))
+    {
+        seq = LDG_LOAD_ACQUIRE(w->seq);
+
+        timer_wheel_run(w, timer_wheel_tick_get(w, timer_monotonic_ns_get()) + 1);
+
+        ldg_mut_lock(&w->mut);
+        next = timer_wheel_next_tick(w);
+        w->wake_tick = next;
+        ldg_mut_unlock(&w->mut);
+
+        wait_ns = LDG_FUTEX_WAIT_INFINITE;
+
+        if (next != UINT64_MAX)
+        {
+            now_ns = timer_monotonic_ns_get();
+            due_ns = w->origin_ns + next * w->tick_ns;
+            wait_ns = (due_ns > now_ns) ? due_ns - now_ns : 0;
+        }
+
+        if (wait_ns) { ldg_futex_wait(&w->seq, seq, wait_ns, 0); }
+    }
+
+    return 0;
+}
+
+// pool 0x0 runs callbacks on the driving thread; tick_ns 0 takes LDG_TIMER_WHEEL_TICK_NS
+uint32_t ldg_timer_wheel_create(ldg_thread_pool_t *pool, uint64_t tick_ns, ldg_timer_wheel_t **out)
+{
+    ldg_timer_wheel_t *w = 0x0;
+    void *tmp = 0x0;
+    uint32_t ret = 0;
+
+    if (LDG_UNLIKELY(!out)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    *out = 0x0;
+
+    if (LDG_UNLIKELY(pool && !pool->is_init)) { return LDG_ERR_FUNC_ARG_INVALID; }
+
+    ret = ldg_mem_alloc((uint64_t)sizeof(ldg_timer_wheel_t), &tmp);
+    if (LDG_UNLIKELY(ret != LDG_ERR_AOK)) { return ret; }
+
+    w = (ldg_timer_wheel_t *)tmp;
+
+    if (LDG_UNLIKELY(memset(w, 0, sizeof(ldg_timer_wheel_t)) != w)) { ldg_mem_dealloc(w); return LDG_ERR_MEM_BAD; }
+
+    ret = ldg_mut_init(&w->mut, 0);
+    if (LDG_UNLIKELY(ret != LDG_ERR_AOK)) { ldg_mem_dealloc(w); return ret; }
+
+    w->pool = pool;
+    w->tick_ns = tick_ns ? tick_ns : LDG_TIMER_WHEEL_TICK_NS;
+    w->origin_ns = timer_monotonic_ns_get();
+    w->wake_tick = UINT64_MAX;
+
+    *out = w;
+
+    return LDG_ERR_AOK;
+}
+
+// pending timers are left idle; they stay owned by the caller
+uint32_t ldg_timer_wheel_destroy(ldg_timer_wheel_t **w)
+{
+    ldg_timer_t *t = 0x0;
+    uint32_t lvl = 0;
+    uint32_t slot = 0;
+    uint32_t ret = 0;
+
+    if (LDG_UNLIKELY(!w || !*w)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    ret = ldg_timer_wheel_stop(*w);
+
+    for (lvl = 0; lvl < LDG_TIMER_WHEEL_LVLS; lvl++)
+    {
+        for (slot = 0; slot < LDG_TIMER_WHEEL_SLOTS; slot++)
+        {
+            for (t = (*w)->slots[lvl][slot]; t; t = t->next) { t->state = LDG_TIMER_IDLE; }
+        }
+    }
+
+    ldg_mut_destroy(&(*w)->mut);
+    ldg_mem_dealloc(*w);
+    *w = 0x0;
+
+    return ret;
+}
+
+uint32_t ldg_timer_wheel_start(ldg_timer_wheel_t *w)
+{
+    HANDLE h = 0x0;
+    uint8_t expected = 0;
+
+    LDG_BOOL_ASSERT(sizeof(HANDLE) <= sizeof(uint64_t));
+
+    if (LDG_UNLIKELY(!w)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    if (LDG_UNLIKELY(!LDG_CAS(&w->is_running, &expected, 1))) { return LDG_ERR_BUSY; }
+
+    LDG_WR_ONCE(w->should_stop, 0);
+
+    h = CreateThread(0x0, 0, timer_wheel_thread_enter, w, 0, 0x0);
+    if (LDG_UNLIKELY(h == 0x0))
+    {
+        LDG_WR_ONCE(w->is_running, 0);
+        return LDG_ERR_FUNC_ARG_INVALID;
+    }
+
+    w->thread = (uint64_t)h;
+
+    return LDG_ERR_AOK;
+}
+
+uint32_t ldg_timer_wheel_stop(ldg_timer_wheel_t *w)
+{
+    uint32_t ret = LDG_ERR_AOK;
+
+    if (LDG_UNLIKELY(!w)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    if (!LDG_RD_ONCE(w->is_running)) { return LDG_ERR_AOK; }
+
+    LDG_WR_ONCE(w->should_stop, 1);
+    LDG_FETCH_ADD(w->seq, 1);
+    ldg_futex_wake(&w->seq, 1, 0);
+
+    if (LDG_UNLIKELY(WaitForSingleObject((HANDLE)w->thread, INFINITE) != WAIT_OBJECT_0)) { ret = LDG_ERR_FUNC_ARG_INVALID; }
+
+    CloseHandle((HANDLE)w->thread);
+
+    w->thread = 0;
+    LDG_WR_ONCE(w->is_running, 0);
+
+    return ret;
+}
+
+// for callers driving the wheel from their own loop (epoll timeout, timerfd); BUSY while the tick thread runs
+uint32_t ldg_timer_wheel_advance(ldg_timer_wheel_t *w, uint64_t *fired)
+{
+    uint64_t n = 0;
+
+    if (LDG_UNLIKELY(!w)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    if (LDG_UNLIKELY(LDG_RD_ONCE(w->is_running))) { return LDG_ERR_BUSY; }
+
+    n = timer_wheel_run(w, timer_wheel_tick_get(w, timer_monotonic_ns_get()) + 1);
+
+    if (fired) { *fired = n; }
+
+    return LDG_ERR_AOK;
+}
+
+// ns until the next tick with work, 0 when already due; NOT_FOUND and UINT64_MAX when nothing is armed
+uint32_t ldg_timer_wheel_next_get(ldg_timer_wheel_t *w, uint64_t *delay_ns)
+{
+    uint64_t next = 0;
+    uint64_t now_ns = 0;
+    uint64_t due_ns = 0;
+
+    if (LDG_UNLIKELY(!w || !delay_ns)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    ldg_mut_lock(&w->mut);
+    next = timer_wheel_next_tick(w);
+    ldg_mut_unlock(&w->mut);
+
+    if (next == UINT64_MAX) { *delay_ns = UINT64_MAX; return LDG_ERR_NOT_FOUND; }
+
+    now_ns = timer_monotonic_ns_get();
+    due_ns = w->origin_ns + next * w->tick_ns;
+
+    *delay_ns = (due_ns > now_ns) ? due_ns - now_ns : 0;
+
+    return LDG_ERR_AOK;
+}
+
+uint64_t ldg_timer_wheel_cunt_get(ldg_timer_wheel_t *w)
+{
+    if (LDG_UNLIKELY(!w)) { return UINT64_MAX; }
+
+    return LDG_RD_ONCE(w->pending);
+}
+
+// O(1); re-arming a pending timer moves it, which is the cheap path for idle-connection timeouts.
+// never fires early: the deadline rounds up to a whole tick
+uint32_t ldg_timer_arm(ldg_timer_wheel_t *w, ldg_timer_t *t, uint64_t delay_ns, uint64_t period_ns, ldg_thread_pool_worker_func_t func, void *arg)
+{
+    uint64_t due_ns = 0;
+    uint64_t expire = 0;
+    uint8_t wake = 0;
+
+    if (LDG_UNLIKELY(!w || !t || !func)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    if (LDG_UNLIKELY(t->state == LDG_TIMER_PENDING && t->wheel != w)) { return LDG_ERR_BUSY; }
+
+    due_ns = timer_monotonic_ns_get();
+    due_ns = (delay_ns > UINT64_MAX - due_ns) ? UINT64_MAX : due_ns + delay_ns;
+
+    expire = timer_wheel_tick_get(w, due_ns);
+    if (due_ns > w->origin_ns && (due_ns - w->origin_ns) % w->tick_ns) { expire++; }
+
+    ldg_mut_lock(&w->mut);
+
+    if (t->state == LDG_TIMER_PENDING) { timer_wheel_unlink(w, t); }
+    else { w->pending++; }
+
+    t->func = func;
+    t->arg = arg;
+    t->wheel = w;
+    t->period = period_ns ? (period_ns + w->tick_ns - 1) / w->tick_ns : 0;
+    t->expire = (expire < w->now) ? w->now : expire;
+    t->state = LDG_TIMER_PENDING;
+
+    timer_wheel_link(w, t);
+
+    if (t->expire < w->wake_tick)
+    {
+        w->wake_tick = t->expire;
+        wake = 1;
+    }
+
+    ldg_mut_unlock(&w->mut);
+
+    // only an arm that beats the tick thread's current sleep pays for a wakeup
+    if (wake && LDG_RD_ONCE(w->is_running))
+    {
+        LDG_FETCH_ADD(w->seq, 1);
+        ldg_futex_wake(&w->seq, 1, 0);
+    }
+
+    return LDG_ERR_AOK;
+}
+
+// NOT_FOUND once the timer has fired or was never armed; a periodic callback already handed off may still run
+uint32_t ldg_timer_cancel(ldg_timer_wheel_t *w, ldg_timer_t *t)
+{
+    uint32_t ret = LDG_ERR_AOK;
+
+    if (LDG_UNLIKELY(!w || !t)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    ldg_mut_lock(&w->mut);
+
+    if (t->state != LDG_TIMER_PENDING || t->wheel != w) { ret = LDG_ERR_NOT_FOUND; }
+    else
+    {
+        timer_wheel_unlink(w, t);
+        t->state = LDG_TIMER_IDLE;
+        w->pending--;
+    }
+
+    ldg_mut_unlock(&w->mut);
+
+    return ret;
+}
+
+uint8_t ldg_timer_pending_is(const ldg_timer_t *t)
+{
+    if (LDG_UNLIKELY(!t)) { return LDG_TRUTH_FALSE; }
+
+    return LDG_RD_ONCE(t->state) == LDG_TIMER_PENDING;
+}
@@ -4,6 +4,12 @@
 #include <dangling/thread/yield.h>
 #include <dangling/core/err.h>
 #include <dangling/core/macros.h>
+#include <dangling/arch/amd64/tsc.h>
+#include <dangling/arch/amd64/atomic.h>
+#include <dangling/arch/amd64/fence.h>
+
+#define THREAD_YIELD_SLACK_MIN_NS 20000
+#define THREAD_YIELD_SLACK_MAX_NS (16 * (int64_t)LDG_NS_PER_MS)
 
 uint32_t ldg_thread_yield(uint64_t ns)
 {
@@ -18,3 +24,80 @@ uint32_t ldg_thread_yield(uint64_t ns)
 
     return LDG_ERR_AOK;
 }
+
+// precise
+
+// slack the os needs to wake us late by; spins cover it, so keep it tight but never let one bad wakeup blow it up
+static int64_t thread_yield_slack_ns = (int64_t)LDG_THREAD_YIELD_SLACK_NS;
+
+static uint64_t thread_yield_cycles(const ldg_tsc_ctx_t *tsc, uint64_t ns)
+{
+    return (uint64_t)((double)ns * (double)tsc->freq / (double)LDG_NS_PER_SEC);
+}
+
+static uint64_t thread_yield_ns(const ldg_tsc_ctx_t *tsc, uint64_t cycles)
+{
+    return (uint64_t)((double)cycles * tsc->freq_inv * (double)LDG_NS_PER_SEC);
+}
+
+// twice the observed overshoot, moved an eighth of the way per sleep
+static void thread_yield_slack_update(uint64_t overshoot_ns)
+{
+    int64_t slack = LDG_RD_ONCE(thread_yield_slack_ns);
+    int64_t target = (int64_t)(overshoot_ns > (uint64_t)THREAD_YIELD_SLACK_MAX_NS ? THREAD_YIELD_SLACK_MAX_NS : overshoot_ns) * 2;
+
+    slack += (target - slack) / 8;
+    if (slack < THREAD_YIELD_SLACK_MIN_NS) { slack = THREAD_YIELD_SLACK_MIN_NS; }
+    if (slack > THREAD_YIELD_SLACK_MAX_NS) { slack = THREAD_YIELD_SLACK_MAX_NS; }
+
+    LDG_WR_ONCE(thread_yield_slack_ns, slack);
+}
+
+uint32_t ldg_thread_yield_precise(const ldg_tsc_ctx_t *tsc, uint64_t ns)
+{
+    if (LDG_UNLIKELY(!tsc)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    if (LDG_UNLIKELY(!tsc->is_calibrated)) { return LDG_ERR_TIME_NOT_CALIBRATED; }
+
+    if (ns == 0) { return LDG_ERR_AOK; }
+
+    return ldg_thread_yield_until(tsc, ldg_tsc_sample(0x0) + thread_yield_cycles(tsc, ns));
+}
+
+// bulk of the wait in Sleep, the last slack_ns spinning on the tsc; burns a cpu for that tail.
+// deadline_tsc is absolute, so a pacing loop that adds its period each round does not drift.
+// Sleep only has ms granularity and often wakes a whole timer tick late, so the slack settles far higher than on linux
+uint32_t ldg_thread_yield_until(const ldg_tsc_ctx_t *tsc, uint64_t deadline_tsc)
+{
+    uint64_t now = 0;
+    uint64_t left_ns = 0;
+    uint64_t ms = 0;
+    uint64_t wake_tsc = 0;
+    int64_t slack = 0;
+
+    if (LDG_UNLIKELY(!tsc)) { return LDG_ERR_FUNC_ARG_NULL; }
+
+    if (LDG_UNLIKELY(!tsc->is_calibrated)) { return LDG_ERR_TIME_NOT_CALIBRATED; }
+
+    now = ldg_tsc_sample(0x0);
+    if (now >= deadline_tsc) { return LDG_ERR_AOK; }
+
+    left_ns = thread_yield_ns(tsc, deadline_tsc - now);
+    slack = LDG_RD_ONCE(thread_yield_slack_ns);
+
+    // rounded down, never up; the spin makes up the rest
+    ms = (left_ns > (uint64_t)slack) ? (left_ns - (uint64_t)slack) / LDG_NS_PER_MS : 0;
+
+    if (ms > 0)
+    {
+        Sleep((uint32_t)(ms > 0xFFFFFFFEu ? 0xFFFFFFFEu : ms));
+
+        wake_tsc = now + thread_yield_cycles(tsc, ms * LDG_NS_PER_MS);
+        now = ldg_tsc_sample(0x0);
+        thread_yield_slack_update(now > wake_tsc ? thread_yield_ns(tsc, now - wake_tsc) : 0);
+    }
+
+    while (ldg_tsc_sample(0x0) < deadline_tsc) { LDG_PAUSE; }
+
+    return LDG_ERR_AOK;
+}